@@ -1,18 +1,33 @@
+#pragma once
 
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+
+#include "../CacheAllocator.h"
 #include "../CachePolicy.h"
 #include "ArcLruPart.h"
 #include "ArcLfuPart.h"
 
 
 namespace MyCache {
-  template <typename Key, typename Value>
+  // Alloc：两部分及其结点、索引的全部内存来源(字节分配器，内部rebind)
+  // Lock：两部分各自使用的锁策略(见 LockPolicy.h)
+  template <typename Key, typename Value, typename Alloc = DefaultAlloc, typename Lock = std::mutex>
   class ArcCache : public CachePolicy<Key, Value> {
+  public:
+    using LruPart = ArcLruPart<Key, Value, Alloc, Lock>;
+    using LfuPart = ArcLfuPart<Key, Value, Alloc, Lock>;
+    using allocator_type = Alloc;
   private:
-    size_t capacity_;
+    std::atomic<size_t> capacity_;
     size_t transformThreshold_;  // 转换门槛值
-    std::shared_ptr<ArcLfuPart<Key, Value>> lfuPart_;
-    std::shared_ptr<ArcLruPart<Key, Value>> lruPart_;
+    Alloc alloc_;
+    AllocUniquePtr<LruPart, Alloc> lruPart_;
+    AllocUniquePtr<LfuPart, Alloc> lfuPart_;
 
+    // 幽灵命中与容量挪动分步进行，每一步都在所属部分的锁内；步与步之间另一部分可能被并发修改，
+    // 只影响自适应的快慢，不破坏各部分自身的一致性
     bool checkGhostCaches(Key key) {
       bool inGhost = false;
       if (lruPart_->checkGhost(key)) {
@@ -30,19 +45,21 @@ namespace MyCache {
     }
 
   public:
-    explicit ArcCache(size_t capacity = 10, size_t transformThreshold = 2)
-      : capacity_(capacity), transformThreshold_(transformThreshold)
-      , lruPart_(std::make_unique<ArcLruPart<Key, Value>>(capacity, transformThreshold))
-      , lfuPart_(std::make_unique<ArcLfuPart<Key, Value>>(capacity, transformThreshold)) {}
+    explicit ArcCache(size_t capacity = 10, size_t transformThreshold = 2, const Alloc& alloc = Alloc())
+      : capacity_(capacity), transformThreshold_(transformThreshold), alloc_(alloc)
+      , lruPart_(allocateUnique<LruPart>(alloc, capacity, transformThreshold, alloc))
+      , lfuPart_(allocateUnique<LfuPart>(alloc, capacity, transformThreshold, alloc)) {}
     
     ~ArcCache() override = default;
 
+    allocator_type get_allocator() const { return alloc_; }
+
     void put(Key key, Value value) override {
       bool inGhost = checkGhostCaches(key);
       if (inGhost) {
         lruPart_->put(key, value);
       } else {
-        if (lruPart_->put(key, value);) {
+        if (lruPart_->put(key, value)) {
           lfuPart_->put(key, value);
         }
       }
@@ -61,10 +78,45 @@ namespace MyCache {
     }
 
     Value get(Key key) override {
-      Value value;
+      Value value{};
       get(key, value);
       return value; 
     }
+
+    // 在线调整容量：两部分都重设为capacity(与构造时一致)，此前自适应挪动的容量随之归零
+    // 缩容超出的结点由后续put/get或 trim 分批淘汰
+    void setCapacity(size_t capacity) {
+      capacity_.store(capacity, std::memory_order_relaxed);
+      lruPart_->setCapacity(capacity);
+      lfuPart_->setCapacity(capacity);
+    }
+
+    size_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    size_t trim(size_t maxEvictions) {
+      size_t evicted = lruPart_->trim(maxEvictions);
+      return evicted + lfuPart_->trim(maxEvictions - evicted);
+    }
+
+    // 两部分都切到延迟维护(见 ArcLruPart::deferMaintenance)，主缓存与幽灵表的超额由后台淘汰
+    void deferMaintenance(MaintenanceExecutor* executor, double highWatermark = kDefaultHighWatermark) {
+      lruPart_->deferMaintenance(executor, highWatermark);
+      lfuPart_->deferMaintenance(executor, highWatermark);
+    }
+
+    size_t maintain(size_t budget) {
+      return trim(budget);
+    }
+
+    // 只读查看：不触发幽灵命中与转换
+    bool peek(Key key, Value& value) {
+      return lruPart_->peek(key, value) || lfuPart_->peek(key, value);
+    }
   };
 
+  // 绑定到 std::pmr::memory_resource 的版本
+  namespace pmr {
+    template<typename Key, typename Value>
+    using ArcCache = MyCache::ArcCache<Key, Value, PmrAlloc>;
+  }
 }
\ No newline at end of file
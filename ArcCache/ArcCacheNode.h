@@ -1,32 +1,17 @@
 #pragma once
 
-#include <memory>
+#include "../KeyIndex.h"
+#include "../SlotStore.h"
 
 namespace MyCache {
+  // ARC结点负载(冷数据)：key与value；链接、访问次数放在 SlotStore 的元数据数组里
+  // 主链表与幽灵链表共用同一个存储，结点转入幽灵链表时只清空value，槽位原地复用
+  // key保存所在索引(主缓存或幽灵表)返回的KeyRef：字符串key驻留在索引里，删除时按引用定位不再哈希
   template <typename Key, typename Value>
-  class ArcNode {
-  private:
-    Key key_;
-    Value value_;
-    size_t accessCount_;
-    std::shared_ptr<ArcNode> prev_;
-    std::shared_ptr<ArcNode> next_;
-
-  public:
-    ArcNode() : accessCount_(1), prev_(nullptr), next_(nullptr) {}
-    ArcNode(Key key, Value value) : key_(key), value_(value), accessCount_(1), prev_(nullptr), next_(nullptr) {}
-
-    // Getters
-    Key getKey() const { return key_; }
-    Value getValue() const { return value_; }
-    size_t getAccessCount() const { return accessCount_; }
-    
-    // setters
-    void setValue(const Value& value) { value_ = value; }
-    void incrementAccessCount() { ++accessCount_; }
-
-    template<typename K, typename V> friend class ArcLruPart;
-    template<typename K, typename V> friend class ArcLfuPart;
+  struct ArcNode {
+    using KeyRef = typename KeyRefTraits<Key>::type;
+    KeyRef key{};
+    Value value{};
   };
 
-}
\ No newline at end of file
+}
@@ -1,137 +1,232 @@
 #pragma once
 
 #include "ArcCacheNode.h"
-#include <unordered_map>
+#include "../CacheAllocator.h"
+#include "../KeyIndex.h"
+#include "../LockPolicy.h"
+#include "../Maintenance.h"
 #include <map>
 #include <mutex>
 
 namespace MyCache {
-  template <typename Key, typename Value>
+  template <typename Key, typename Value, typename Alloc = DefaultAlloc, typename Lock = std::mutex>
   class ArcLfuPart {
   public:
     using NodeType = ArcNode<Key, Value>;
-    using NodePtr = std::shared_ptr<NodeType>;
-    using NodeMap = std::unordered_map<Key, NodePtr>; 
-    using FreqMap = std::map<size_t, std::list<NodePtr>>;
+    using NodeStore = SlotStore<NodeType, Alloc>;
+    using NodeMap = KeyIndex<Key, SlotIndex, Alloc>;  // 整数key走直接寻址，其余走哈希 
+    using FreqBucket = SlotList;  // 同频次结点的链表，结点可O(1)摘除
+    using FreqMap = std::map<size_t, FreqBucket, std::less<size_t>,
+                             RebindAlloc<Alloc, std::pair<const size_t, FreqBucket>>>;
+    using allocator_type = Alloc;
+    using lock_type = Lock;
 
   private:
+    static constexpr size_t kTrimPerOp = 4;  // 缩容后每次put/get顺带淘汰的上限
+
     size_t capacity_;
     size_t ghostCapacity_;
     size_t transformThreshold_;  // 转换门槛值
     size_t minFreq_;
 
-    std::mutex mutex_;
+    Alloc alloc_;
+    Lock mutex_;
+    MaintenanceExecutor* maintenance_ = nullptr;  // 非空时超出容量的主缓存/幽灵结点交给后台淘汰
+    double highWatermark_ = kDefaultHighWatermark;
 
     NodeMap mainCache_;
     NodeMap ghostCache_;
+    NodeStore store_;  // 主缓存与幽灵链表的结点共用，频次记在元数据的count里
     FreqMap freqMap_;
 
-    NodePtr ghostHead_;
-    NodePtr ghostTail_;
+    SlotList ghostList_;  // 头部最旧，尾部最新
   
   public:
-    explicit ArcLfuPart(size_t capacity, size_t transformThreshold)
-      : capacity_(capacity), ghostCapacity_(capacity), transformThreshold_(transformThreshold), minFreq_(0) {
-        initLists();
+    explicit ArcLfuPart(size_t capacity, size_t transformThreshold, const Alloc& alloc = Alloc())
+      : capacity_(capacity), ghostCapacity_(capacity), transformThreshold_(transformThreshold), minFreq_(0)
+      , alloc_(alloc), mainCache_(alloc), ghostCache_(alloc), store_(alloc)
+      , freqMap_(typename FreqMap::allocator_type(alloc)) {
+      mainCache_.sizeHint(capacity);
+      ghostCache_.sizeHint(capacity);
     }
 
+    allocator_type get_allocator() const { return alloc_; }
+
     bool put(Key key, Value value) {
+      std::lock_guard<Lock> lock(mutex_);
       if (capacity_ == 0) {
         return false;
-      } 
-      std::lock_guard<std::mutex> lock(mutex_);
-      auto it = mainCache_.find(key);
-      if (it != mainCache_.end()) {
-        return updateExistingNode(it->second, value);
+      }
+      trimInline();
+      SlotIndex* slot = mainCache_.find(key);
+      if (slot) {
+        return updateExistingNode(*slot, value);
       }
       return addNewNode(key, value);
     }
 
     bool get(Key key, Value& value) {
-      std::lock_guard<std::mutex> lock(mutex_);
-      auto it = mainCache_.find(key);
-      if (it != mainCache_.end()) {
-        updateNodeFrequency(it->second);
-        value = it->second->getValue();
+      std::lock_guard<Lock> lock(mutex_);
+      trimInline();
+      SlotIndex* slot = mainCache_.find(key);
+      if (slot) {
+        updateNodeFrequency(*slot);
+        value = store_.payload(*slot).value;
+        return true;
+      }
+      return false;
+    }
+
+    // 只读查看：不更新访问信息，锁支持共享模式时多个peek可并行
+    bool peek(Key key, Value& value) {
+      SharedGuard<Lock> lock(mutex_);
+      SlotIndex* slot = mainCache_.find(key);
+      if (slot) {
+        value = store_.payload(*slot).value;
         return true;
       }
       return false;
     }
 
-    bool checkGhost(Key, key) {
-      auto it = ghostCache_.find(key);
-      if (it != ghostCache_.end()) {
-        removeFromGhost(it->second);
-        ghostCache_.erase(it);
+    // 幽灵命中时删掉幽灵结点并返回true。与后台维护/trim 并发，须持锁
+    bool checkGhost(Key key) {
+      std::lock_guard<Lock> lock(mutex_);
+      SlotIndex* slot = ghostCache_.find(key);
+      if (slot) {
+        SlotIndex ghost = *slot;
+        removeFromGhost(ghost);
+        ghostCache_.erase(store_.payload(ghost).key);
+        store_.release(ghost);
         return true;
       }
       return false;
     }
 
+    // 在线调整容量(幽灵表容量随之调整)：扩容立即生效，缩容超出的结点由后续put/get或 trim 分批淘汰
+    void setCapacity(size_t capacity) {
+      std::lock_guard<Lock> lock(mutex_);
+      capacity_ = capacity;
+      ghostCapacity_ = capacity;
+      mainCache_.sizeHint(capacity);
+      ghostCache_.sizeHint(capacity);
+      if (maintenance_ && (mainCache_.size() > capacity_ || ghostCache_.size() > ghostCapacity_)) {
+        maintenance_->notify();
+      }
+    }
+
+    // 淘汰至多 maxEvictions 个超出容量的主缓存/幽灵结点，返回实际淘汰数
+    size_t trim(size_t maxEvictions) {
+      std::lock_guard<Lock> lock(mutex_);
+      return trimLocked(maxEvictions);
+    }
+
+    // 延迟维护：executor非空时插入不再同步淘汰主缓存与幽灵表，超出容量的部分由后台调用 maintain 淘汰；
+    // 涨到 容量*highWatermark 时退回同步淘汰。传空指针恢复
+    void deferMaintenance(MaintenanceExecutor* executor, double highWatermark = kDefaultHighWatermark) {
+      std::lock_guard<Lock> lock(mutex_);
+      maintenance_ = executor;
+      highWatermark_ = highWatermark;
+    }
+
+    size_t maintain(size_t budget) {
+      return trim(budget);
+    }
+
+    // 幽灵命中后在两部分之间挪动一个容量，各自持本部分的锁
     void increaseCapacity() {
+      std::lock_guard<Lock> lock(mutex_);
       ++capacity_;
     }
 
     bool decreaseCapacity() {
+      std::lock_guard<Lock> lock(mutex_);
       if (capacity_ <= 0) {
         return false;
       }
-      if (mainCache_.size() == capacity_) {
+      if (!maintenance_ && mainCache_.size() == capacity_) {
         evictLeastFrequency();
       }
       --capacity_;
+      if (maintenance_ && mainCache_.size() > capacity_) {
+        maintenance_->notify();
+      }
       return true;
     }
 
   private:
-    void initLists() {
-      ghostHead_ = std::make_shared<NodeType>();
-      ghostTail_ = std::make_shared<NodeType>();
-      ghostHead_->next_ = ghostTail_;
-      ghostTail_->prev_ = ghostHead_;
+    size_t trimLocked(size_t maxEvictions) {
+      size_t evicted = 0;
+      while (evicted < maxEvictions && mainCache_.size() > capacity_) {
+        size_t before = mainCache_.size();
+        evictLeastFrequency();
+        if (mainCache_.size() == before) {
+          break;  // 链表与索引不一致时不空转
+        }
+        ++evicted;
+      }
+      while (evicted < maxEvictions && ghostCache_.size() > ghostCapacity_) {
+        removeOldestGhost();
+        ++evicted;
+      }
+      return evicted;
+    }
+
+    // put/get顺带的淘汰：延迟维护时交给后台
+    void trimInline() {
+      if (!maintenance_) {
+        trimLocked(kTrimPerOp);
+      }
     }
 
-    bool updateExistingNode(NodePtr node, const Value& value) {
-      node->setValue(value);
-      updateNode
+    size_t mainLimit() const {
+      return maintenance_ ? highWatermarkLimit(capacity_, highWatermark_) : capacity_;
+    }
+
+    size_t ghostLimit() const {
+      return maintenance_ ? highWatermarkLimit(ghostCapacity_, highWatermark_) : ghostCapacity_;
+    }
+
+    bool updateExistingNode(SlotIndex slot, const Value& value) {
+      store_.payload(slot).value = value;
+      updateNodeFrequency(slot);
       return true;
     }
 
     bool addNewNode(const Key& key, const Value& value) {
-      if (mainCache_.size() >= capacity_) {
+      if (mainCache_.size() >= mainLimit()) {
         evictLeastFrequency();
       }
-      NodePtr newNode = std::make_shared<NodeType>(key, value);
-      mainCache_[key] = newNode;
+      SlotIndex slot = store_.allocate();
+      store_.meta(slot).count = 1;
+      NodeType& node = store_.payload(slot);
+      node.key = mainCache_.insert(key, slot);
+      node.value = value;
       // 将新节点添加到频率为1的列表中
-      if (freqMap_.find(1) == freqMap_.end()) {
-        freqMap_[1] = std::list<NodePtr>();
-      }
-      freqMap_[1].push_back(newNode);
+      freqMap_[1].pushBack(store_, slot);
       minFreq_ = 1;
+      if (maintenance_ && (mainCache_.size() >= wakeLimit(capacity_, highWatermark_) ||
+                           ghostCache_.size() >= wakeLimit(ghostCapacity_, highWatermark_))) {
+        maintenance_->notify();  // 超额积累到一定量，唤醒后台淘汰
+      }
       return true;
     }
 
-    void updateNodeFrequency(NodePtr node) {
-      size_t oldFreq = node->getAccessCount();
-      node->incrementAccessCount();
-      size_t newFreq = node->getAccessCount();
+    void updateNodeFrequency(SlotIndex slot) {
+      size_t oldFreq = store_.meta(slot).count;
+      size_t newFreq = ++store_.meta(slot).count;
 
       // 从旧频率列表中移除节点
-      auto& oldFreqList = freqMap_[oldFreq];
-      oldFreqList.remove(node);
-      if (oldFreqList.empty()) {
-        freqMap_.erase(oldFreq);
+      auto it = freqMap_.find(oldFreq);
+      it->second.remove(store_, slot);
+      if (it->second.empty()) {
+        freqMap_.erase(it);
         if (minFreq_ == oldFreq) {
           minFreq_ = newFreq;
         }
       }
 
       // 添加到新频率列表
-      if (freqMap_.find(newFreq) == freqMap_.end()) {
-        freqMap_[newFreq] = std::list<NodePtr>();
-      }
-      freqMap_[newFreq].push_back(node);
+      freqMap_[newFreq].pushBack(store_, slot);
     }
 
     void evictLeastFrequency() {
@@ -139,19 +234,22 @@ namespace MyCache {
         return;
       }
       // 获取最小频率列表
-      auto& minFreqList = freqMap_[minFreq_];
-      if (minFreqList.empty()) {
-        freqMap_.erase(minFreq_);
+      auto it = freqMap_.find(minFreq_);
+      if (it == freqMap_.end() || it->second.empty()) {
+        if (it != freqMap_.end()) {
+          freqMap_.erase(it);
+        }
         return;
       }
 
       // 移除最少使用节点
-      NodePtr leastNode = minFreqList.front();
-      minFreqList.pop_front();
+      FreqBucket& minFreqList = it->second;
+      SlotIndex leastNode = minFreqList.head;
+      minFreqList.remove(store_, leastNode);
 
       // 移除节点后，然后频率列表为空
       if (minFreqList.empty()) {
-        freqMap_.erase(minFreq_);
+        freqMap_.erase(it);
         // 更新最小频率
         if (!freqMap_.empty()) {
           minFreq_ = freqMap_.begin()->first;
@@ -159,34 +257,46 @@ namespace MyCache {
       }
 
       // 将节点移到幽灵缓存
-      if (ghostCache_.size() >= ghostCapacity_) {
+      if (ghostCache_.size() >= ghostLimit()) {
         removeOldestGhost();
       }
       addToGhost(leastNode);
-      // 从主缓存中移除
-      mainCache_.erase(leastNode->getKey());
+    }
+
+    // 同一个key已有更早的幽灵结点：先删掉旧结点，避免两个结点共用一个索引项(见 ArcLruPart::dropStaleGhost)
+    void dropStaleGhost(const Key& key) {
+      SlotIndex* stale = ghostCache_.find(key);
+      if (stale) {
+        SlotIndex ghost = *stale;
+        removeFromGhost(ghost);
+        ghostCache_.erase(store_.payload(ghost).key);
+        store_.release(ghost);
+      }
     }
 
     void removeOldestGhost() {
-      NodePtr oldestGhost = ghostHead_->next_;
-      if (oldestGhost == ghostTail_) {
+      SlotIndex oldestGhost = ghostList_.head;
+      if (oldestGhost == kNilSlot) {
         return;
       }
       removeFromGhost(oldestGhost);
-      ghostCache_.erase(oldestGhost->getKey());
+      ghostCache_.erase(store_.payload(oldestGhost).key);
+      store_.release(oldestGhost);
     }
 
-    void addToGhost(NodePtr node) {
-      node->prev_ = ghostTail_->prev_;
-      node->next_ = ghostTail_;
-      ghostTail_->prev_->next_ = node;
-      ghostTail_->prev_ = node;
-      ghostCache_[node->getKey()] = node;
+    // 结点从主缓存索引转入幽灵表索引：两个索引各自驻留key，先拷出key再按引用删除主索引里的那份
+    void addToGhost(SlotIndex slot) {
+      NodeType& node = store_.payload(slot);
+      Key key = KeyRefTraits<Key>::toKey(node.key);
+      mainCache_.erase(node.key);
+      dropStaleGhost(key);
+      node.value = Value();  // 幽灵结点不再需要value
+      ghostList_.pushBack(store_, slot);
+      node.key = ghostCache_.insert(key, slot);
     }
 
-    void removeFromGhost(NodePtr node) {
-      node->prev_->next_ = node->next_;
-      node->next_->prev_ = node->prev_;
+    void removeFromGhost(SlotIndex slot) {
+      ghostList_.remove(store_, slot);
     }
   };
 
@@ -1,184 +1,287 @@
 #pragma once
 
 #include "ArcCacheNode.h"
-#include <unordered_map>
+#include "../CacheAllocator.h"
+#include "../KeyIndex.h"
+#include "../LockPolicy.h"
+#include "../Maintenance.h"
 #include <mutex>
 
 namespace MyCache {
-  template <typename Key, typename Value>
+  template <typename Key, typename Value, typename Alloc = DefaultAlloc, typename Lock = std::mutex>
   class ArcLruPart {
   public:
     using NodeType = ArcNode<Key, Value>;
-    using NodePtr = std::shared_ptr<NodeType>;
-    using NodeMap = std::unordered_map<Key, NodePtr>;
+    using NodeStore = SlotStore<NodeType, Alloc>;
+    using NodeMap = KeyIndex<Key, SlotIndex, Alloc>;  // 整数key走直接寻址，其余走哈希
+    using allocator_type = Alloc;
+    using lock_type = Lock;
 
   private:
+    static constexpr size_t kTrimPerOp = 4;  // 缩容后每次put/get顺带淘汰的上限
+
     size_t capacity_;
     size_t ghostCapacity_;
     size_t transformThreshold_;  // 转换门槛值
 
-    std::mutex mutex_;
+    Alloc alloc_;
+    Lock mutex_;
+    MaintenanceExecutor* maintenance_ = nullptr;  // 非空时超出容量的主缓存/幽灵结点交给后台淘汰
+    double highWatermark_ = kDefaultHighWatermark;
 
     NodeMap mainCache_;
     NodeMap ghostCache_;
+    NodeStore store_;  // 主链表与幽灵链表的结点共用
 
-    // 主链表
-    NodePtr mainHead_;
-    NodePtr mainTail_;
-    // 淘汰链表
-    NodePtr ghostHead_;
-    NodePtr ghostTail_;
+    // 主链表：头部最近访问，尾部最久未访问
+    SlotList mainList_;
+    // 淘汰链表：头部最新淘汰，尾部最旧
+    SlotList ghostList_;
   
   public:
-    explicit ArcLruPart(size_t capacity, size_t transformThreshold)
-      : capacity_(capacity), ghostCapacity_(capacity), transformThreshold_(transformThreshold) {
-        initLists();
+    explicit ArcLruPart(size_t capacity, size_t transformThreshold, const Alloc& alloc = Alloc())
+      : capacity_(capacity), ghostCapacity_(capacity), transformThreshold_(transformThreshold)
+      , alloc_(alloc), mainCache_(alloc), ghostCache_(alloc), store_(alloc) {
+      mainCache_.sizeHint(capacity);
+      ghostCache_.sizeHint(capacity);
     }
 
+    allocator_type get_allocator() const { return alloc_; }
+
     bool put(Key key, Value value) {
+      std::lock_guard<Lock> lock(mutex_);
       if (capacity_ == 0) {
         return false;
       }
-      std::lock_guard<std::mutex> lock(mutex_);
-      auto it = mainCache_.find(key);
-      if (it != mainCache_.end()) {
-        return updateExistingNode(it->second, value);
+      trimInline();
+      SlotIndex* slot = mainCache_.find(key);
+      if (slot) {
+        return updateExistingNode(*slot, value);
       }
       return addNewNode(key, value);
     }
 
     bool get(Key key, Value& value, bool& shouldTransform) {
-      std::lock_guard<std::mutex> lock(mutex_);
-      auto it = mainCache_.find(key);
-      if (it != mainCache_.end()) {
-        shouldTransform = updateNodeAccess(it->second);
-        value = it->second->getValue();
+      std::lock_guard<Lock> lock(mutex_);
+      trimInline();
+      SlotIndex* slot = mainCache_.find(key);
+      if (slot) {
+        shouldTransform = updateNodeAccess(*slot);
+        value = store_.payload(*slot).value;
+        return true;
+      }
+      return false;
+    }
+
+    // 只读查看：不更新访问信息，锁支持共享模式时多个peek可并行
+    bool peek(Key key, Value& value) {
+      SharedGuard<Lock> lock(mutex_);
+      SlotIndex* slot = mainCache_.find(key);
+      if (slot) {
+        value = store_.payload(*slot).value;
         return true;
       }
       return false;
     }
 
+    // 幽灵命中时删掉幽灵结点并返回true。与后台维护/trim 并发，须持锁
     bool checkGhost(Key key) {
-      auto it = ghostCache_.find(key);
-      if (it != ghostCache_.end()) {
-        removeFromGhost(it->second);
-        ghostCache_.erase(it);
+      std::lock_guard<Lock> lock(mutex_);
+      SlotIndex* slot = ghostCache_.find(key);
+      if (slot) {
+        SlotIndex ghost = *slot;
+        removeFromGhost(ghost);
+        ghostCache_.erase(store_.payload(ghost).key);
+        store_.release(ghost);
         return true; 
       }
       return false;
     }
 
+    // 在线调整容量(幽灵表容量随之调整)：扩容立即生效，缩容超出的结点由后续put/get或 trim 分批淘汰
+    void setCapacity(size_t capacity) {
+      std::lock_guard<Lock> lock(mutex_);
+      capacity_ = capacity;
+      ghostCapacity_ = capacity;
+      mainCache_.sizeHint(capacity);
+      ghostCache_.sizeHint(capacity);
+      if (maintenance_ && (mainCache_.size() > capacity_ || ghostCache_.size() > ghostCapacity_)) {
+        maintenance_->notify();
+      }
+    }
+
+    // 淘汰至多 maxEvictions 个超出容量的主缓存/幽灵结点，返回实际淘汰数
+    size_t trim(size_t maxEvictions) {
+      std::lock_guard<Lock> lock(mutex_);
+      return trimLocked(maxEvictions);
+    }
+
+    // 延迟维护：executor非空时插入不再同步淘汰主缓存与幽灵表，超出容量的部分由后台调用 maintain 淘汰；
+    // 涨到 容量*highWatermark 时退回同步淘汰。传空指针恢复
+    void deferMaintenance(MaintenanceExecutor* executor, double highWatermark = kDefaultHighWatermark) {
+      std::lock_guard<Lock> lock(mutex_);
+      maintenance_ = executor;
+      highWatermark_ = highWatermark;
+    }
+
+    size_t maintain(size_t budget) {
+      return trim(budget);
+    }
+
+    // 幽灵命中后在两部分之间挪动一个容量，各自持本部分的锁
     void increaseCapacity() {
+      std::lock_guard<Lock> lock(mutex_);
       ++capacity_;
     }
 
     bool decreaseCapacity() {
+      std::lock_guard<Lock> lock(mutex_);
       if (capacity_ <= 0) { 
         return false;
       }
-      if (mainCache_.size() == capacity_) {
+      if (!maintenance_ && mainCache_.size() == capacity_) {
         evictLeastRecent();
       }
       --capacity_;
+      if (maintenance_ && mainCache_.size() > capacity_) {
+        maintenance_->notify();
+      }
       return true;
     }
 
   private:
-    void initLists() {
-      mainHead_ = std::make_shared<NodeType>();
-      mainTail_ = std::make_shared<NodeType>();
-      mainHead_->next_ = mainTail_;
-      mainTail_->prev_ = mainHead_;
+    size_t trimLocked(size_t maxEvictions) {
+      size_t evicted = 0;
+      while (evicted < maxEvictions && mainCache_.size() > capacity_) {
+        size_t before = mainCache_.size();
+        evictLeastRecent();
+        if (mainCache_.size() == before) {
+          break;  // 链表与索引不一致时不空转
+        }
+        ++evicted;
+      }
+      while (evicted < maxEvictions && ghostCache_.size() > ghostCapacity_) {
+        removeOldestGhost();
+        ++evicted;
+      }
+      return evicted;
+    }
+
+    // put/get顺带的淘汰：延迟维护时交给后台
+    void trimInline() {
+      if (!maintenance_) {
+        trimLocked(kTrimPerOp);
+      }
+    }
+
+    size_t mainLimit() const {
+      return maintenance_ ? highWatermarkLimit(capacity_, highWatermark_) : capacity_;
+    }
 
-      ghostHead_ = std::make_shared<NodeType>();
-      ghostTail_ = std::make_shared<NodeType>();
-      ghostHead_->next_ = ghostTail_;
-      ghostTail_->prev_ = ghostHead_;
+    size_t ghostLimit() const {
+      return maintenance_ ? highWatermarkLimit(ghostCapacity_, highWatermark_) : ghostCapacity_;
     }
 
-    bool updateExistingNode(NodePtr node, const Value& value) {
-      node->setValue(value);
-      moveToFront(node);
+    bool updateExistingNode(SlotIndex slot, const Value& value) {
+      store_.payload(slot).value = value;
+      moveToFront(slot);
       return true;
     }
 
     bool addNewNode(const Key& key, const Value& value) {
-      if (mainCache_.size() >= capacity_) {
+      if (mainCache_.size() >= mainLimit()) {
         evictLeastRecent();
       }
-      NodePtr newNode = std::make_shared<NodeType>(key, value);
-      mainCache_[key] = newNode;
-      addToFront(newNode);
+      SlotIndex slot = store_.allocate();
+      store_.meta(slot).count = 1;
+      NodeType& node = store_.payload(slot);
+      node.key = mainCache_.insert(key, slot);
+      node.value = value;
+      addToFront(slot);
+      if (maintenance_ && (mainCache_.size() >= wakeLimit(capacity_, highWatermark_) ||
+                           ghostCache_.size() >= wakeLimit(ghostCapacity_, highWatermark_))) {
+        maintenance_->notify();  // 超额积累到一定量，唤醒后台淘汰
+      }
       return true;
     }
 
-    void moveToFront(NodePtr node) {
+    void moveToFront(SlotIndex slot) {
       // 从当前位置删除
-      node->prev_->next_ = node->next_;
-      node->next_->prev_ = node->prev_;
+      mainList_.remove(store_, slot);
       // 添加到头部
-      addToFront(node);
+      addToFront(slot);
     }
 
-    void addToFront(NodePtr node) {
-      node->next_ = mainHead_->next_;
-      node->prev_ = mainHead_;
-      mainHead_->next_->prev_ = node;
-      mainHead_->next_ = node;
+    void addToFront(SlotIndex slot) {
+      mainList_.pushFront(store_, slot);
     }
 
     void evictLeastRecent() {
-      NodePtr leastRecent = mainTail_->prev_;
-      if (leastRecent == mainHead_) {
+      SlotIndex leastRecent = mainList_.tail;
+      if (leastRecent == kNilSlot) {
         return;
       }
       // 从主链表中移除
       removeFromMain(leastRecent);
 
       // 添加到幽灵缓存
-      if (ghostCache_.size() >= ghostCapacity_) {
+      if (ghostCache_.size() >= ghostLimit()) {
         removeOldestGhost();
       }
       addToGhost(leastRecent);
-      // 从主缓存映射中移除
-      mainCache_.erase(leastRecent->getKey());
     }
 
-    void removeFromMain(NodePtr node) {
-      node->prev_->next_ = node->next_;
-      node->next_->prev_ = node->prev_;
+    void removeFromMain(SlotIndex slot) {
+      mainList_.remove(store_, slot);
     }
 
-    void addToGhost(NodePtr node) {
-      // 重置节点的访问计数
-      node->accessCount_ = 1;
+    // 结点从主缓存索引转入幽灵表索引：两个索引各自驻留key，先拷出key再按引用删除主索引里的那份
+    void addToGhost(SlotIndex slot) {
+      NodeType& node = store_.payload(slot);
+      Key key = KeyRefTraits<Key>::toKey(node.key);
+      mainCache_.erase(node.key);
+      dropStaleGhost(key);
+      // 重置节点的访问计数，幽灵结点不再需要value
+      store_.meta(slot).count = 1;
+      node.value = Value();
       // 添加到头部
-      node->next_ = ghostHead_->next_;
-      node->prev_ = ghostHead_;
-      ghostHead_->next_->prev_ = node;
-      ghostHead_->next_ = node;
+      ghostList_.pushFront(store_, slot);
       // 添加到幽灵缓存映射
-      ghostCache_[node->getKey()] = node;
+      node.key = ghostCache_.insert(key, slot);
+    }
+
+    // 同一个key已有更早的幽灵结点(它在另一部分被访问后又回到本部分并再次被淘汰)：先删掉旧结点，
+    // 否则两个结点共用一个索引项，旧结点出队时会把新结点的索引项(及驻留的key)一并删掉
+    void dropStaleGhost(const Key& key) {
+      SlotIndex* stale = ghostCache_.find(key);
+      if (stale) {
+        SlotIndex ghost = *stale;
+        removeFromGhost(ghost);
+        ghostCache_.erase(store_.payload(ghost).key);
+        store_.release(ghost);
+      }
     }
 
     void removeOldestGhost() {
-      NodePtr oldestGhost = ghostTail_->prev_;
-      if (oldestGhost == ghostHead_) {
+      SlotIndex oldestGhost = ghostList_.tail;
+      if (oldestGhost == kNilSlot) {
         return;
       }
       removeFromGhost(oldestGhost);
-      ghostCache_.erase(oldestGhost->getKey());
+      ghostCache_.erase(store_.payload(oldestGhost).key);
+      store_.release(oldestGhost);
     }
 
-    void removeFromGhost(NodePtr node) {
-      node->prev_->next_ = node->next_;
-      node->next_->prev_ = node->prev_;
+    void removeFromGhost(SlotIndex slot) {
+      ghostList_.remove(store_, slot);
     }
 
-    bool updateNodeAccess(NodePtr node, const Value& value) {
-      node->setValue(value);
-      moveToFront(node);
-      return true;
+    // 访问次数达到转换门槛时返回true，由ArcCache将其转入LFU部分
+    bool updateNodeAccess(SlotIndex slot) {
+      moveToFront(slot);
+      uint32_t& accessCount = store_.meta(slot).count;
+      ++accessCount;
+      return accessCount >= transformThreshold_;
     }
   };
 
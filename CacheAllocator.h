@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+namespace MyCache {
+  // 各缓存引擎的 Alloc 模板参数为"字节分配器"，引擎内部按需 rebind 到实际对象类型
+  // 使用 pmr::polymorphic_allocator 时，整个缓存的内存都来自同一个 memory_resource
+  using DefaultAlloc = std::allocator<char>;
+  using PmrAlloc = std::pmr::polymorphic_allocator<char>;
+
+  template<typename Alloc, typename T>
+  using RebindAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+  // 通过分配器创建/销毁单个对象(替代 new/delete)
+  // 直接就地构造而不经 allocator::construct：引擎自身声明了 allocator_type，
+  // 若经 polymorphic_allocator::construct 会被再追加一个分配器参数
+  template<typename T, typename Alloc, typename... Args>
+  T* allocateObject(const Alloc& alloc, Args&&... args) {
+    RebindAlloc<Alloc, T> typed(alloc);
+    using Traits = std::allocator_traits<RebindAlloc<Alloc, T>>;
+    T* p = Traits::allocate(typed, 1);
+    try {
+      ::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      Traits::deallocate(typed, p, 1);
+      throw;
+    }
+    return p;
+  }
+
+  template<typename T, typename Alloc>
+  void destroyObject(const Alloc& alloc, T* p) {
+    if (!p) {
+      return;
+    }
+    RebindAlloc<Alloc, T> typed(alloc);
+    using Traits = std::allocator_traits<RebindAlloc<Alloc, T>>;
+    p->~T();
+    Traits::deallocate(typed, p, 1);
+  }
+
+  // 配合 std::unique_ptr 使用的删除器，保存分配器副本
+  // polymorphic_allocator 不可赋值，而 unique_ptr 的移动赋值(如重新分片时替换分片)会赋值删除器：
+  // 这里以重新拷贝构造代替赋值，删除器随指针一起换成源对象的分配器
+  template<typename T, typename Alloc>
+  struct AllocDeleter {
+    Alloc alloc;
+
+    AllocDeleter(const Alloc& a = Alloc()) : alloc(a) {}
+    AllocDeleter(const AllocDeleter&) = default;
+
+    AllocDeleter& operator=(const AllocDeleter& other) {
+      if (this != &other) {
+        alloc.~Alloc();
+        ::new (static_cast<void*>(&alloc)) Alloc(other.alloc);
+      }
+      return *this;
+    }
+
+    void operator()(T* p) const { destroyObject(alloc, p); }
+  };
+
+  template<typename T, typename Alloc>
+  using AllocUniquePtr = std::unique_ptr<T, AllocDeleter<T, Alloc>>;
+
+  template<typename T, typename Alloc, typename... Args>
+  AllocUniquePtr<T, Alloc> allocateUnique(const Alloc& alloc, Args&&... args) {
+    return AllocUniquePtr<T, Alloc>(allocateObject<T>(alloc, std::forward<Args>(args)...), AllocDeleter<T, Alloc>{alloc});
+  }
+} // namespace MyCache
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace MyCache {
+  // 发布毫秒计数的单元：独占一个cache line，读端只需一次relaxed load，不与其它写入伪共享
+  struct alignas(64) ClockCell {
+    std::atomic<uint64_t> millis{0};
+
+    uint64_t now() const { return millis.load(std::memory_order_relaxed); }
+  };
+
+  // 元数据里保存的32位相对时间戳：相对某个基准的毫秒数，约49.7天回绕一次
+  using RelativeTime = uint32_t;
+
+  inline RelativeTime toRelative(uint64_t millis, uint64_t base) {
+    return static_cast<RelativeTime>(millis - base);
+  }
+
+  // 两个相对时间戳的间隔，按无符号差值计算，跨越一次回绕仍然正确
+  inline uint32_t elapsedSince(RelativeTime earlier, RelativeTime later) {
+    return later - earlier;
+  }
+
+  // 粗粒度时钟：后台线程按固定间隔把 steady_clock 的毫秒数写入 ClockCell
+  // 引擎持有 const ClockCell*，热路径上取时间不再调用 chrono::now()
+  // 用法：
+  //   const MyCache::ClockCell* clock = &MyCache::CoarseClock::global().cell();
+  //   uint64_t ms = clock->now();
+  class CoarseClock {
+  private:
+    ClockCell cell_;
+    std::chrono::milliseconds interval_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+    std::thread ticker_;
+
+    static uint64_t steadyMillis() {
+      return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void tick() {
+      cell_.millis.store(steadyMillis(), std::memory_order_relaxed);
+    }
+
+    void run() {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!cv_.wait_for(lock, interval_, [this] { return stop_; })) {
+        tick();
+      }
+    }
+
+  public:
+    explicit CoarseClock(std::chrono::milliseconds interval = std::chrono::milliseconds(1))
+      : interval_(interval), stop_(false) {
+      tick();  // 构造完成即可读到有效时间
+      ticker_ = std::thread(&CoarseClock::run, this);
+    }
+
+    CoarseClock(const CoarseClock&) = delete;
+    CoarseClock& operator=(const CoarseClock&) = delete;
+
+    ~CoarseClock() {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      cv_.notify_one();
+      ticker_.join();
+    }
+
+    // 进程内共享的实例，首次使用时启动后台线程
+    static CoarseClock& global() {
+      static CoarseClock clock;
+      return clock;
+    }
+
+    const ClockCell& cell() const { return cell_; }
+    uint64_t now() const { return cell_.now(); }
+  };
+
+  // 手动推进的时钟：测试与回放时替代 CoarseClock，时间完全由调用方决定
+  class ManualClock {
+  private:
+    ClockCell cell_;
+
+  public:
+    explicit ManualClock(uint64_t startMillis = 0) {
+      cell_.millis.store(startMillis, std::memory_order_relaxed);
+    }
+
+    ManualClock(const ManualClock&) = delete;
+    ManualClock& operator=(const ManualClock&) = delete;
+
+    void set(uint64_t millis) { cell_.millis.store(millis, std::memory_order_relaxed); }
+    void advance(uint64_t millis) { cell_.millis.fetch_add(millis, std::memory_order_relaxed); }
+
+    const ClockCell& cell() const { return cell_; }
+    uint64_t now() const { return cell_.now(); }
+  };
+} // namespace MyCache
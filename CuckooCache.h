@@ -0,0 +1,412 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CacheAllocator.h"
+#include "CachePolicy.h"
+#include "EpochReclaimer.h"
+
+namespace MyCache {
+  // MemC3风格的乐观布谷鸟哈希缓存
+  // - 每个key有两个候选桶，每桶4路，桶内先比对1字节tag指纹，命中才解引用结点比较key
+  // - 读者无锁：读key所属的版本计数器(奇数表示该key正被搬迁)，查两个桶，再确认版本未变
+  // - 写者单锁串行；插入时若两个桶都满，先BFS找一条搬迁路径，再从空位一侧倒序逐个搬迁
+  // - 条目数达到容量时按CLOCK淘汰；结点不可变，替换/淘汰后经EpochReclaimer延迟释放
+  // - 结点的分配与释放(retire时顺带回收)都在写锁内进行，Alloc无需线程安全(如单线程的pmr资源)
+  // 每桶4路配合BFS搬迁，表的占用率可以做到95%左右
+  template<typename Key, typename Value, typename Alloc = DefaultAlloc>
+  class CuckooCache : public CachePolicy<Key, Value> {
+  public:
+    using allocator_type = Alloc;
+    static constexpr size_t kWays = 4;
+
+  private:
+    static constexpr size_t kVersionStripes = 8192;  // 版本计数器按key哈希分条的上限，小表按桶数取更少的条
+    static constexpr size_t kMaxPathNodes = 512;     // BFS最多展开的桶数
+    static constexpr double kTargetLoad = 0.95;
+
+    struct Item {
+      size_t hash;
+      Key key;
+      Value value;
+
+      Item(size_t h, const Key& k, const Value& v) : hash(h), key(k), value(v) {}
+    };
+
+    struct alignas(64) Bucket {
+      std::atomic<uint8_t> tags[kWays];   // 0表示空路
+      std::atomic<Item*> items[kWays];
+
+      Bucket() {
+        for (size_t way = 0; way < kWays; ++way) {
+          tags[way].store(0, std::memory_order_relaxed);
+          items[way].store(nullptr, std::memory_order_relaxed);
+        }
+      }
+    };
+
+    struct alignas(64) VersionStripe {
+      std::atomic<uint32_t> version{0};
+    };
+
+    // BFS搬迁路径上的结点：到达bucket，是从父结点桶的第way路搬过来的
+    struct PathNode {
+      size_t bucket;
+      int parent;
+      int way;
+    };
+
+    using RefBit = std::atomic<uint8_t>;
+
+    static constexpr size_t kTrimPerOp = 4;  // 缩容后每次put顺带淘汰的上限
+
+    std::atomic<size_t> capacity_;  // 可在线调整，上限为表的总路数
+    size_t size_;         // 写者持锁维护
+    size_t clockHand_;    // 写者持锁维护
+    Alloc alloc_;
+    std::mutex writeMutex_;
+    std::vector<Bucket, RebindAlloc<Alloc, Bucket>> buckets_;
+    std::vector<RefBit, RebindAlloc<Alloc, RefBit>> referenced_;
+    std::vector<VersionStripe, RebindAlloc<Alloc, VersionStripe>> versions_;
+    size_t versionMask_;
+    // 放在最后：析构时先于 alloc_ 释放剩余的待回收结点
+    // 读者首次pin时在写锁之外登记记录，而 Alloc 无需线程安全，故回收器的记录与待回收列表固定走全局堆
+    EpochReclaimer<> reclaimer_;
+
+    // 桶数不取2的幂，表大小紧贴容量/目标占用率
+    static size_t bucketCount(size_t capacity) {
+      return std::max<size_t>(2, static_cast<size_t>(capacity / (kWays * kTargetLoad)) + 1);
+    }
+
+    // 不少于桶数的2的幂，不超过 kVersionStripes：每条独占一个cache line，小表不必付出整套计数器的内存
+    static size_t versionStripeCount(size_t buckets) {
+      size_t count = 1;
+      while (count < buckets && count < kVersionStripes) {
+        count <<= 1;
+      }
+      return count;
+    }
+
+    static size_t hashOf(const Key& key) {
+      uint64_t mixed = static_cast<uint64_t>(std::hash<Key>()(key)) * 0x9E3779B97F4A7C15ULL;
+      return static_cast<size_t>(mixed ^ (mixed >> 29));
+    }
+
+    static uint8_t tagOf(size_t hash) {
+      uint8_t tag = static_cast<uint8_t>(hash >> 56);
+      return tag ? tag : 1;
+    }
+
+    size_t primaryBucket(size_t hash) const {
+      return (hash >> 8) % buckets_.size();
+    }
+
+    // 备选桶只依赖当前桶与tag：b -> (c - b) mod n 是对合映射，两个方向互为备选
+    size_t alternateBucket(size_t bucket, uint8_t tag) const {
+      size_t n = buckets_.size();
+      size_t c = (static_cast<size_t>(tag) * 0x5bd1e995) % n;
+      return (c + n - bucket) % n;
+    }
+
+    std::atomic<uint32_t>& versionOf(size_t hash) {
+      return versions_[hash & versionMask_].version;
+    }
+
+    RefBit& refBit(size_t bucket, size_t way) {
+      return referenced_[bucket * kWays + way];
+    }
+
+    static void destroyItem(void* context, void* object) {
+      destroyObject(static_cast<CuckooCache*>(context)->alloc_, static_cast<Item*>(object));
+    }
+
+    void retire(Item* item) {
+      reclaimer_.retire(item, &CuckooCache::destroyItem, this);
+    }
+
+    // 写者持锁查找：返回 bucket*kWays+way，不存在返回 SIZE_MAX
+    size_t locate(size_t hash, const Key& key) {
+      uint8_t tag = tagOf(hash);
+      size_t first = primaryBucket(hash);
+      size_t candidates[2] = {first, alternateBucket(first, tag)};
+      for (size_t bucket : candidates) {
+        for (size_t way = 0; way < kWays; ++way) {
+          if (buckets_[bucket].tags[way].load(std::memory_order_relaxed) != tag) {
+            continue;
+          }
+          Item* item = buckets_[bucket].items[way].load(std::memory_order_relaxed);
+          if (item->hash == hash && item->key == key) {
+            return bucket * kWays + way;
+          }
+        }
+      }
+      return SIZE_MAX;
+    }
+
+    void place(size_t bucket, size_t way, Item* item) {
+      refBit(bucket, way).store(0, std::memory_order_relaxed);
+      buckets_[bucket].items[way].store(item, std::memory_order_release);
+      buckets_[bucket].tags[way].store(tagOf(item->hash), std::memory_order_release);
+    }
+
+    Item* clear(size_t bucket, size_t way) {
+      Item* item = buckets_[bucket].items[way].load(std::memory_order_relaxed);
+      buckets_[bucket].tags[way].store(0, std::memory_order_release);
+      buckets_[bucket].items[way].store(nullptr, std::memory_order_release);
+      return item;
+    }
+
+    // 把(src, srcWay)的结点搬到空位(dst, dstWay)：搬迁期间该key的版本为奇数，读者会重试
+    void move(size_t src, size_t srcWay, size_t dst, size_t dstWay) {
+      Item* item = buckets_[src].items[srcWay].load(std::memory_order_relaxed);
+      std::atomic<uint32_t>& version = versionOf(item->hash);
+      uint32_t v = version.load(std::memory_order_relaxed);
+      version.store(v + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      uint8_t referenced = refBit(src, srcWay).load(std::memory_order_relaxed);
+      place(dst, dstWay, item);
+      refBit(dst, dstWay).store(referenced, std::memory_order_relaxed);
+      clear(src, srcWay);
+      version.store(v + 2, std::memory_order_release);
+    }
+
+    int freeWay(size_t bucket) {
+      for (size_t way = 0; way < kWays; ++way) {
+        if (!buckets_[bucket].tags[way].load(std::memory_order_relaxed)) {
+          return static_cast<int>(way);
+        }
+      }
+      return -1;
+    }
+
+    // 在两个候选桶腾出一个空位，返回 bucket*kWays+way；找不到搬迁路径返回 SIZE_MAX
+    size_t makeRoom(size_t first, size_t second) {
+      std::vector<PathNode> path;
+      path.reserve(kMaxPathNodes);
+      path.push_back(PathNode{first, -1, -1});
+      if (second != first) {
+        path.push_back(PathNode{second, -1, -1});
+      }
+      for (size_t head = 0; head < path.size(); ++head) {
+        int way = freeWay(path[head].bucket);
+        if (way >= 0) {
+          // 从空位开始倒序搬迁，最后空出来的是候选桶里的一路
+          size_t dst = path[head].bucket;
+          size_t dstWay = static_cast<size_t>(way);
+          for (int node = static_cast<int>(head); path[node].parent >= 0; node = path[node].parent) {
+            size_t src = path[path[node].parent].bucket;
+            size_t srcWay = static_cast<size_t>(path[node].way);
+            move(src, srcWay, dst, dstWay);
+            dst = src;
+            dstWay = srcWay;
+          }
+          return dst * kWays + dstWay;
+        }
+        for (size_t w = 0; w < kWays && path.size() < kMaxPathNodes; ++w) {
+          uint8_t tag = buckets_[path[head].bucket].tags[w].load(std::memory_order_relaxed);
+          path.push_back(PathNode{alternateBucket(path[head].bucket, tag), static_cast<int>(head), static_cast<int>(w)});
+        }
+      }
+      return SIZE_MAX;
+    }
+
+    // CLOCK：清掉沿途的访问位，淘汰第一个未被访问的条目
+    void evictOne() {
+      size_t slots = buckets_.size() * kWays;
+      for (;;) {
+        size_t slot = clockHand_;
+        clockHand_ = (clockHand_ + 1) % slots;
+        size_t bucket = slot / kWays;
+        size_t way = slot % kWays;
+        if (!buckets_[bucket].tags[way].load(std::memory_order_relaxed)) {
+          continue;
+        }
+        RefBit& bit = refBit(bucket, way);
+        if (bit.load(std::memory_order_relaxed)) {
+          bit.store(0, std::memory_order_relaxed);
+          continue;
+        }
+        retire(clear(bucket, way));
+        --size_;
+        return;
+      }
+    }
+
+    size_t trimLocked(size_t maxEvictions) {
+      size_t evicted = 0;
+      while (evicted < maxEvictions && size_ > capacity_.load(std::memory_order_relaxed)) {
+        evictOne();
+        ++evicted;
+      }
+      return evicted;
+    }
+
+    // 两个候选桶都满且找不到搬迁路径时，在这8路里按CLOCK挑一个
+    size_t evictFromCandidates(size_t first, size_t second) {
+      size_t candidates[2] = {first, second};
+      for (int pass = 0; pass < 2; ++pass) {
+        for (size_t bucket : candidates) {
+          for (size_t way = 0; way < kWays; ++way) {
+            RefBit& bit = refBit(bucket, way);
+            if (pass == 0 && bit.load(std::memory_order_relaxed)) {
+              bit.store(0, std::memory_order_relaxed);
+              continue;
+            }
+            retire(clear(bucket, way));
+            --size_;
+            return bucket * kWays + way;
+          }
+        }
+      }
+      return first * kWays;
+    }
+
+  public:
+    explicit CuckooCache(size_t capacity, const Alloc& alloc = Alloc())
+      : capacity_(capacity), size_(0), clockHand_(0), alloc_(alloc)
+      , buckets_(bucketCount(capacity), RebindAlloc<Alloc, Bucket>(alloc))
+      , referenced_(buckets_.size() * kWays, RebindAlloc<Alloc, RefBit>(alloc))
+      , versions_(versionStripeCount(buckets_.size()), RebindAlloc<Alloc, VersionStripe>(alloc))
+      , versionMask_(versions_.size() - 1) {}
+
+    CuckooCache(const CuckooCache&) = delete;
+    CuckooCache& operator=(const CuckooCache&) = delete;
+
+    // 析构时不得有并发访问
+    ~CuckooCache() override {
+      for (Bucket& bucket : buckets_) {
+        for (auto& item : bucket.items) {
+          destroyObject(alloc_, item.load(std::memory_order_relaxed));
+        }
+      }
+    }
+
+    allocator_type get_allocator() const { return alloc_; }
+
+    void put(Key key, Value value) override {
+      if (capacity_.load(std::memory_order_relaxed) == 0) {
+        return;
+      }
+      size_t hash = hashOf(key);
+      std::lock_guard<std::mutex> lock(writeMutex_);
+      Item* fresh = allocateObject<Item>(alloc_, hash, key, value);
+      trimLocked(kTrimPerOp);
+      size_t slot = locate(hash, key);
+      if (slot != SIZE_MAX) {
+        // 原地替换结点指针，tag不变，读者看到旧值或新值
+        Item* old = buckets_[slot / kWays].items[slot % kWays].exchange(fresh, std::memory_order_acq_rel);
+        retire(old);
+        return;
+      }
+      if (size_ > 0 && size_ >= capacity_.load(std::memory_order_relaxed)) {
+        evictOne();
+      }
+      size_t first = primaryBucket(hash);
+      size_t second = alternateBucket(first, tagOf(hash));
+      slot = makeRoom(first, second);
+      if (slot == SIZE_MAX) {
+        slot = evictFromCandidates(first, second);
+      }
+      place(slot / kWays, slot % kWays, fresh);
+      ++size_;
+    }
+
+    bool get(Key key, Value& value) override {
+      size_t hash = hashOf(key);
+      uint8_t tag = tagOf(hash);
+      size_t first = primaryBucket(hash);
+      size_t candidates[2] = {first, alternateBucket(first, tag)};
+      std::atomic<uint32_t>& version = versionOf(hash);
+      auto guard = reclaimer_.pin();
+      for (;;) {
+        uint32_t before = version.load(std::memory_order_acquire);
+        if (before & 1) {
+          std::this_thread::yield();  // 该key正被搬迁
+          continue;
+        }
+        const Item* hit = nullptr;
+        RefBit* hitBit = nullptr;
+        for (size_t bucket : candidates) {
+          for (size_t way = 0; way < kWays && !hitBit; ++way) {
+            if (buckets_[bucket].tags[way].load(std::memory_order_acquire) != tag) {
+              continue;
+            }
+            Item* item = buckets_[bucket].items[way].load(std::memory_order_acquire);
+            if (item && item->hash == hash && item->key == key) {
+              hit = item;
+              hitBit = &refBit(bucket, way);
+            }
+          }
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (version.load(std::memory_order_relaxed) != before) {
+          continue;
+        }
+        if (!hitBit) {
+          return false;
+        }
+        if (!hitBit->load(std::memory_order_relaxed)) {
+          hitBit->store(1, std::memory_order_relaxed);
+        }
+        value = hit->value;  // 版本确认后才写出：重试后未命中时调用方的value保持不变；结点不可变，epoch保护下不会被释放
+        return true;
+      }
+    }
+
+    Value get(Key key) override {
+      Value value{};
+      get(key, value);
+      return value;
+    }
+
+    bool remove(Key key) {
+      size_t hash = hashOf(key);
+      std::lock_guard<std::mutex> lock(writeMutex_);
+      size_t slot = locate(hash, key);
+      if (slot == SIZE_MAX) {
+        return false;
+      }
+      retire(clear(slot / kWays, slot % kWays));
+      --size_;
+      return true;
+    }
+
+    size_t size() {
+      std::lock_guard<std::mutex> lock(writeMutex_);
+      return size_;
+    }
+
+    // 在线调整容量：表的几何在构造时确定，容量不能增长到 slotCount() 之外，超出的请求被截断，返回实际生效的容量
+    // (占用率越高搬迁越容易失败、退化为候选桶内淘汰)；缩容超出的条目由后续put或 trim 分批淘汰
+    size_t setCapacity(size_t capacity) {
+      std::lock_guard<std::mutex> lock(writeMutex_);
+      size_t applied = std::min(capacity, slotCount());
+      capacity_.store(applied, std::memory_order_relaxed);
+      return applied;
+    }
+
+    size_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    // 淘汰至多 maxEvictions 个超出容量的条目，返回实际淘汰数
+    size_t trim(size_t maxEvictions) {
+      std::lock_guard<std::mutex> lock(writeMutex_);
+      return trimLocked(maxEvictions);
+    }
+
+    // 表的总路数；size()/slotCount() 即占用率
+    size_t slotCount() const { return buckets_.size() * kWays; }
+  };
+
+  namespace pmr {
+    template<typename Key, typename Value>
+    using CuckooCache = MyCache::CuckooCache<Key, Value, PmrAlloc>;
+  }
+} // namespace MyCache
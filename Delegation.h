@@ -0,0 +1,232 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CacheAllocator.h"
+#include "SpinWait.h"
+
+namespace MyCache {
+  // 异步请求的完成计数：批量提交时多个请求共用一个，全部执行完后 ready()
+  class Completion {
+  private:
+    std::atomic<uint32_t> remaining_;
+
+  public:
+    explicit Completion(uint32_t count = 1) : remaining_(count) {}
+
+    Completion(const Completion&) = delete;
+    Completion& operator=(const Completion&) = delete;
+
+    void arrive() { remaining_.fetch_sub(1, std::memory_order_release); }
+    bool ready() const { return remaining_.load(std::memory_order_acquire) == 0; }
+
+    void wait() const {
+      SpinWait spin;
+      while (!ready()) {
+        spin.wait();
+      }
+    }
+  };
+
+  // 有界多生产者单消费者队列(Vyukov)：每个单元带序号，生产者CAS抢占尾位置，消费者独占头位置
+  // 单元数组来自 Alloc(字节分配器，内部rebind)
+  template<typename T, typename Alloc = DefaultAlloc>
+  class MpscQueue {
+  private:
+    struct alignas(64) Cell {
+      std::atomic<size_t> sequence;
+      T data;
+    };
+
+    std::vector<Cell, RebindAlloc<Alloc, Cell>> cells_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> tail_;  // 生产者
+    alignas(64) size_t head_;               // 仅消费者访问
+
+    static size_t roundUp(size_t capacity) {
+      size_t size = 2;
+      while (size < capacity) {
+        size <<= 1;
+      }
+      return size;
+    }
+
+  public:
+    // capacity取整为2的幂
+    explicit MpscQueue(size_t capacity, const Alloc& alloc = Alloc())
+      : cells_(roundUp(capacity), RebindAlloc<Alloc, Cell>(alloc)), mask_(cells_.size() - 1), tail_(0), head_(0) {
+      for (size_t i = 0; i < cells_.size(); ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    bool tryPush(T&& value) {
+      size_t pos = tail_.load(std::memory_order_relaxed);
+      for (;;) {
+        Cell& cell = cells_[pos & mask_];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+          if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+            cell.data = std::move(value);
+            cell.sequence.store(pos + 1, std::memory_order_release);
+            return true;
+          }
+        } else if (diff < 0) {
+          return false;  // 队列已满
+        } else {
+          pos = tail_.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    bool tryPop(T& value) {
+      Cell& cell = cells_[head_ & mask_];
+      if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+        return false;
+      }
+      value = std::move(cell.data);
+      cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+      ++head_;
+      return true;
+    }
+  };
+
+  // 分片属主线程：分片只由这一个线程访问，其他线程通过MPSC队列提交请求，分片因此可以不带锁(NullLock)
+  // 同一生产者提交到同一分片的请求按提交顺序执行
+  // 请求队列的单元数组来自 Alloc，与分片所在的缓存用同一个分配器
+  template<typename Shard, typename Key, typename Value, typename Alloc = DefaultAlloc>
+  class ShardOwner {
+  public:
+    enum class OpKind : uint8_t { Get, Put, Run };
+
+    struct Op {
+      OpKind kind = OpKind::Get;
+      Key key{};
+      Value value{};
+      Value* out = nullptr;         // Get：结果写到这里
+      bool* found = nullptr;        // Get：是否命中
+      void (*run)(Shard&, void*) = nullptr;  // Run：在属主线程上执行 run(shard, context)
+      void* context = nullptr;
+      Completion* done = nullptr;   // 可为空(不关心完成时间的Put)
+    };
+
+  private:
+    static constexpr size_t kBatch = 64;                        // 每轮最多处理的请求数
+    static constexpr auto kIdleWait = std::chrono::milliseconds(1);
+
+    Shard& shard_;
+    MpscQueue<Op, Alloc> queue_;
+    std::atomic<bool> stop_;
+    std::atomic<bool> sleeping_;
+    std::mutex sleepMutex_;
+    std::condition_variable wakeup_;
+    std::thread worker_;
+
+    void apply(Op& op) {
+      if (op.kind == OpKind::Put) {
+        shard_.put(op.key, op.value);
+      } else if (op.kind == OpKind::Get) {
+        *op.found = shard_.get(op.key, *op.out);
+      } else {
+        op.run(shard_, op.context);
+      }
+      if (op.done) {
+        op.done->arrive();
+      }
+    }
+
+    void run() {
+      Op op;
+      SpinWait spin;
+      for (;;) {
+        size_t handled = 0;
+        while (handled < kBatch && queue_.tryPop(op)) {
+          apply(op);
+          ++handled;
+        }
+        if (handled > 0) {
+          spin.reset();
+          continue;
+        }
+        if (stop_.load(std::memory_order_acquire)) {
+          return;
+        }
+        if (spin.rounds() < 128) {
+          spin.wait();
+          continue;
+        }
+        // 长时间空闲：睡眠等待唤醒，超时兜底防止错过通知
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleeping_.store(true, std::memory_order_seq_cst);
+        if (!queue_.tryPop(op)) {
+          wakeup_.wait_for(lock, kIdleWait);
+          sleeping_.store(false, std::memory_order_relaxed);
+          spin.reset();
+          continue;
+        }
+        sleeping_.store(false, std::memory_order_relaxed);
+        lock.unlock();
+        apply(op);
+        spin.reset();
+      }
+    }
+
+  public:
+    ShardOwner(Shard& shard, const Alloc& alloc = Alloc(), size_t queueCapacity = 4096)
+      : shard_(shard), queue_(queueCapacity, alloc), stop_(false), sleeping_(false) {
+      worker_ = std::thread(&ShardOwner::run, this);
+    }
+
+    ShardOwner(const ShardOwner&) = delete;
+    ShardOwner& operator=(const ShardOwner&) = delete;
+
+    // 已提交的请求全部执行完才退出
+    ~ShardOwner() {
+      stop_.store(true, std::memory_order_release);
+      {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        wakeup_.notify_one();
+      }
+      worker_.join();
+    }
+
+    // 在属主线程上执行 f(shard) 并等待完成：调容量、裁剪、重新分片的搬移等管理操作都经此进入分片，
+    // 分片始终只被属主线程访问。排在调用前已提交的请求之后执行，因此也可用作屏障。
+    // 不得在属主线程内调用(如在淘汰回调里)，否则永远等不到
+    template<typename F>
+    void execute(F&& f) {
+      using Func = std::remove_reference_t<F>;
+      Completion done;
+      Op op;
+      op.kind = OpKind::Run;
+      op.run = [](Shard& shard, void* context) { (*static_cast<Func*>(context))(shard); };
+      op.context = const_cast<void*>(static_cast<const void*>(std::addressof(f)));
+      op.done = &done;
+      submit(std::move(op));
+      done.wait();
+    }
+
+    // 队列满时退避重试
+    void submit(Op&& op) {
+      SpinWait spin;
+      while (!queue_.tryPush(std::move(op))) {
+        spin.wait();
+      }
+      if (sleeping_.load(std::memory_order_seq_cst)) {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        wakeup_.notify_one();
+      }
+    }
+  };
+} // namespace MyCache
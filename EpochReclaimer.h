@@ -0,0 +1,305 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "CacheAllocator.h"
+#include "SpinWait.h"
+
+namespace MyCache {
+  namespace detail {
+    // 已存活的回收器编号；线程退出时据此判断其记录是否还能归还
+    inline std::mutex& reclaimerRegistryMutex() {
+      static std::mutex mutex;
+      return mutex;
+    }
+
+    inline std::unordered_set<uint64_t>& liveReclaimers() {
+      static std::unordered_set<uint64_t> ids;
+      return ids;
+    }
+
+    // 线程在某个回收器中占用的记录
+    struct ThreadReclaimerEntry {
+      uint64_t reclaimerId;
+      std::atomic<bool>* inUse;  // 记录的占用标志
+      void* record;
+    };
+
+    struct ThreadReclaimerRecords {
+      std::vector<ThreadReclaimerEntry> entries;
+
+      ~ThreadReclaimerRecords() {
+        std::lock_guard<std::mutex> lock(reclaimerRegistryMutex());
+        for (auto& entry : entries) {
+          if (liveReclaimers().count(entry.reclaimerId)) {
+            entry.inUse->store(false, std::memory_order_release);  // 记录留给之后的线程复用
+          }
+        }
+      }
+    };
+
+    inline ThreadReclaimerRecords& threadReclaimerRecords() {
+      thread_local ThreadReclaimerRecords records;
+      return records;
+    }
+  } // namespace detail
+
+  // 线程在回收器中公布的读侧状态；与分配器无关，读侧守卫只依赖它
+  struct EpochPin {
+    static constexpr uint64_t kInactive = UINT64_MAX;
+
+    std::atomic<uint64_t> localEpoch{kInactive};
+    uint32_t nesting = 0;  // 仅所属线程访问
+
+    void unpin() {
+      if (--nesting == 0) {
+        localEpoch.store(kInactive, std::memory_order_release);
+      }
+    }
+  };
+
+  // 读侧临界区：存活期间读到的对象不会被释放；可嵌套
+  class EpochGuard {
+  private:
+    EpochPin* pin_;
+
+  public:
+    EpochGuard() : pin_(nullptr) {}
+    explicit EpochGuard(EpochPin* pin) : pin_(pin) {}
+    EpochGuard(EpochGuard&& other) noexcept : pin_(other.pin_) { other.pin_ = nullptr; }
+    EpochGuard& operator=(EpochGuard&& other) noexcept {
+      if (this != &other) {
+        release();
+        pin_ = other.pin_;
+        other.pin_ = nullptr;
+      }
+      return *this;
+    }
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+    ~EpochGuard() { release(); }
+
+    void release() {
+      if (pin_) {
+        pin_->unpin();
+        pin_ = nullptr;
+      }
+    }
+  };
+
+  // 基于epoch的内存回收(EBR)
+  // 读者进入临界区时公布当前全局epoch(pin)，离开时撤销；写者摘下对象后retire，
+  // 等全局epoch前进两次(所有活跃读者都已越过摘除时刻)再真正释放。读路径没有引用计数
+  // 对象可以由任意线程retire；退出线程遗留的待回收对象随记录复用或回收器析构时释放
+  // Alloc：各线程的记录与待回收列表的来源(字节分配器，内部rebind)，与所在缓存相同，须线程安全；
+  // 线程到记录的登记表(thread_local)属于线程而非缓存，固定走全局堆
+  template<typename Alloc = DefaultAlloc>
+  class EpochReclaimer {
+  public:
+    using Deleter = void (*)(void* context, void* object);
+    using Guard = EpochGuard;
+
+  private:
+    static constexpr uint64_t kInactive = EpochPin::kInactive;
+    static constexpr size_t kRetireThreshold = 64;  // 每积累这么多待回收对象尝试推进一次epoch
+
+    struct Retired {
+      void* object;
+      Deleter deleter;
+      void* context;
+      uint64_t epoch;
+    };
+
+    using RetiredList = std::vector<Retired, RebindAlloc<Alloc, Retired>>;
+
+    struct alignas(64) Record : EpochPin {
+      std::atomic<bool> inUse{true};
+      RetiredList retired;   // 仅所属线程访问
+      Record* next = nullptr;
+
+      explicit Record(const Alloc& alloc) : retired(RebindAlloc<Alloc, Retired>(alloc)) {}
+    };
+
+    Alloc alloc_;
+    alignas(64) std::atomic<uint64_t> globalEpoch_{1};
+    std::atomic<Record*> records_{nullptr};
+    uint64_t id_;
+
+    static std::atomic<uint64_t>& nextId() {
+      static std::atomic<uint64_t> id{1};
+      return id;
+    }
+
+    Record* acquireRecord() {
+      for (Record* r = records_.load(std::memory_order_acquire); r; r = r->next) {
+        bool expected = false;
+        if (!r->inUse.load(std::memory_order_relaxed) &&
+            r->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+          return r;
+        }
+      }
+      Record* r = allocateObject<Record>(alloc_, alloc_);
+      Record* head = records_.load(std::memory_order_relaxed);
+      do {
+        r->next = head;
+      } while (!records_.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+      return r;
+    }
+
+    // 当前线程在本回收器中的记录，首次访问时领取
+    Record* localRecord() {
+      auto& records = detail::threadReclaimerRecords();
+      for (auto& entry : records.entries) {
+        if (entry.reclaimerId == id_) {
+          return static_cast<Record*>(entry.record);
+        }
+      }
+      Record* r = acquireRecord();
+      std::lock_guard<std::mutex> lock(detail::reclaimerRegistryMutex());
+      // 顺带清掉已析构回收器的条目，避免反复创建缓存的线程里条目无限增长
+      auto& live = detail::liveReclaimers();
+      records.entries.erase(std::remove_if(records.entries.begin(), records.entries.end(),
+                                           [&live](const auto& entry) { return !live.count(entry.reclaimerId); }),
+                            records.entries.end());
+      records.entries.push_back(detail::ThreadReclaimerEntry{id_, &r->inUse, r});
+      return r;
+    }
+
+    // 所有活跃读者都已看到当前epoch时才能前进
+    bool tryAdvance() {
+      uint64_t epoch = globalEpoch_.load(std::memory_order_seq_cst);
+      for (Record* r = records_.load(std::memory_order_acquire); r; r = r->next) {
+        uint64_t local = r->localEpoch.load(std::memory_order_seq_cst);
+        if (local != kInactive && local != epoch) {
+          return false;
+        }
+      }
+      return globalEpoch_.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+    }
+
+    static void collect(Record* r, uint64_t epoch) {
+      auto safe = std::partition(r->retired.begin(), r->retired.end(),
+                                 [epoch](const Retired& item) { return item.epoch + 2 > epoch; });
+      for (auto it = safe; it != r->retired.end(); ++it) {
+        it->deleter(it->context, it->object);
+      }
+      r->retired.erase(safe, r->retired.end());
+    }
+
+  public:
+    explicit EpochReclaimer(const Alloc& alloc = Alloc()) : alloc_(alloc) {
+      std::lock_guard<std::mutex> lock(detail::reclaimerRegistryMutex());
+      id_ = nextId().fetch_add(1, std::memory_order_relaxed);
+      detail::liveReclaimers().insert(id_);
+    }
+
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+    // 析构时不得再有读者或写者使用本回收器
+    ~EpochReclaimer() {
+      {
+        std::lock_guard<std::mutex> lock(detail::reclaimerRegistryMutex());
+        detail::liveReclaimers().erase(id_);
+      }
+      drain();
+      Record* r = records_.load(std::memory_order_acquire);
+      while (r) {
+        Record* next = r->next;
+        destroyObject(alloc_, r);
+        r = next;
+      }
+    }
+
+    Guard pin() {
+      Record* r = localRecord();
+      if (r->nesting++ == 0) {
+        r->localEpoch.store(globalEpoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+      }
+      return Guard(r);
+    }
+
+    // 对象已从共享结构摘下后调用；释放推迟到所有可能持有它的读者离开之后
+    void retire(void* object, Deleter deleter, void* context) {
+      Record* r = localRecord();
+      r->retired.push_back(Retired{object, deleter, context, globalEpoch_.load(std::memory_order_seq_cst)});
+      if (r->retired.size() >= kRetireThreshold) {
+        tryAdvance();
+        collect(r, globalEpoch_.load(std::memory_order_acquire));
+      }
+    }
+
+    template<typename T>
+    void retire(T* object) {
+      retire(object, [](void*, void* p) { delete static_cast<T*>(p); }, nullptr);
+    }
+
+    // 等待一个宽限期：调用前已进入临界区的读者全部离开后返回，用于同步地替换、释放整个结构
+    // 返回前顺带释放本线程在调用前retire的对象(它们已过宽限期)，不必等到下一次积累满 kRetireThreshold
+    // 调用线程自身不得处于本回收器的临界区内，否则永远等不到
+    void synchronize() {
+      uint64_t target = globalEpoch_.load(std::memory_order_seq_cst) + 2;
+      SpinWait spin;
+      while (globalEpoch_.load(std::memory_order_seq_cst) < target) {
+        if (!tryAdvance()) {
+          spin.wait();
+        }
+      }
+      collect(localRecord(), globalEpoch_.load(std::memory_order_acquire));
+    }
+
+    // 本线程尚未释放的待回收对象数
+    size_t pendingRetired() {
+      return localRecord()->retired.size();
+    }
+
+    // 立即释放所有待回收对象：仅在确认没有并发读者时调用(如析构、清空)
+    void drain() {
+      for (Record* r = records_.load(std::memory_order_acquire); r; r = r->next) {
+        for (const Retired& item : r->retired) {
+          item.deleter(item.context, item.object);
+        }
+        r->retired.clear();
+      }
+    }
+
+    uint64_t epoch() const { return globalEpoch_.load(std::memory_order_relaxed); }
+  };
+
+  // 零拷贝读取的结果：持有epoch临界区，期间指向的对象即使被并发替换/淘汰也不会释放
+  // 读路径没有引用计数；持有时间应尽量短，长期持有会推迟所有回收
+  template<typename T>
+  class PinnedPtr {
+  private:
+    EpochGuard guard_;
+    T* ptr_;
+
+  public:
+    PinnedPtr() : ptr_(nullptr) {}
+    PinnedPtr(EpochGuard&& guard, T* ptr) : guard_(std::move(guard)), ptr_(ptr) {
+      if (!ptr_) {
+        guard_.release();
+      }
+    }
+
+    PinnedPtr(PinnedPtr&&) noexcept = default;
+    PinnedPtr& operator=(PinnedPtr&&) noexcept = default;
+
+    T* get() const { return ptr_; }
+    T& operator*() const { return *ptr_; }
+    T* operator->() const { return ptr_; }
+    explicit operator bool() const { return ptr_ != nullptr; }
+
+    void reset() {
+      ptr_ = nullptr;
+      guard_.release();
+    }
+  };
+} // namespace MyCache
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <type_traits>
+
+#include "SpinWait.h"
+
+namespace MyCache {
+  // 扁平合并(flat combining)：线程把操作挂到发布槽，抢到合并锁的线程替所有人批量执行
+  // 目标结构(链表头、索引)只在合并者的核上被访问，避免锁和数据的cache line在核间来回传递
+  // 被合并的操作在合并者线程上执行，不能依赖调用线程的 thread_local 状态
+  template<typename Target>
+  class FlatCombiner {
+  public:
+    static constexpr size_t kSlots = 32;
+
+  private:
+    enum : uint32_t { kFree = 0, kClaimed = 1, kPending = 2, kDone = 3 };
+
+    struct alignas(64) Request {
+      std::atomic<uint32_t> state{kFree};
+      void (*invoke)(void* context, Target& target) = nullptr;
+      void* context = nullptr;  // 指向发起线程栈上的调用，发起线程等到kDone才返回
+    };
+
+    // 把任意可调用对象包装成发布槽可保存的函数指针+上下文，异常带回发起线程
+    template<typename Func>
+    struct Call {
+      Func* func;
+      std::exception_ptr error;
+
+      static void invoke(void* context, Target& target) {
+        Call* self = static_cast<Call*>(context);
+        try {
+          (*self->func)(target);
+        } catch (...) {
+          self->error = std::current_exception();
+        }
+      }
+    };
+
+    Target& target_;
+    alignas(64) std::atomic<bool> combining_{false};
+    std::atomic<uint32_t> pending_{0};  // 已挂上未执行的请求数，无竞争时据此跳过扫描
+    Request requests_[kSlots];
+
+    bool tryLock() {
+      return !combining_.load(std::memory_order_relaxed) && !combining_.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() {
+      combining_.store(false, std::memory_order_release);
+    }
+
+    // passes>1 时合并期间新挂上的请求也顺带执行
+    void combine(int passes) {
+      for (int pass = 0; pass < passes; ++pass) {
+        for (Request& request : requests_) {
+          if (request.state.load(std::memory_order_acquire) == kPending) {
+            request.invoke(request.context, target_);
+            request.state.store(kDone, std::memory_order_release);
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+          }
+        }
+      }
+    }
+
+    Request* claim() {
+      size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % kSlots;
+      for (size_t i = 0; i < kSlots; ++i) {
+        Request& request = requests_[(start + i) % kSlots];
+        uint32_t expected = kFree;
+        if (request.state.load(std::memory_order_relaxed) == kFree &&
+            request.state.compare_exchange_strong(expected, kClaimed, std::memory_order_acquire)) {
+          return &request;
+        }
+      }
+      return nullptr;
+    }
+
+  public:
+    explicit FlatCombiner(Target& target) : target_(target) {}
+
+    FlatCombiner(const FlatCombiner&) = delete;
+    FlatCombiner& operator=(const FlatCombiner&) = delete;
+
+    // 在合并者线程上执行 func(target)，返回时已执行完毕；结果通过func捕获的引用带回
+    template<typename Func>
+    void execute(Func&& func) {
+      using CallType = Call<std::remove_reference_t<Func>>;
+      CallType call{&func, nullptr};
+      SpinWait spin;
+      Request* request = nullptr;
+      // 无竞争时直接抢到锁，省去发布与等待
+      bool locked = tryLock();
+      if (!locked) {
+        request = claim();
+        if (!request) {
+          // 发布槽用尽：等锁后自己执行
+          while (!tryLock()) {
+            spin.wait();
+          }
+          locked = true;
+        }
+      }
+      if (locked) {
+        CallType::invoke(&call, target_);
+        if (pending_.load(std::memory_order_relaxed)) {
+          combine(1);  // 顺带执行其他线程已挂上的请求
+        }
+        unlock();
+      } else {
+        request->invoke = &CallType::invoke;
+        request->context = &call;
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        request->state.store(kPending, std::memory_order_release);
+        while (request->state.load(std::memory_order_acquire) != kDone) {
+          if (tryLock()) {
+            combine(2);
+            unlock();
+          } else {
+            spin.wait();
+          }
+        }
+        request->state.store(kFree, std::memory_order_release);
+      }
+      if (call.error) {
+        std::rethrow_exception(call.error);
+      }
+    }
+  };
+} // namespace MyCache
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CacheAllocator.h"
+
+namespace MyCache {
+  // 热点key复制的参数
+  struct HotKeyOptions {
+    size_t hotCapacity = 64;     // 无锁热点集合的容量(按8路桶向上取整)
+    uint32_t sampleRate = 64;    // 每个线程每 sampleRate 次读取采样一次，其余读取优先查热点集合
+    uint32_t threshold = 16;     // 一个衰减周期内被采样到这么多次即视为热点
+    uint32_t decayPeriod = 4096; // 每累计这么多次采样，所有计数减半
+  };
+
+  // 采样计数的热点检测：按哈希落到固定数量的计数器上(类似单行的Count-Min)，碰撞只会造成误判为热点
+  // 误判的代价只是多一份副本，因此不做精确计数
+  template<typename Alloc = DefaultAlloc>
+  class HotKeyDetector {
+  private:
+    static constexpr size_t kCounters = 1024;
+
+    using Counter = std::atomic<uint32_t>;
+
+    uint32_t threshold_;
+    uint32_t decayPeriod_;
+    std::vector<Counter, RebindAlloc<Alloc, Counter>> counters_;
+    std::atomic<uint32_t> samples_;
+
+    void decay() {
+      for (Counter& counter : counters_) {
+        counter.store(counter.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+      }
+    }
+
+  public:
+    HotKeyDetector(uint32_t threshold, uint32_t decayPeriod, const Alloc& alloc = Alloc())
+      : threshold_(threshold > 0 ? threshold : 1), decayPeriod_(decayPeriod > 0 ? decayPeriod : 1)
+      , counters_(kCounters, RebindAlloc<Alloc, Counter>(alloc)), samples_(0) {}
+
+    // 记录一次采样，返回该哈希当前是否达到热点门槛
+    bool record(size_t hash) {
+      if (samples_.fetch_add(1, std::memory_order_relaxed) % decayPeriod_ == decayPeriod_ - 1) {
+        decay();  // 与并发的计数交错只会让结果略有偏差
+      }
+      uint64_t mixed = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+      Counter& counter = counters_[(mixed >> 32) % kCounters];
+      return counter.fetch_add(1, std::memory_order_relaxed) + 1 >= threshold_;
+    }
+  };
+
+  // 每个线程各自的采样节拍，不共享任何写入
+  inline bool sampleThisRead(uint32_t sampleRate) {
+    thread_local uint32_t tick = 0;
+    return sampleRate <= 1 || ++tick % sampleRate == 0;
+  }
+} // namespace MyCache
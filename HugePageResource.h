@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace MyCache {
+  struct HugePageOptions {
+    size_t regionBytes = size_t(64) << 20;  // 每次向系统申请的区域大小(按2MB取整)
+    size_t prefaultBytes = 0;               // 构造时预先映射并触碰的字节数，避免运行时缺页
+    bool useHugetlb = true;                 // 优先尝试 MAP_HUGETLB(需预留大页)，失败再退回透明大页
+  };
+
+  // 按2MB大页对齐向系统申请区域，区域内单调分配；单个deallocate不归还，析构时整体释放
+  // 超过区域1/4的大请求单独映射，不占用当前区域；小请求放不下时换新区域，旧区域剩余的尾部不再使用，
+  // 计入 abandonedBytes()(大页是有限资源，可据此调整 regionBytes)
+  // 加锁：可被多个分片(各自持有不同的锁)同时使用
+  class HugePageRegionResource : public std::pmr::memory_resource {
+  public:
+    static constexpr size_t kHugePageSize = size_t(2) << 20;
+
+    enum class Backing { Hugetlb, TransparentHugePage, Regular };
+
+  private:
+    struct Region {
+      char* base;
+      size_t bytes;
+      Backing backing;
+    };
+
+    HugePageOptions options_;
+    std::mutex mutex_;
+    std::vector<Region> regions_;
+    char* cursor_;
+    char* end_;
+    size_t mappedBytes_;
+    size_t hugetlbBytes_;
+    size_t thpBytes_;
+    size_t abandonedBytes_;  // 换区域时旧区域剩下未用的字节数
+
+    static size_t roundUp(size_t bytes, size_t align) {
+      return (bytes + align - 1) / align * align;
+    }
+
+    Region mapRegion(size_t bytes) {
+#if defined(__linux__)
+#if defined(MAP_HUGETLB)
+      if (options_.useHugetlb) {
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+          return Region{static_cast<char*>(p), bytes, Backing::Hugetlb};
+        }
+      }
+#endif
+      // 多映射一个大页，裁掉首尾使区域按2MB对齐，透明大页才能整页映射
+      size_t padded = bytes + kHugePageSize;
+      void* raw = ::mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (raw == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      char* begin = static_cast<char*>(raw);
+      char* aligned = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(begin), kHugePageSize));
+      if (aligned > begin) {
+        ::munmap(begin, aligned - begin);
+      }
+      char* tail = aligned + bytes;
+      char* rawEnd = begin + padded;
+      if (rawEnd > tail) {
+        ::munmap(tail, rawEnd - tail);
+      }
+      Backing backing = Backing::Regular;
+#if defined(MADV_HUGEPAGE)
+      if (::madvise(aligned, bytes, MADV_HUGEPAGE) == 0) {
+        backing = Backing::TransparentHugePage;
+      }
+#endif
+      return Region{aligned, bytes, backing};
+#else
+      char* p = static_cast<char*>(::operator new(bytes, std::align_val_t(kHugePageSize)));
+      return Region{p, bytes, Backing::Regular};
+#endif
+    }
+
+    static void unmapRegion(const Region& region) {
+#if defined(__linux__)
+      ::munmap(region.base, region.bytes);
+#else
+      ::operator delete(region.base, std::align_val_t(kHugePageSize));
+#endif
+    }
+
+    Region recordRegion(size_t bytes) {
+      Region region = mapRegion(bytes);
+      regions_.push_back(region);
+      mappedBytes_ += bytes;
+      if (region.backing == Backing::Hugetlb) {
+        hugetlbBytes_ += bytes;
+      } else if (region.backing == Backing::TransparentHugePage) {
+        thpBytes_ += bytes;
+      }
+      return region;
+    }
+
+    void addRegion(size_t minBytes) {
+      Region region = recordRegion(roundUp(std::max(minBytes, options_.regionBytes), kHugePageSize));
+      abandonedBytes_ += static_cast<size_t>(end_ - cursor_);
+      cursor_ = region.base;
+      end_ = region.base + region.bytes;
+    }
+
+    bool isLarge(size_t bytes) const {
+      return bytes > options_.regionBytes / 4;
+    }
+
+  public:
+    explicit HugePageRegionResource(const HugePageOptions& options = HugePageOptions())
+      : options_(options), cursor_(nullptr), end_(nullptr), mappedBytes_(0), hugetlbBytes_(0), thpBytes_(0)
+      , abandonedBytes_(0) {
+      if (options_.prefaultBytes > 0) {
+        prefault(options_.prefaultBytes);
+      }
+    }
+
+    HugePageRegionResource(const HugePageRegionResource&) = delete;
+    HugePageRegionResource& operator=(const HugePageRegionResource&) = delete;
+
+    ~HugePageRegionResource() override {
+      for (const Region& region : regions_) {
+        unmapRegion(region);
+      }
+    }
+
+    // 确保当前区域至少还有bytes可用，并逐页写入一次，让缺页在启动阶段完成
+    // 当前区域不够时换新区域，旧区域的剩余计入 abandonedBytes()
+    void prefault(size_t bytes) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (static_cast<size_t>(end_ - cursor_) < bytes) {
+        addRegion(bytes);
+      }
+      for (char* p = cursor_; p < cursor_ + bytes; p += 4096) {
+        *reinterpret_cast<volatile char*>(p) = 0;
+      }
+    }
+
+    size_t mappedBytes() const { return mappedBytes_; }
+    size_t hugetlbBytes() const { return hugetlbBytes_; }
+    size_t transparentHugePageBytes() const { return thpBytes_; }
+    size_t abandonedBytes() const { return abandonedBytes_; }
+
+  protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (isLarge(bytes + alignment)) {
+        Region region = recordRegion(roundUp(bytes + alignment, kHugePageSize));
+        return reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(region.base), alignment));
+      }
+      char* p = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(cursor_), alignment));
+      if (!cursor_ || p + bytes > end_) {
+        addRegion(bytes + alignment);
+        p = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(cursor_), alignment));
+      }
+      cursor_ = p + bytes;
+      return p;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+  };
+
+  // 供引擎直接使用的大页内存资源：池化分配器复用释放的结点，底层区域来自 HugePageRegionResource
+  // 用法：
+  //   MyCache::HugePageOptions options;
+  //   options.prefaultBytes = size_t(1) << 30;
+  //   MyCache::HugePageResource hugePages(options);
+  //   MyCache::pmr::LruCache<int, std::string> cache(capacity, &hugePages);
+  class HugePageResource : public std::pmr::memory_resource {
+  private:
+    HugePageRegionResource regions_;
+    std::pmr::synchronized_pool_resource pool_;
+
+  public:
+    explicit HugePageResource(const HugePageOptions& options = HugePageOptions())
+      : regions_(options), pool_(&regions_) {}
+
+    HugePageRegionResource& regions() { return regions_; }
+
+  protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+      return pool_.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+      pool_.deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+  };
+} // namespace MyCache
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CacheAllocator.h"
+
+namespace MyCache {
+  // 驻留的字符串key：缓存好的哈希值与key内容连续存放，每个key只存一份
+  struct InternedKey {
+    size_t hash;
+    uint32_t size;
+
+    const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+    std::string_view view() const { return std::string_view(data(), size); }
+  };
+
+  // 字符串key的分配区：按16字节对齐分级，释放的块挂回对应空闲链表复用，超长key单独分配
+  template<typename Alloc = DefaultAlloc>
+  class KeyArena {
+  public:
+    static constexpr size_t kAlign = 16;
+    static constexpr size_t kMaxPooled = 512;       // 超过该长度的key不走分级复用
+    static constexpr size_t kChunkSize = 64 * 1024;
+  private:
+    struct FreeBlock {
+      FreeBlock* next;
+    };
+
+    // 块与超长key都按 max_align_t 为单位向分配器申请，保证16字节对齐
+    using Unit = std::max_align_t;
+    using UnitAlloc = RebindAlloc<Alloc, Unit>;
+    static constexpr size_t kChunkUnits = kChunkSize / sizeof(Unit);
+
+    UnitAlloc alloc_;
+    std::vector<Unit*, RebindAlloc<Alloc, Unit*>> chunks_;
+    char* cursor_;
+    char* end_;
+    FreeBlock* freeLists_[kMaxPooled / kAlign + 1];
+
+    static size_t blockSize(size_t keySize) {
+      return (sizeof(InternedKey) + keySize + kAlign - 1) / kAlign * kAlign;
+    }
+
+    static size_t units(size_t bytes) {
+      return (bytes + sizeof(Unit) - 1) / sizeof(Unit);
+    }
+
+    void* allocate(size_t bytes) {
+      if (bytes > kMaxPooled) {
+        return std::allocator_traits<UnitAlloc>::allocate(alloc_, units(bytes));
+      }
+      FreeBlock*& head = freeLists_[bytes / kAlign];
+      if (head) {
+        FreeBlock* block = head;
+        head = block->next;
+        return block;
+      }
+      if (static_cast<size_t>(end_ - cursor_) < bytes) {
+        chunks_.push_back(std::allocator_traits<UnitAlloc>::allocate(alloc_, kChunkUnits));
+        cursor_ = reinterpret_cast<char*>(chunks_.back());
+        end_ = cursor_ + kChunkSize;
+      }
+      void* mem = cursor_;
+      cursor_ += bytes;
+      return mem;
+    }
+
+  public:
+    explicit KeyArena(const Alloc& alloc = Alloc())
+      : alloc_(alloc), chunks_(RebindAlloc<Alloc, Unit*>(alloc)), cursor_(nullptr), end_(nullptr) {
+      std::fill(std::begin(freeLists_), std::end(freeLists_), nullptr);
+    }
+
+    KeyArena(const KeyArena&) = delete;
+    KeyArena& operator=(const KeyArena&) = delete;
+
+    ~KeyArena() { clear(); }
+
+    const InternedKey* intern(std::string_view key, size_t hash) {
+      void* mem = allocate(blockSize(key.size()));
+      InternedKey* interned = new (mem) InternedKey{hash, static_cast<uint32_t>(key.size())};
+      std::memcpy(interned + 1, key.data(), key.size());
+      return interned;
+    }
+
+    void release(const InternedKey* key) {
+      size_t bytes = blockSize(key->size);
+      void* mem = const_cast<InternedKey*>(key);
+      if (bytes > kMaxPooled) {
+        std::allocator_traits<UnitAlloc>::deallocate(alloc_, static_cast<Unit*>(mem), units(bytes));
+        return;
+      }
+      FreeBlock* block = static_cast<FreeBlock*>(mem);
+      block->next = freeLists_[bytes / kAlign];
+      freeLists_[bytes / kAlign] = block;
+    }
+
+    // 仅归还分级区域；超长key须由调用方逐个release
+    void clear() {
+      for (Unit* chunk : chunks_) {
+        std::allocator_traits<UnitAlloc>::deallocate(alloc_, chunk, kChunkUnits);
+      }
+      chunks_.clear();
+      cursor_ = end_ = nullptr;
+      std::fill(std::begin(freeLists_), std::end(freeLists_), nullptr);
+    }
+  };
+
+  // 字符串key索引：开放寻址(线性探测)，表项里缓存哈希值并引用KeyArena中唯一的一份key
+  // 引擎结点保存 const InternedKey*，按结点删除时直接用缓存的哈希定位、按指针比较，不再哈希也不拷贝字符串
+  // find返回的指针在下一次insert/erase之前有效
+  // 所有权：驻留的key归索引所有。insert返回的KeyRef一直有效，直到该key被erase(按key或按KeyRef)或clear；
+  // 之后块立即回到空闲链表，下一个同样大小的key会复用它，旧KeyRef及其view()都成了悬空引用。
+  // 删除后还需要key内容的调用方(摘下结点、淘汰回调、转入另一个索引)须在erase之前用 KeyRefTraits::toKey 拷出
+  template<typename Mapped, typename Alloc = DefaultAlloc>
+  class InternedKeyIndex {
+  public:
+    using KeyRef = const InternedKey*;
+  private:
+    static constexpr size_t kMinBuckets = 16;
+
+    struct Entry {
+      size_t hash = 0;
+      KeyRef key = nullptr;  // nullptr表示空位
+      Mapped mapped{};
+    };
+
+    using Table = std::vector<Entry, RebindAlloc<Alloc, Entry>>;
+
+    Table table_;
+    size_t size_;
+    KeyArena<Alloc> arena_;
+
+    static size_t hashOf(std::string_view key) {
+      return std::hash<std::string_view>()(key);
+    }
+
+    size_t mask() const { return table_.size() - 1; }
+
+    // 返回key所在位置，不存在时返回table_.size()
+    size_t locate(std::string_view key, size_t hash) const {
+      if (table_.empty()) {
+        return 0;
+      }
+      for (size_t i = hash & mask(); table_[i].key; i = (i + 1) & mask()) {
+        if (table_[i].hash == hash && table_[i].key->view() == key) {
+          return i;
+        }
+      }
+      return table_.size();
+    }
+
+    void rehash(size_t buckets) {
+      Table old(buckets, table_.get_allocator());
+      old.swap(table_);
+      for (Entry& entry : old) {
+        if (!entry.key) {
+          continue;
+        }
+        size_t i = entry.hash & mask();
+        while (table_[i].key) {
+          i = (i + 1) & mask();
+        }
+        table_[i] = std::move(entry);  // 使用缓存的哈希值，无需重新哈希字符串
+      }
+    }
+
+    // 删除位置i的表项，并把后续探测链上的表项前移填补空位(无墓碑)
+    void eraseAt(size_t i) {
+      arena_.release(table_[i].key);
+      for (size_t j = (i + 1) & mask(); table_[j].key; j = (j + 1) & mask()) {
+        size_t ideal = table_[j].hash & mask();
+        if (((j - ideal) & mask()) >= ((j - i) & mask())) {
+          table_[i] = std::move(table_[j]);
+          i = j;
+        }
+      }
+      table_[i] = Entry();
+      --size_;
+    }
+
+  public:
+    explicit InternedKeyIndex(const Alloc& alloc = Alloc())
+      : table_(RebindAlloc<Alloc, Entry>(alloc)), size_(0), arena_(alloc) {}
+
+    ~InternedKeyIndex() { clear(); }
+
+    Mapped* find(const std::string& key) {
+      if (size_ == 0) {
+        return nullptr;
+      }
+      size_t i = locate(key, hashOf(key));
+      return i == table_.size() ? nullptr : &table_[i].mapped;
+    }
+
+    // 按结点保存的引用查找：缓存的哈希定位，指针比较
+    Mapped* find(KeyRef ref) {
+      if (size_ == 0 || !ref) {
+        return nullptr;
+      }
+      for (size_t i = ref->hash & mask(); table_[i].key; i = (i + 1) & mask()) {
+        if (table_[i].key == ref) {
+          return &table_[i].mapped;
+        }
+      }
+      return nullptr;
+    }
+
+    KeyRef insert(const std::string& key, Mapped mapped) {
+      size_t hash = hashOf(key);
+      size_t i = locate(key, hash);
+      if (i < table_.size()) {
+        table_[i].mapped = std::move(mapped);
+        return table_[i].key;
+      }
+      if ((size_ + 1) * 4 > table_.size() * 3) {
+        rehash(std::max(kMinBuckets, table_.size() * 2));
+      }
+      i = hash & mask();
+      while (table_[i].key) {
+        i = (i + 1) & mask();
+      }
+      table_[i].hash = hash;
+      table_[i].key = arena_.intern(key, hash);
+      table_[i].mapped = std::move(mapped);
+      ++size_;
+      return table_[i].key;
+    }
+
+    bool erase(const std::string& key) {
+      if (size_ == 0) {
+        return false;
+      }
+      size_t i = locate(key, hashOf(key));
+      if (i == table_.size()) {
+        return false;
+      }
+      eraseAt(i);
+      return true;
+    }
+
+    // 按结点保存的引用删除：缓存的哈希定位，指针比较；返回后ref即失效(见上方所有权说明)
+    bool erase(KeyRef ref) {
+      if (size_ == 0 || !ref) {
+        return false;
+      }
+      for (size_t i = ref->hash & mask(); table_[i].key; i = (i + 1) & mask()) {
+        if (table_[i].key == ref) {
+          eraseAt(i);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    template<typename Func>
+    void forEach(Func func) {
+      for (Entry& entry : table_) {
+        if (entry.key) {
+          func(entry.mapped);
+        }
+      }
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void clear() {
+      for (Entry& entry : table_) {
+        if (entry.key) {
+          arena_.release(entry.key);
+        }
+      }
+      table_.clear();
+      table_.shrink_to_fit();
+      arena_.clear();
+      size_ = 0;
+    }
+
+    void reserve(size_t n) {
+      size_t buckets = kMinBuckets;
+      while (buckets * 3 < n * 4) {
+        buckets *= 2;
+      }
+      if (buckets > table_.size()) {
+        rehash(buckets);
+      }
+    }
+
+    void sizeHint(size_t) {}
+  };
+} // namespace MyCache
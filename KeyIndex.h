@@ -0,0 +1,333 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "CacheAllocator.h"
+#include "InternedKey.h"
+
+namespace MyCache {
+  // 结点中保存的key形式：字符串key保存指向索引内驻留副本的指针，其余类型直接保存key
+  template<typename Key>
+  struct KeyRefTraits {
+    using type = Key;
+    static const Key& toKey(const Key& ref) { return ref; }
+  };
+
+  template<>
+  struct KeyRefTraits<std::string> {
+    using type = const InternedKey*;
+    static std::string toKey(const InternedKey* ref) { return ref ? std::string(ref->view()) : std::string(); }
+  };
+
+  // 缓存引擎使用的 key -> 结点 索引
+  // 统一接口：find 返回指针(未找到为nullptr)，insert 插入或覆盖并返回结点应保存的KeyRef，
+  // erase 按key或KeyRef删除，forEach 遍历所有结点，sizeHint 告知预期条目数(缓存容量，只作提示不预分配)
+  template<typename Key, typename Mapped, typename Alloc = DefaultAlloc>
+  class HashKeyIndex {
+  public:
+    using KeyRef = Key;
+  private:
+    using Map = std::unordered_map<Key, Mapped, std::hash<Key>, std::equal_to<Key>,
+                                   RebindAlloc<Alloc, std::pair<const Key, Mapped>>>;
+    Map map_;
+  public:
+    explicit HashKeyIndex(const Alloc& alloc = Alloc()) : map_(typename Map::allocator_type(alloc)) {}
+
+    Mapped* find(const Key& key) {
+      auto it = map_.find(key);
+      return it == map_.end() ? nullptr : &it->second;
+    }
+
+    KeyRef insert(const Key& key, Mapped mapped) {
+      return map_.insert_or_assign(key, std::move(mapped)).first->first;
+    }
+
+    bool erase(const Key& key) {
+      return map_.erase(key) > 0;
+    }
+
+    template<typename Func>
+    void forEach(Func func) {
+      for (auto& kv : map_) {
+        func(kv.second);
+      }
+    }
+
+    size_t size() const { return map_.size(); }
+    bool empty() const { return map_.empty(); }
+    void clear() { map_.clear(); }
+    void reserve(size_t n) { map_.reserve(n); }
+    void sizeHint(size_t) {}
+  };
+
+  // 整数key的直接寻址索引：两级基数页表
+  // 第一次插入的key确定基址，[base, base + kMaxPages * kPageSize) 内的key直接按偏移寻址，
+  // 查找只需 目录 -> 页 两次依赖读；略低于基址的key把基址下移，范围外的key退回哈希表
+  // 密度检测：key在跨度内却很稀疏时(每页平均不到 kPageSize / kMaxSlotsPerEntry 个)，一次性整体转入哈希表，
+  // 之后不再分配页，直到 clear()
+  template<typename Key, typename Mapped, typename Alloc = DefaultAlloc>
+  class DenseKeyIndex {
+  public:
+    static constexpr size_t kPageBits = 10;
+    static constexpr size_t kPageSize = size_t(1) << kPageBits;
+    static constexpr size_t kMaxPages = size_t(1) << 14;  // 直接寻址跨度：16M个key
+    static constexpr size_t kMinPagesForDensityCheck = 8;  // 页数不多时不做密度判断，小缓存总走直接寻址
+    static constexpr size_t kMaxSlotsPerEntry = 8;         // 页内槽位(含目录项)超过条目数的这么多倍即视为稀疏
+    using KeyRef = Key;
+  private:
+    using UKey = std::make_unsigned_t<Key>;
+
+    struct Page {
+      std::array<Mapped, kPageSize> slots;
+      std::array<uint64_t, kPageSize / 64> used{};  // 占用位图
+      size_t count = 0;
+
+      bool has(size_t i) const { return (used[i >> 6] >> (i & 63)) & 1; }
+    };
+
+    using SparseMap = std::unordered_map<Key, Mapped, std::hash<Key>, std::equal_to<Key>,
+                                         RebindAlloc<Alloc, std::pair<const Key, Mapped>>>;
+
+    Alloc alloc_;
+    bool hasBase_;
+    bool sparseOnly_;  // 密度检测判定稀疏后只用哈希表
+    UKey base_;
+    size_t size_;
+    size_t pageCount_;  // 已分配的页数
+    size_t expected_;   // 预期条目数(sizeHint)：写满之前也按它判断密度，避免刚开始填充时误判稀疏
+    std::vector<Page*, RebindAlloc<Alloc, Page*>> pages_;  // 页目录，按需增长，页经由alloc_分配
+    SparseMap sparse_;                                        // 稀疏key的哈希后备
+
+    // key落在直接寻址范围内时返回true，并给出偏移
+    bool denseOffset(const Key& key, size_t& offset) const {
+      if (!hasBase_ || sparseOnly_) {
+        return false;
+      }
+      uint64_t off = static_cast<UKey>(static_cast<UKey>(key) - base_);
+      if (off >= kMaxPages * kPageSize) {
+        return false;
+      }
+      offset = static_cast<size_t>(off);
+      return true;
+    }
+
+    // key在基址下方且下移后跨度仍在 kMaxPages 页以内时，目录整体后移、基址下移，返回true
+    // 哈希后备里已有key时不下移，否则其中落进新跨度的key会查不到
+    bool rebaseFor(const Key& key) {
+      if (!sparse_.empty()) {
+        return false;
+      }
+      uint64_t below = static_cast<UKey>(base_ - static_cast<UKey>(key));
+      if (below == 0 || below > kMaxPages * kPageSize) {
+        return false;
+      }
+      size_t shift = static_cast<size_t>((below + kPageSize - 1) >> kPageBits);
+      if (pages_.size() + shift > kMaxPages) {
+        return false;
+      }
+      pages_.insert(pages_.begin(), shift, nullptr);
+      base_ = static_cast<UKey>(base_ - static_cast<UKey>(shift * kPageSize));
+      return true;
+    }
+
+    // 再分配一页(目录长到 directorySize)后是否过于稀疏
+    bool tooSparse(size_t directorySize) const {
+      size_t pages = pageCount_ + 1;
+      if (pages < kMinPagesForDensityCheck && directorySize < kMinPagesForDensityCheck * kPageSize / kMaxSlotsPerEntry) {
+        return false;
+      }
+      size_t budget = (std::max(size_, expected_) + 1) * kMaxSlotsPerEntry;
+      return pages * kPageSize > budget || directorySize > budget;
+    }
+
+    // 把所有直接寻址的条目搬入哈希表并归还页；只发生一次，之后不再分配页
+    void fallBackToHash() {
+      sparse_.reserve(size_ + 1);
+      for (size_t pageIndex = 0; pageIndex < pages_.size(); ++pageIndex) {
+        Page* page = pages_[pageIndex];
+        if (!page) {
+          continue;
+        }
+        for (size_t i = 0; i < kPageSize; ++i) {
+          if (page->has(i)) {
+            Key key = static_cast<Key>(static_cast<UKey>(base_ + static_cast<UKey>((pageIndex << kPageBits) + i)));
+            sparse_.emplace(key, std::move(page->slots[i]));
+          }
+        }
+        destroyObject(alloc_, page);
+      }
+      pages_.clear();
+      pages_.shrink_to_fit();
+      pageCount_ = 0;
+      sparseOnly_ = true;
+    }
+
+    KeyRef insertSparse(const Key& key, Mapped mapped) {
+      auto result = sparse_.emplace(key, std::move(mapped));
+      if (result.second) {
+        ++size_;
+      } else {
+        result.first->second = std::move(mapped);
+      }
+      return key;
+    }
+
+  public:
+    explicit DenseKeyIndex(const Alloc& alloc = Alloc())
+      : alloc_(alloc), hasBase_(false), sparseOnly_(false), base_(0), size_(0), pageCount_(0), expected_(0)
+      , pages_(RebindAlloc<Alloc, Page*>(alloc)), sparse_(typename SparseMap::allocator_type(alloc)) {}
+
+    DenseKeyIndex(const DenseKeyIndex&) = delete;
+    DenseKeyIndex& operator=(const DenseKeyIndex&) = delete;
+
+    ~DenseKeyIndex() { clear(); }
+
+    Mapped* find(const Key& key) {
+      size_t offset;
+      if (denseOffset(key, offset)) {
+        size_t pageIndex = offset >> kPageBits;
+        if (pageIndex >= pages_.size() || !pages_[pageIndex]) {
+          return nullptr;
+        }
+        Page* page = pages_[pageIndex];
+        size_t i = offset & (kPageSize - 1);
+        return page->has(i) ? &page->slots[i] : nullptr;
+      }
+      if (sparse_.empty()) {
+        return nullptr;
+      }
+      auto it = sparse_.find(key);
+      return it == sparse_.end() ? nullptr : &it->second;
+    }
+
+    KeyRef insert(const Key& key, Mapped mapped) {
+      if (!hasBase_) {
+        // 基址按页对齐，使base附近的key也能落在同一页
+        hasBase_ = true;
+        base_ = static_cast<UKey>(static_cast<UKey>(key) & ~static_cast<UKey>(kPageSize - 1));
+      }
+      size_t offset;
+      if (!denseOffset(key, offset) && !(!sparseOnly_ && rebaseFor(key) && denseOffset(key, offset))) {
+        return insertSparse(key, std::move(mapped));
+      }
+
+      size_t pageIndex = offset >> kPageBits;
+      if (pageIndex >= pages_.size() || !pages_[pageIndex]) {
+        if (tooSparse(std::max(pages_.size(), pageIndex + 1))) {
+          fallBackToHash();
+          return insertSparse(key, std::move(mapped));
+        }
+        if (pageIndex >= pages_.size()) {
+          pages_.resize(pageIndex + 1, nullptr);
+        }
+        pages_[pageIndex] = allocateObject<Page>(alloc_);
+        ++pageCount_;
+      }
+      Page* page = pages_[pageIndex];
+      size_t i = offset & (kPageSize - 1);
+      if (!page->has(i)) {
+        page->used[i >> 6] |= uint64_t(1) << (i & 63);
+        ++page->count;
+        ++size_;
+      }
+      page->slots[i] = std::move(mapped);
+      return key;
+    }
+
+    bool erase(const Key& key) {
+      size_t offset;
+      if (!denseOffset(key, offset)) {
+        if (sparse_.erase(key) == 0) {
+          return false;
+        }
+        --size_;
+        return true;
+      }
+      size_t pageIndex = offset >> kPageBits;
+      if (pageIndex >= pages_.size() || !pages_[pageIndex]) {
+        return false;
+      }
+      Page* page = pages_[pageIndex];
+      size_t i = offset & (kPageSize - 1);
+      if (!page->has(i)) {
+        return false;
+      }
+      page->used[i >> 6] &= ~(uint64_t(1) << (i & 63));
+      page->slots[i] = Mapped();  // 释放结点引用
+      --size_;
+      if (--page->count == 0) {
+        destroyObject(alloc_, page);  // 空页归还
+        pages_[pageIndex] = nullptr;
+        --pageCount_;
+      }
+      return true;
+    }
+
+    template<typename Func>
+    void forEach(Func func) {
+      for (size_t pageIndex = 0; pageIndex < pages_.size(); ++pageIndex) {
+        Page* page = pages_[pageIndex];
+        if (!page) {
+          continue;
+        }
+        for (size_t i = 0; i < kPageSize; ++i) {
+          if (page->has(i)) {
+            func(page->slots[i]);
+          }
+        }
+      }
+      for (auto& kv : sparse_) {
+        func(kv.second);
+      }
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool dense() const { return !sparseOnly_; }  // 尚未因稀疏转入哈希表
+    size_t pageCount() const { return pageCount_; }
+
+    void clear() {
+      for (Page* page : pages_) {
+        destroyObject(alloc_, page);
+      }
+      pages_.clear();
+      sparse_.clear();
+      size_ = 0;
+      pageCount_ = 0;
+      hasBase_ = false;
+      sparseOnly_ = false;
+    }
+
+    void reserve(size_t) {}
+    void sizeHint(size_t expected) { expected_ = expected; }
+  };
+
+  // 整数key(bool除外)默认使用直接寻址索引，字符串key使用驻留索引，其余类型使用哈希索引
+  template<typename Key, typename Mapped, typename Alloc, typename = void>
+  struct KeyIndexSelector {
+    using type = HashKeyIndex<Key, Mapped, Alloc>;
+  };
+
+  template<typename Key, typename Mapped, typename Alloc>
+  struct KeyIndexSelector<Key, Mapped, Alloc,
+      std::enable_if_t<std::is_integral<Key>::value && !std::is_same<Key, bool>::value>> {
+    using type = DenseKeyIndex<Key, Mapped, Alloc>;
+  };
+
+  template<typename Mapped, typename Alloc>
+  struct KeyIndexSelector<std::string, Mapped, Alloc> {
+    using type = InternedKeyIndex<Mapped, Alloc>;
+  };
+
+  template<typename Key, typename Mapped, typename Alloc = DefaultAlloc>
+  using KeyIndex = typename KeyIndexSelector<Key, Mapped, Alloc>::type;
+} // namespace MyCache
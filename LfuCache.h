@@ -1,203 +1,512 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdint>
+#include <initializer_list>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "CacheAllocator.h"
 #include "CachePolicy.h"
+#include "EpochReclaimer.h"
+#include "KeyIndex.h"
+#include "LockPolicy.h"
+#include "Maintenance.h"
+#include "ShardBudget.h"
+#include "SlotStore.h"
+#include "TryLock.h"
 
 namespace MyCache {
-  template<typename Key, typename Value> class LfuCache;
+  template<typename Key, typename Value, typename Alloc, typename Lock> class LfuCache;
 
-  template<typename Key, typename Value>
+  // 同一频次的结点链表：只持有头尾槽位，前后链接存放在 SlotStore 的元数据里
+  template<typename Key, typename Value, typename Alloc = DefaultAlloc>
   class FreqList {
   private:
+    // 结点负载(冷数据)：key引用与value；频次记在元数据的count里
     struct Node
     {
-      /* data */
-      int freq;   // 访问频次
-      Key key;
-      Value value;
-      std::shared_ptr<Node> prev;  // 上一结点
-      std::shared_ptr<Node> next;
+      using KeyRef = typename KeyRefTraits<Key>::type;  // 字符串key只保存索引中驻留副本的指针
 
-      Node() : freq(1), prev(nullptr), next(nullptr) {}
-      Node(Key key, Value value) : freq(1), key(key), value(value), pre(nullptr), next(nullptr) {}
+      KeyRef key{};
+      Value value{};
+      uint32_t touched = 0;  // 共享预算下最近一次挂入频次链表时的预算代数
     };
 
-    using NodePtr = std::shared_ptr<Node>;
+    using NodeStore = SlotStore<Node, Alloc>;
     int freq_;  // 访问频率
-    NodePtr dummyHead_;  // 头结点
-    NodePtr dummyTail_;
+    SlotList list_;
   public:
-    explicit FreqList(int n) : freq_(n) {
-      dummyHead_ = std::make_shared<Node>();
-      dummyTail_ = std::make_shared<Node>();
-      dummyHead_->next = dummyTail_;
-      dummyTail_->prev = dummyHead_;
-    }
+    explicit FreqList(int n) : freq_(n) {}
 
     bool isEmpty() const {
-      return dummyHead_->next == dummyTail_;
+      return list_.empty();
     }
 
-    void addNode(NodePtr node) {
-      if (!node || !dummyHead_ || !dummyTail_) {
-        return;
-      }
-      node->prev = dummyTail_->prev;  // 差在尾部，虚拟尾节点之前
-      node->next = dummyTail_;
-      dummyTail_->prev->next = node;
-      dummyHead_->prev = node;
+    void addNode(NodeStore& store, SlotIndex slot) {
+      list_.pushBack(store, slot);  // 插在尾部
     }
 
-    void removeNode(NodePtr node) {
-      if (!node || !dummyHead_ || !dummyTail_) {
-        return;
-      }
-      if (!node->prev || !node->next) {
-        return;
-      }
-
-      node->prev->next = node->next;
-      node->next->prev = node->prev;
-      node->prev = node->next = nullptr;
+    void removeNode(NodeStore& store, SlotIndex slot) {
+      list_.remove(store, slot);
     }
 
-    NodePtr getFirstNode() const {
-      return dummyHead_->next;
+    SlotIndex getFirstNode() const {
+      return list_.head;
     }
 
-    friend class LfuCache<Key, Value>;
+    template<typename, typename, typename, typename> friend class LfuCache;
   };
 
-  template<typename Key, typename Value>
+  // Alloc：结点、频次链表、索引等全部内存的来源(字节分配器，内部rebind)
+  // Lock：锁策略(见 LockPolicy.h)，单线程使用时传 NullLock
+  template<typename Key, typename Value, typename Alloc = DefaultAlloc, typename Lock = std::mutex>
   class LfuCache : public CachePolicy<Key, Value> {
   public:
-    using Node = typename FreqList<Key, Value>::Node;
-    using NodePtr = std::shared_ptr<Node>;
-    using NodeMap = std::unordered_map<Key, NodePtr>;
+    using FreqListType = FreqList<Key, Value, Alloc>;
+    using Node = typename FreqListType::Node;
+    using NodeStore = typename FreqListType::NodeStore;
+    using NodeMap = KeyIndex<Key, SlotIndex, Alloc>;  // 整数key走直接寻址，其余走哈希
+    using FreqListMap = std::unordered_map<int, FreqListType, std::hash<int>, std::equal_to<int>,
+                                           RebindAlloc<Alloc, std::pair<const int, FreqListType>>>;
+    using allocator_type = Alloc;
+    using lock_type = Lock;
+    using Budget = ShardBudget<LfuCache, Alloc>;
   private:
-    int capacity_;  // 缓存容量
+    static constexpr int kReclaimAttempts = 4;  // 共享预算下插入前最多回收几次，之后在本分片内淘汰
+    static constexpr size_t kTrimPerOp = 4;     // 缩容后每次put/get顺带淘汰的上限
+
+    std::atomic<int> capacity_;  // 缓存容量，可在线调整；锁外只用于快速判断0容量
     int minFreq_;   // 最小访问频次（用于找到最小访问频次结点）
     int maxAvgNum_; // 最大平均访问次数
     int curAvgNum_; // 当前平均访问频次
     int curTotalNum_;   // 当前访问所有缓存次数综述
-    std::mutex mutex_;  // 互斥锁
-    NodeMap nodeMap_;   // key -> 缓存结点
-    std::unordered_map<int, FreqList<Key, Value>*> freqToFreqList_;   // 访问频次 -> 该频次链表
+    Alloc alloc_;
+    Lock mutex_;        // 互斥锁
+    ContentionStats contention_;  // tryGet/tryPut 的抢锁统计
+    Budget* budget_ = nullptr;    // 非空时容量由全局预算约束，capacity_ 只是单分片上限
+    MaintenanceExecutor* maintenance_ = nullptr;  // 非空时淘汰与老化交给后台，前台只在越过高水位时淘汰
+    double highWatermark_ = kDefaultHighWatermark;
+    SlotIndex agingCursor_ = kNilSlot;  // 进行中的老化扫到的槽位下标，kNilSlot表示没有进行中的老化
+    NodeMap nodeMap_;   // key -> 槽位
+    NodeStore store_;   // 槽位 -> 元数据(链接、频次)/负载(key、value)
+    FreqListMap freqToFreqList_;   // 访问频次 -> 该频次链表
   
   public:
-    LfuCache(int capacity, int maxAvgNum = 10) : capacity_(capacity), minFreq_(INT8_MAX), maxAvgNum_(maxAvgNum), curAvgNum_(0), curTotalNum_(0) {}
+    LfuCache(int capacity, int maxAvgNum = 10, const Alloc& alloc = Alloc())
+      : capacity_(capacity), minFreq_(INT8_MAX), maxAvgNum_(maxAvgNum), curAvgNum_(0), curTotalNum_(0)
+      , alloc_(alloc), nodeMap_(alloc), store_(alloc), freqToFreqList_(typename FreqListMap::allocator_type(alloc)) {
+      nodeMap_.sizeHint(static_cast<size_t>(std::max(capacity, 0)));
+    }
 
     ~LfuCache() override = default;
 
+    allocator_type get_allocator() const { return alloc_; }
+
     void put(Key key, Value value) override {
-      if (capacity_ == 0) {
+      if (capacity_.load(std::memory_order_relaxed) <= 0) {
         return;
       }
-      
-      std::lock_guard<std::mutex> lock(mutex_);
-      auto it = nodeMap_.find(key);
-      if (it != nodeMap_.end()) {
-        it->second->value = value;  // 重置value值
-        
+      if (budget_) {
+        putShared(key, value);
         return;
       }
-
+      
+      std::lock_guard<Lock> lock(mutex_);
+      putLocked(key, value);
     }
 
     bool get(Key key, Value& value) override {
-      std::lock_guard<std::mutex> lock(mutex_);
-      auto it = nodeMap_.find(key);
-      if (it != nodeMap_.end()) {
-        
-        return true;
-      }
-      return false;
+      std::lock_guard<Lock> lock(mutex_);
+      return getLocked(key, value);
     }
 
     Value get(Key key) override {
-      Value value;
+      Value value{};
       get(key, value);
       return value;
     }
 
+    // 有界等待的读取：预算内抢不到锁返回Contended，不计访问频次，调用方按未命中处理
+    TryStatus tryGet(Key key, Value& value, const TryBudget& budget = TryBudget()) {
+      std::unique_lock<Lock> lock(mutex_, std::defer_lock);
+      if (!tryLockWithin(lock, budget, contention_)) {
+        return TryStatus::Contended;
+      }
+      return getLocked(key, value) ? TryStatus::Hit : TryStatus::Miss;
+    }
+
+    // 有界等待的写入：预算内抢不到锁则丢弃这次写入并返回false
+    bool tryPut(Key key, Value value, const TryBudget& budget = TryBudget()) {
+      if (capacity_.load(std::memory_order_relaxed) <= 0) {
+        return true;
+      }
+      std::unique_lock<Lock> lock(mutex_, std::defer_lock);
+      if (!tryLockWithin(lock, budget, contention_)) {
+        return false;
+      }
+      putLocked(key, value);
+      return true;
+    }
+
+    // 只读查看：不计访问频次，锁支持共享模式时多个peek可并行
+    bool peek(Key key, Value& value) {
+      SharedGuard<Lock> lock(mutex_);
+      SlotIndex* slot = nodeMap_.find(key);
+      if (slot) {
+        value = store_.payload(*slot).value;
+        return true;
+      }
+      return false;
+    }
+
+    const ContentionStats& contentionStats() const { return contention_; }
+
+    // 在线调整容量：扩容立即生效；缩容只改上限，超出的结点由后续put/get分批淘汰或由 trim 淘汰
+    void setCapacity(int capacity) {
+      std::lock_guard<Lock> lock(mutex_);
+      capacity_.store(capacity, std::memory_order_relaxed);
+      nodeMap_.sizeHint(static_cast<size_t>(std::max(capacity, 0)));
+      if (maintenance_ && nodeMap_.size() > static_cast<size_t>(std::max(capacity, 0))) {
+        maintenance_->notify();
+      }
+    }
+
+    int capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    size_t size() {
+      std::lock_guard<Lock> lock(mutex_);
+      return nodeMap_.size();
+    }
+
+    // 淘汰至多 maxEvictions 个超出容量的结点，返回实际淘汰数
+    size_t trim(size_t maxEvictions) {
+      std::lock_guard<Lock> lock(mutex_);
+      return trimLocked(maxEvictions);
+    }
+
+    // 延迟维护：executor非空时put只插入，超出容量的淘汰与平均频次超限后的老化都由后台调用 maintain 分批完成；
+    // 条目数涨到 容量*highWatermark 时前台退回同步淘汰。一般经 MaintenanceExecutor::watch 开启，传空指针恢复
+    void deferMaintenance(MaintenanceExecutor* executor, double highWatermark = kDefaultHighWatermark) {
+      std::lock_guard<Lock> lock(mutex_);
+      maintenance_ = executor;
+      highWatermark_ = highWatermark;
+      if (!executor && agingCursor_ != kNilSlot) {
+        ageSlots(SIZE_MAX);  // 恢复同步维护前做完进行中的老化
+      }
+    }
+
+    // 后台维护：先淘汰到容量以内，剩余额度用于推进老化(每个槽位算一个单位)
+    size_t maintain(size_t budget) {
+      std::lock_guard<Lock> lock(mutex_);
+      size_t done = trimLocked(budget);
+      if (done < budget && agingCursor_ != kNilSlot) {
+        done += ageSlots(budget - done);
+      }
+      return done;
+    }
+
+    // 加入共享预算：只能在缓存为空、尚未并发使用时调用
+    void attachBudget(Budget* budget) {
+      budget_ = budget;
+    }
+
+    // 供 ShardBudget 选择淘汰分片：最小频次越低分数越高，同频次时比较该频次链表队头的年龄
+    // (单个LFU在同频次内按挂入先后淘汰，跨分片保持同样的次序)
+    bool evictionScore(uint64_t& score) {
+      std::lock_guard<Lock> lock(mutex_);
+      if (nodeMap_.empty()) {
+        return false;
+      }
+      auto it = freqToFreqList_.find(minFreq_);
+      if (it == freqToFreqList_.end() || it->second.isEmpty()) {
+        updateMinFreq();
+        it = freqToFreqList_.find(minFreq_);
+      }
+      uint32_t rarity = UINT32_MAX - static_cast<uint32_t>(minFreq_);
+      uint32_t age = budget_->now() - store_.payload(it->second.getFirstNode()).touched;
+      score = (static_cast<uint64_t>(rarity) << 32) | age;
+      return true;
+    }
+
+    bool evictForBudget() {
+      std::lock_guard<Lock> lock(mutex_);
+      if (nodeMap_.empty()) {
+        return false;
+      }
+      kickOut();
+      return true;
+    }
+
+    // 删除指定元素
+    void remove(Key key) {
+      std::lock_guard<Lock> lock(mutex_);
+      SlotIndex* slot = nodeMap_.find(key);
+      if (slot) {
+        eraseSlot(*slot);
+      }
+    }
+
+    // 以下供重新分片时在分片间搬移结点，频次随结点一起搬走
+    // 摘下指定key并取出value与频次
+    bool take(const Key& key, Value& value, uint32_t& freq) {
+      std::lock_guard<Lock> lock(mutex_);
+      SlotIndex* slot = nodeMap_.find(key);
+      if (!slot) {
+        return false;
+      }
+      SlotIndex target = *slot;
+      value = std::move(store_.payload(target).value);
+      freq = store_.meta(target).count;
+      eraseSlot(target);
+      return true;
+    }
+
+    // 摘下最小频次中最早挂入的结点
+    bool takeLeastFrequent(Key& key, Value& value, uint32_t& freq) {
+      std::lock_guard<Lock> lock(mutex_);
+      if (nodeMap_.empty()) {
+        return false;
+      }
+      auto it = freqToFreqList_.find(minFreq_);
+      if (it == freqToFreqList_.end() || it->second.isEmpty()) {
+        updateMinFreq();
+        it = freqToFreqList_.find(minFreq_);
+      }
+      SlotIndex target = it->second.getFirstNode();
+      key = KeyRefTraits<Key>::toKey(store_.payload(target).key);  // 删除索引前拷出
+      value = std::move(store_.payload(target).value);
+      freq = store_.meta(target).count;
+      eraseSlot(target);
+      return true;
+    }
+
+    // key不存在时以给定频次插入；已存在(搬移期间有更新的写入)时保留现值，返回是否插入
+    bool putIfAbsent(const Key& key, const Value& value, uint32_t freq = 1) {
+      if (capacity_.load(std::memory_order_relaxed) <= 0) {
+        return false;
+      }
+      std::lock_guard<Lock> lock(mutex_);
+      if (nodeMap_.find(key)) {
+        return false;
+      }
+      Value copy = value;
+      putLocked(key, copy);
+      if (freq > 1) {
+        SlotIndex slot = *nodeMap_.find(key);
+        removeFromFreqList(slot);
+        store_.meta(slot).count = freq;
+        addToFreqList(slot);
+        curTotalNum_ += static_cast<int>(freq) - 1;
+        updateMinFreq();  // 新结点不在频次1上，最小频次可能上移
+      }
+      return true;
+    }
+
     // 清空缓存，回收资源
     void purge() {
+      if (budget_) {
+        budget_->release(nodeMap_.size());
+      }
       nodeMap_.clear();
+      store_.clear();
       freqToFreqList_.clear();
+      minFreq_ = INT8_MAX;
+      curAvgNum_ = curTotalNum_ = 0;
+      agingCursor_ = kNilSlot;
     }
 
   private:
+    // 共享预算下的写入：预算用尽时先从采样到的分片回收一个单位，回收时不持有本分片锁
+    void putShared(const Key& key, Value& value) {
+      for (size_t i = 0; i < kTrimPerOp && budget_->excess() > 0; ++i) {
+        if (!budget_->reclaim()) {
+          break;
+        }
+      }
+      for (int attempt = 0; attempt < kReclaimAttempts; ++attempt) {
+        {
+          std::lock_guard<Lock> lock(mutex_);
+          trimInline();
+          SlotIndex* slot = nodeMap_.find(key);
+          if (slot) {
+            store_.payload(*slot).value = value;
+            getInternal(*slot, value);
+            return;
+          }
+          if (budget_->tryAcquire()) {
+            putInternal(key, value);
+            return;
+          }
+        }
+        if (!budget_->reclaim()) {
+          break;
+        }
+      }
+      std::lock_guard<Lock> lock(mutex_);
+      putLocked(key, value);
+    }
+
+    // 持锁调用
+    void putLocked(const Key& key, Value& value) {
+      trimInline();
+      SlotIndex* slot = nodeMap_.find(key);
+      if (slot) {
+        store_.payload(*slot).value = value;  // 重置value值
+        getInternal(*slot, value);  // 并计一次访问
+        return;
+      }
+      if (budget_ && !budget_->tryAcquire()) {
+        // 预算用尽且不回收其他分片(tryPut或回收失败)：在本分片内以旧换新，先占单位再淘汰，总数不超预算；
+        // 本分片没有可淘汰的结点时放弃这次写入
+        if (nodeMap_.empty()) {
+          return;
+        }
+        budget_->forceAcquire();
+        kickOut();
+      }
+      putInternal(key, value);
+    }
+
+    bool getLocked(const Key& key, Value& value) {
+      trimInline();
+      SlotIndex* slot = nodeMap_.find(key);
+      if (slot) {
+        getInternal(*slot, value);
+        return true;
+      }
+      return false;
+    }
+
+    size_t trimLocked(size_t maxEvictions) {
+      size_t limit = static_cast<size_t>(std::max(capacity_.load(std::memory_order_relaxed), 0));
+      size_t evicted = 0;
+      while (evicted < maxEvictions && nodeMap_.size() > limit) {
+        kickOut();
+        ++evicted;
+      }
+      return evicted;
+    }
+
+    // put/get顺带的淘汰：延迟维护时交给后台
+    void trimInline() {
+      if (!maintenance_) {
+        trimLocked(kTrimPerOp);
+      }
+    }
+
+    void eraseSlot(SlotIndex slot) {
+      int freq = freqOf(slot);
+      removeFromFreqList(slot);
+      nodeMap_.erase(store_.payload(slot).key);
+      store_.release(slot);
+      decreaseFreqNum(freq);
+      if (budget_) {
+        budget_->release();
+      }
+    }
+
     void putInternal(Key key, Value value);  // 添加缓存
-    void getInternal(NodePtr node, Value& value);  // 获取缓存
+    void getInternal(SlotIndex slot, Value& value);  // 获取缓存
     void kickOut();  // 移出缓存中的过期缓存
 
-    void removeFromFreqList(NodePtr node);  // 从频次链表中移除结点
-    void addToFreqList(NodePtr node);  // 添加到频次链表中
+    void removeFromFreqList(SlotIndex slot);  // 从频次链表中移除结点
+    void addToFreqList(SlotIndex slot);  // 添加到频次链表中
 
     void addFreqNum();      // 增加平均访问等频率
     void decreaseFreqNum(int num); // 减少平均访问等频率
     void handleOverMaxAvgNum();  // 处理当前平均访问频率超过上限的情况
+    size_t ageSlots(size_t maxSlots);  // 从 agingCursor_ 起老化至多 maxSlots 个槽位
     void updateMinFreq();   // 更新最小访问频次
+
+    int freqOf(SlotIndex slot) { return static_cast<int>(store_.meta(slot).count); }
   };
 
-  template<typename Key, typename Value>
-  void LfuCache<Key, Value>::putInternal(Key key, Value value) {
-    // 如果不在缓存中，需要先判断缓存是否已满
-    if (nodeMap_.size() >= capacity_) {
+  template<typename Key, typename Value, typename Alloc, typename Lock>
+  void LfuCache<Key, Value, Alloc, Lock>::putInternal(Key key, Value value) {
+    // 如果不在缓存中，需要先判断缓存是否已满；延迟维护时只在越过高水位后才同步淘汰
+    size_t capacity = static_cast<size_t>(std::max(capacity_.load(std::memory_order_relaxed), 0));
+    size_t limit = maintenance_ ? highWatermarkLimit(capacity, highWatermark_) : capacity;
+    if (!nodeMap_.empty() && nodeMap_.size() >= limit) {
       kickOut();  // 删除最不常访问的结点
     }
-    NodePtr newNode = std::make_shared<Node>(key, value);
-    nodeMap_[key] = newNode;
-    addToFreqList(newNode);
+    SlotIndex slot = store_.allocate();
+    store_.meta(slot).count = 1;
+    Node& node = store_.payload(slot);
+    node.value = value;
+    node.key = nodeMap_.insert(key, slot);
+    addToFreqList(slot);
     addFreqNum();
     minFreq_ = std::min(minFreq_, 1);
+    if (maintenance_ && nodeMap_.size() >= wakeLimit(capacity, highWatermark_)) {
+      maintenance_->notify();  // 超额积累到一定量，唤醒后台淘汰
+    }
   }
 
-  template<typename Key, typename Value>
-  void LfuCache<Key, Value>::getInternal(NodePtr node, Value& value) {
-    value = node->value;  // value值返回
-    // 找到之后需要更新结点到对应的的freqList
-    removeFromFreqList(node);
-    node->freq++;         // 访问频次+1
-    addToFreqList(node);
+  template<typename Key, typename Value, typename Alloc, typename Lock>
+  void LfuCache<Key, Value, Alloc, Lock>::getInternal(SlotIndex slot, Value& value) {
+    value = store_.payload(slot).value;  // value值返回
+    // 找到之后需要更新结点到对应的的freqList，只改动元数据
+    removeFromFreqList(slot);
+    store_.meta(slot).count++;         // 访问频次+1
+    addToFreqList(slot);
 
     // 更新最小访问频次
-    if (node->freq == minFreq_ + 1 && freqToFreqList_[minFreq_]->isEmpty()) {
-      minFreq_++;
+    if (freqOf(slot) == minFreq_ + 1) {
+      auto it = freqToFreqList_.find(minFreq_);
+      if (it == freqToFreqList_.end() || it->second.isEmpty()) {
+        minFreq_++;
+      }
     }
 
     addFreqNum();
   }
 
-  template<typename Key, typename Value>
-  void LfuCache<Key, Value>::kickOut() {
-    NodePtr node = freqToFreqList_[minFreq_]->getFirstNode();
-    removeFromFreqList(node);
-    nodeMap_.erase(node->key);
-    decreaseFreqNum(node->freq);
+  template<typename Key, typename Value, typename Alloc, typename Lock>
+  void LfuCache<Key, Value, Alloc, Lock>::kickOut() {
+    auto it = freqToFreqList_.find(minFreq_);
+    if (it == freqToFreqList_.end() || it->second.isEmpty()) {
+      // 共享预算下可能连续被外部淘汰，minFreq_ 指向的链表已空
+      updateMinFreq();
+      it = freqToFreqList_.find(minFreq_);
+    }
+    SlotIndex slot = it->second.getFirstNode();
+    int freq = freqOf(slot);
+    removeFromFreqList(slot);
+    nodeMap_.erase(store_.payload(slot).key);  // 按结点保存的KeyRef删除，无需重新哈希
+    store_.release(slot);
+    decreaseFreqNum(freq);
+    if (budget_) {
+      budget_->release();
+    }
   }
 
-  template<typename Key, typename Value>
-  void LfuCache<Key, Value>::addFreqNum() {
+  template<typename Key, typename Value, typename Alloc, typename Lock>
+  void LfuCache<Key, Value, Alloc, Lock>::addFreqNum() {
     curTotalNum_++; 
     if (nodeMap_.empty()) { // 避免除0
       curAvgNum_ = 0;
     } else {
       curAvgNum_ = curTotalNum_ / nodeMap_.size();
     }
-    if (curAvgNum_ > maxAvgNum_) {
-      handleOverMaxAvgNum(); 
+    if (curAvgNum_ > maxAvgNum_ && agingCursor_ == kNilSlot) {
+      if (maintenance_) {
+        agingCursor_ = 0;  // 只登记一轮老化，由后台分批扫完
+        maintenance_->notify();
+      } else {
+        handleOverMaxAvgNum();
+      }
     }
   }
 
-  template<typename Key, typename Value>
-  void LfuCache<Key, Value>::decreaseFreqNum(int num) {
+  template<typename Key, typename Value, typename Alloc, typename Lock>
+  void LfuCache<Key, Value, Alloc, Lock>::decreaseFreqNum(int num) {
     curTotalNum_-= num;
     if (nodeMap_.empty()) {
       curAvgNum_ = 0;
@@ -206,35 +515,53 @@ namespace MyCache {
     }
   }
 
-  template<typename Key, typename Value>
-  void LfuCache<Key, Value>::handleOverMaxAvgNum() {
+  template<typename Key, typename Value, typename Alloc, typename Lock>
+  void LfuCache<Key, Value, Alloc, Lock>::handleOverMaxAvgNum() {
     if (nodeMap_.empty()) {
       return;
     }
+    agingCursor_ = 0;
+    ageSlots(SIZE_MAX);
+  }
 
-    // 所有结点访问频次 - (maxAvgNum_ / 2)
-    for (auto it = nodeMap_.begin(); it != nodeMap_.end(); ++it) {
-      if (!it->second) {  // 结点为空
-        continue;
+  // 所有结点访问频次 - (maxAvgNum_ / 2)，至少为1；按槽位下标顺序扫描，只读写元数据
+  // 可分多次完成：未扫到的结点暂时保留原频次，扫到末尾时重新计算平均值与最小频次
+  template<typename Key, typename Value, typename Alloc, typename Lock>
+  size_t LfuCache<Key, Value, Alloc, Lock>::ageSlots(size_t maxSlots) {
+    size_t end = store_.slotCount();
+    int decay = maxAvgNum_ / 2;
+    size_t visited = 0;
+    while (visited < maxSlots && agingCursor_ < end) {
+      SlotIndex slot = agingCursor_++;
+      ++visited;
+      int freq = freqOf(slot);
+      if (freq == 0) {
+        continue;  // 空闲槽位
       }
-      Node node = it->second;
-      removeFromFreqList(node);  // 从频次链表中移除
-      node->freq -= (maxAvgNum_ / 2);   // 减去频率
-      if (node->freq <= 0) {
-        node->freq = 1;
+      int aged = std::max(freq - decay, 1);
+      if (aged != freq) {
+        removeFromFreqList(slot);  // 从频次链表中移除
+        store_.meta(slot).count = static_cast<uint32_t>(aged);
+        addToFreqList(slot);  // 重新添加到对应的频次链表中
+        // 总访问次数随之下降，否则平均值始终超限，每次访问都会触发老化
+        curTotalNum_ -= freq - aged;
+        minFreq_ = std::min(minFreq_, aged);
       }
-      addToFreqList(node);  // 重新添加到对应的频次链表中
     }
-
-    // 更新最小访问频次
-    updateMinFreq();
+    if (agingCursor_ >= end) {
+      agingCursor_ = kNilSlot;
+      curAvgNum_ = nodeMap_.empty() ? 0 : curTotalNum_ / static_cast<int>(nodeMap_.size());
+      // 更新最小访问频次
+      updateMinFreq();
+    }
+    return visited;
   }
 
-  template<typename Key, typename Value>
-  void LfuCache<Key, Value>::updateMinFreq() {
+  template<typename Key, typename Value, typename Alloc, typename Lock>
+  void LfuCache<Key, Value, Alloc, Lock>::updateMinFreq() {
     minFreq_ = INT8_MAX;
     for (auto it = freqToFreqList_.begin(); it!= freqToFreqList_.end(); ++it) {
-      if (it->second && !it->second->isEmpty()) {
+      if (!it->second.isEmpty()) {
         minFreq_ = std::min(minFreq_, it->first);
       } 
     }
@@ -243,64 +570,241 @@ namespace MyCache {
     }
   }
 
-  template<typename Key, typename Value>
-  void LfuCache<Key, Value>::removeFromFreqList(NodePtr node) {
-    if (!node) {
-      return;
-    }
-
-    auto it = freqToFreqList_.find(node->freq);
+  template<typename Key, typename Value, typename Alloc, typename Lock>
+  void LfuCache<Key, Value, Alloc, Lock>::removeFromFreqList(SlotIndex slot) {
+    auto it = freqToFreqList_.find(freqOf(slot));
     if (it!= freqToFreqList_.end()) {
-      it->second->removeNode(node);
+      it->second.removeNode(store_, slot);
     }
   }
 
-  template<typename Key, typename Value>
-  void LfuCache<Key, Value>::addToFreqList(NodePtr node) {
-    if (!node) {
-      return;
-    }
-
-    auto it = freqToFreqList_.find(node->freq);
+  template<typename Key, typename Value, typename Alloc, typename Lock>
+  void LfuCache<Key, Value, Alloc, Lock>::addToFreqList(SlotIndex slot) {
+    int freq = freqOf(slot);
+    auto it = freqToFreqList_.find(freq);
     if (it == freqToFreqList_.end()) {
       // 不存在则创建新的链表
-      freqToFreqList_[node->freq] = new FreqList<Key, Value>(node->freq); 
+      it = freqToFreqList_.emplace(freq, FreqListType(freq)).first;
     }
 
-    it->second->addNode(node);
+    it->second.addNode(store_, slot);
+    if (budget_) {
+      store_.payload(slot).touched = budget_->now();
+    }
   }
 
   // HashLfuCache
-  template<typename Key, typename Value>
+  // 分片对象本身也经由Alloc分配，整个缓存的内存都来自同一个分配器
+  // 分片数可在线调整(reshard)，做法同 HashLruCaches：旧布局按最小频次优先搬到新布局，频次随结点保留
+  template<typename Key, typename Value, typename Alloc = DefaultAlloc>
   class HashLfuCache {
   private:
-    size_t capacity_; // 缓存总容量
-    int sliceNum_;    // 缓存分片数量
-    std::vector<std::unique_ptr<LfuCache<Key, Value>>> lfuSliceCaches_; // 缓存lfu分片容器
+    using Slice = LfuCache<Key, Value, Alloc>;
+    using SlicePtr = AllocUniquePtr<Slice, Alloc>;
+    using Budget = typename Slice::Budget;
+    using BudgetPtr = AllocUniquePtr<Budget, Alloc>;
+
+    static constexpr size_t kMigratePerOp = 4;  // 重新分片期间每次操作顺带搬移的结点数
+
+    struct Layout {
+      int sliceNum;    // 缓存分片数量
+      BudgetPtr budget;  // Shared容量模式下各分片共用，须比分片后析构
+      std::vector<SlicePtr, RebindAlloc<Alloc, SlicePtr>> slices; // 缓存lfu分片容器
+      std::atomic<size_t> cursor;  // 作为旧布局被搬空时，轮流从各分片摘结点
+      std::mutex migrateMutex;     // 作为旧布局时，一个结点的"摘下-放入新布局"与remove互斥，删除的key不会被搬回
+
+      Layout(int n, const Alloc& alloc)
+        : sliceNum(n), budget(nullptr, AllocDeleter<Budget, Alloc>{alloc})
+        , slices(RebindAlloc<Alloc, SlicePtr>(alloc)), cursor(0) {}
+    };
+
+    std::atomic<size_t> capacity_; // 缓存总容量
+    int maxAvgNum_;
+    ShardCapacity capacityMode_;
+    Alloc alloc_;
+    // 写入与管理操作持有布局指针期间公布epoch，切换后等宽限期封存旧布局；get 不 pin，见 HashLruCaches
+    mutable EpochReclaimer<Alloc> reclaimer_;
+    std::atomic<Layout*> layout_;       // 当前布局
+    std::atomic<Layout*> draining_;     // 重新分片期间的旧布局，搬空后为空
+    std::atomic<bool> sealed_;          // 旧布局已不再有写入者，此后才开始搬移
+    mutable std::mutex reshardMutex_;   // 串行化布局的替换与释放，以及需要遍历布局的管理操作
+    // 搬空的旧布局：不 pin 的 get 可能仍在读，留到析构时释放(只剩空分片)；受 reshardMutex_ 保护
+    std::vector<Layout*, RebindAlloc<Alloc, Layout*>> retiredLayouts_;
+    MaintenanceExecutor* maintenance_ = nullptr;  // 受 reshardMutex_ 保护，新布局的分片沿用延迟维护设置
+    double highWatermark_ = kDefaultHighWatermark;
 
     // 将key计算成对应哈希值
     size_t Hash(Key key) {
       std::hash<Key> hashFunc;
       return hashFunc(key);
     }
+
+    Layout* buildLayout(int sliceNum) {
+      Layout* layout = allocateObject<Layout>(alloc_, sliceNum, alloc_);
+      size_t capacity = capacity_.load(std::memory_order_relaxed);
+      size_t sliceSize = std::ceil(capacity / static_cast<double>(sliceNum));   // 每个lfu分片的容量
+      if (capacityMode_ == ShardCapacity::Shared) {
+        layout->budget = allocateUnique<Budget>(alloc_, capacity, alloc_);
+        sliceSize = capacity;  // 单个分片最多可用满总容量
+      }
+      for (int i = 0; i < sliceNum; ++i) {
+        layout->slices.push_back(allocateUnique<Slice>(alloc_, sliceSize, maxAvgNum_, alloc_));
+        if (maintenance_) {
+          layout->slices.back()->deferMaintenance(maintenance_, highWatermark_);
+        }
+        if (layout->budget) {
+          layout->slices.back()->attachBudget(layout->budget.get());
+          layout->budget->addShard(layout->slices.back().get());
+        }
+      }
+      return layout;
+    }
+
+    // 以下要求调用方已 pin 住 reclaimer_，或是 get 的快速路径(布局不会在析构前释放)
+    Slice& sliceOf(Layout& layout, const Key& key) {
+      return *layout.slices[Hash(key) % layout.sliceNum];
+    }
+
+    // 新布局未命中时查旧布局：封存前只读，封存后连同频次搬到新布局(并计这次访问)
+    // 持旧布局的搬移锁，旧布局未命中时再查一次新布局(调用方查过之后才被搬走的key)，同 HashLruCaches
+    bool getFromDraining(Layout& current, Layout& old, const Key& key, Value& value) {
+      Slice& from = sliceOf(old, key);
+      std::lock_guard<std::mutex> lock(old.migrateMutex);
+      if (!sealed_.load(std::memory_order_acquire)) {
+        if (from.peek(key, value)) {
+          return true;
+        }
+      } else {
+        uint32_t freq = 0;
+        if (from.take(key, value, freq)) {
+          sliceOf(current, key).putIfAbsent(key, value, freq + 1);
+          return true;
+        }
+      }
+      return sliceOf(current, key).get(key, value);
+    }
+
+    // 从旧布局摘下至多 maxEntries 个最小频次的结点，按原频次放到新布局；新布局已有同key时丢弃旧值
+    // 旧布局已空时返回true。搬移锁的用法同 HashLruCaches::migrateFrom
+    bool migrateFrom(Layout& current, Layout& old, size_t maxEntries, size_t& moved, bool wait = false) {
+      if (!sealed_.load(std::memory_order_acquire)) {
+        return false;
+      }
+      Key key{};
+      Value value{};
+      uint32_t freq = 0;
+      while (moved < maxEntries) {
+        std::unique_lock<std::mutex> lock(old.migrateMutex, std::defer_lock);
+        if (wait) {
+          lock.lock();
+        } else if (!lock.try_lock()) {
+          return false;
+        }
+        size_t start = old.cursor.fetch_add(1, std::memory_order_relaxed);
+        bool taken = false;
+        for (size_t i = 0; i < static_cast<size_t>(old.sliceNum) && !taken; ++i) {
+          taken = old.slices[(start + i) % old.sliceNum]->takeLeastFrequent(key, value, freq);
+        }
+        if (!taken) {
+          return true;
+        }
+        sliceOf(current, key).putIfAbsent(key, value, freq);
+        ++moved;
+      }
+      return false;
+    }
+
+    // 旧布局搬空后收尾：调用方不得 pin 住 reclaimer_
+    void finishReshard(Layout* old) {
+      std::lock_guard<std::mutex> lock(reshardMutex_);
+      if (draining_.load(std::memory_order_relaxed) == old) {
+        finishReshardLocked();
+      }
+    }
+
+    void finishReshardLocked() {
+      Layout* old = draining_.load(std::memory_order_relaxed);
+      if (!old) {
+        return;
+      }
+      size_t moved = 0;
+      migrateFrom(*layout_.load(std::memory_order_relaxed), *old, SIZE_MAX, moved, true);
+      draining_.store(nullptr, std::memory_order_release);
+      retiredLayouts_.push_back(old);
+    }
+
+    // 重新分片期间每次操作顺带搬移，返回搬空的旧布局(需在unpin后释放)
+    Layout* migrateStep(Layout& current) {
+      Layout* old = draining_.load(std::memory_order_acquire);
+      size_t moved = 0;
+      return old && migrateFrom(current, *old, kMigratePerOp, moved) ? old : nullptr;
+    }
   public:
-    HashLfuCache(size_t capacity, int sliceNum, int maxAvgNum = 10) 
-      : capacity_(capacity), sliceNum_(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency()) {
-      size_t sliceSize = std::ceil(capacity_ / static_cast<double>(sliceNum_));   // 每个lfu分片的容量
-      for (int i = 0; i < sliceNum_; ++i) {
-        lfuSliceCaches_.emplace_back(new LfuCache<Key, Value>(sliceSize, maxAvgNum));
+    HashLfuCache(size_t capacity, int sliceNum, int maxAvgNum = 10, const Alloc& alloc = Alloc())
+      : HashLfuCache(capacity, sliceNum, ShardCapacity::Fixed, maxAvgNum, alloc) {}
+
+    // ShardCapacity::Shared：分片按需伸缩，总量受全局预算约束，淘汰时从采样分片中选最小频次最低的
+    HashLfuCache(size_t capacity, int sliceNum, ShardCapacity capacityMode, int maxAvgNum = 10, const Alloc& alloc = Alloc())
+      : capacity_(capacity), maxAvgNum_(maxAvgNum), capacityMode_(capacityMode), alloc_(alloc)
+      , reclaimer_(alloc), layout_(nullptr), draining_(nullptr), sealed_(true)
+      , retiredLayouts_(RebindAlloc<Alloc, Layout*>(alloc)) {
+      layout_.store(buildLayout(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency()), std::memory_order_relaxed);
+    }
+
+    HashLfuCache(const HashLfuCache&) = delete;
+    HashLfuCache& operator=(const HashLfuCache&) = delete;
+
+    // 析构时不得有并发访问
+    ~HashLfuCache() {
+      if (Layout* old = draining_.load(std::memory_order_relaxed)) {
+        destroyObject(alloc_, old);
       }
+      for (Layout* retired : retiredLayouts_) {
+        destroyObject(alloc_, retired);
+      }
+      destroyObject(alloc_, layout_.load(std::memory_order_relaxed));
     }
 
     void put(Key key, Value value) {
-      // 根据key找到对应的lfu分片
-      size_t index = Hash(key) % sliceNum_;
-      lfuSliceCaches_[index]->put(key, value);
+      Layout* drained = nullptr;
+      {
+        auto guard = reclaimer_.pin();
+        Layout& current = *layout_.load(std::memory_order_acquire);
+        drained = migrateStep(current);
+        // 根据key找到对应的lfu分片
+        sliceOf(current, key).put(key, value);
+      }
+      if (drained) {
+        finishReshard(drained);
+      }
     }
 
     bool get(Key key, Value& value) {
-      size_t index = Hash(key) % sliceNum_;
-      return lfuSliceCaches_[index]->get(key, value);
+      // 快速路径：没有重新分片时不 pin；未命中且期间切换了布局时改走完整路径，理由同 HashLruCaches::get
+      Layout* latest = layout_.load(std::memory_order_acquire);
+      if (!draining_.load(std::memory_order_acquire)) {
+        bool found = sliceOf(*latest, key).get(key, value);
+        if (found || layout_.load(std::memory_order_acquire) == latest) {
+          return found;
+        }
+      }
+      bool found = false;
+      Layout* drained = nullptr;
+      {
+        auto guard = reclaimer_.pin();
+        Layout& current = *layout_.load(std::memory_order_acquire);
+        // 先于查新布局读取旧布局：查完新布局后旧布局才搬空、清除时，仍能经旧布局的搬移锁再查一次新布局
+        Layout* old = draining_.load(std::memory_order_acquire);
+        found = sliceOf(current, key).get(key, value);
+        if (old) {
+          found = found || getFromDraining(current, *old, key, value);
+          drained = migrateStep(current);
+        }
+      }
+      if (drained) {
+        finishReshard(drained);
+      }
+      return found;
     }
 
     Value get(Key key) {
@@ -309,11 +813,207 @@ namespace MyCache {
       return value;
     }
 
-    // 清空缓存，回收资源
+    // 重新分片期间新布局抢锁失败即返回Contended，不再查旧布局
+    TryStatus tryGet(Key key, Value& value, const TryBudget& budget = TryBudget()) {
+      auto guard = reclaimer_.pin();
+      Layout& current = *layout_.load(std::memory_order_acquire);
+      Layout* old = draining_.load(std::memory_order_acquire);  // 先于查新布局读取，见 get
+      TryStatus status = sliceOf(current, key).tryGet(key, value, budget);
+      if (status == TryStatus::Miss && old && getFromDraining(current, *old, key, value)) {
+        return TryStatus::Hit;
+      }
+      return status;
+    }
+
+    bool tryPut(Key key, Value value, const TryBudget& budget = TryBudget()) {
+      auto guard = reclaimer_.pin();
+      return sliceOf(*layout_.load(std::memory_order_acquire), key).tryPut(key, value, budget);
+    }
+
+    // 删除key；重新分片期间新旧布局中的同key一并删除
+    void remove(Key key) {
+      auto guard = reclaimer_.pin();
+      Layout& current = *layout_.load(std::memory_order_acquire);
+      std::unique_lock<std::mutex> lock;
+      if (Layout* old = draining_.load(std::memory_order_acquire)) {
+        lock = std::unique_lock<std::mutex>(old->migrateMutex);  // 已摘下、尚未放入新布局的同key放入后再删
+        sliceOf(*old, key).remove(key);
+      }
+      sliceOf(current, key).remove(key);
+    }
+
+    // 在线调整分片数：立即切换路由，旧布局的结点随后续操作或 migrate 搬到新布局
+    // 会等待切换前开始的操作结束；上一次重新分片尚未搬完时先同步搬完
+    void reshard(int sliceNum) {
+      if (sliceNum <= 0) {
+        sliceNum = std::thread::hardware_concurrency();
+      }
+      std::lock_guard<std::mutex> lock(reshardMutex_);
+      finishReshardLocked();
+      Layout* old = layout_.load(std::memory_order_relaxed);
+      if (old->sliceNum == sliceNum) {
+        return;
+      }
+      Layout* fresh = buildLayout(sliceNum);
+      sealed_.store(false, std::memory_order_relaxed);
+      draining_.store(old, std::memory_order_release);  // 先于切换公布
+      layout_.store(fresh, std::memory_order_release);
+      reclaimer_.synchronize();
+      sealed_.store(true, std::memory_order_release);
+    }
+
+    // 搬移至多 maxEntries 个结点，返回实际搬移数；搬空时释放旧布局
+    size_t migrate(size_t maxEntries) {
+      size_t moved = 0;
+      Layout* drained = nullptr;
+      {
+        auto guard = reclaimer_.pin();
+        Layout* old = draining_.load(std::memory_order_acquire);
+        if (!old) {
+          return 0;
+        }
+        drained = migrateFrom(*layout_.load(std::memory_order_acquire), *old, maxEntries, moved, true) ? old : nullptr;
+      }
+      if (drained) {
+        finishReshard(drained);
+      }
+      return moved;
+    }
+
+    bool resharding() const { return draining_.load(std::memory_order_acquire) != nullptr; }
+
+    int sliceCount() const {
+      auto guard = reclaimer_.pin();
+      return layout_.load(std::memory_order_acquire)->sliceNum;
+    }
+
+    // 当前布局各分片抢锁统计之和(重新分片后从新分片重新计数)
+    uint64_t contendedCount() const {
+      auto guard = reclaimer_.pin();
+      uint64_t total = 0;
+      for (const auto& slice : layout_.load(std::memory_order_acquire)->slices) {
+        total += slice->contentionStats().contended();
+      }
+      return total;
+    }
+
+    uint64_t tryAttemptCount() const {
+      auto guard = reclaimer_.pin();
+      uint64_t total = 0;
+      for (const auto& slice : layout_.load(std::memory_order_acquire)->slices) {
+        total += slice->contentionStats().attempts();
+      }
+      return total;
+    }
+
+    // 在线调整总容量：Fixed按分片均分，Shared只改全局预算；缩容后超出的结点分批淘汰
+    void setCapacity(size_t capacity) {
+      std::lock_guard<std::mutex> lock(reshardMutex_);
+      capacity_.store(capacity, std::memory_order_relaxed);
+      Layout* current = layout_.load(std::memory_order_relaxed);
+      size_t sliceSize = std::ceil(capacity / static_cast<double>(current->sliceNum));
+      if (current->budget) {
+        current->budget->setCapacity(capacity);
+        sliceSize = capacity;
+      }
+      for (auto& slice : current->slices) {
+        slice->setCapacity(static_cast<int>(sliceSize));
+      }
+    }
+
+    size_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    // 条目总数：当前布局与重新分片中的旧布局各分片之和；各分片分别加锁统计，并发写入时只是近似
+    size_t size() {
+      auto guard = reclaimer_.pin();
+      size_t total = 0;
+      for (Layout* layout : {layout_.load(std::memory_order_acquire), draining_.load(std::memory_order_acquire)}) {
+        if (layout) {
+          for (auto& slice : layout->slices) {
+            total += slice->size();
+          }
+        }
+      }
+      return total;
+    }
+
+    // 各分片切到延迟维护(见 LfuCache::deferMaintenance)，之后重新分片建出的分片沿用；
+    // Shared容量模式下跨分片的预算回收仍在写入时进行
+    void deferMaintenance(MaintenanceExecutor* executor, double highWatermark = kDefaultHighWatermark) {
+      std::lock_guard<std::mutex> lock(reshardMutex_);
+      maintenance_ = executor;
+      highWatermark_ = highWatermark;
+      for (Layout* layout : {layout_.load(std::memory_order_relaxed), draining_.load(std::memory_order_relaxed)}) {
+        if (layout) {
+          for (auto& slice : layout->slices) {
+            slice->deferMaintenance(executor, highWatermark);
+          }
+        }
+      }
+    }
+
+    // 后台维护：先推进尚未完成的重新分片，剩余额度用于各分片的淘汰与老化
+    size_t maintain(size_t budget) {
+      size_t done = migrate(budget);
+      if (done >= budget) {
+        return done;
+      }
+      {
+        auto guard = reclaimer_.pin();
+        Layout& current = *layout_.load(std::memory_order_acquire);
+        if (current.budget) {
+          while (done < budget && current.budget->excess() > 0 && current.budget->reclaim()) {
+            ++done;
+          }
+        }
+        for (auto& slice : current.slices) {
+          if (done >= budget) {
+            break;
+          }
+          done += slice->maintain(budget - done);
+        }
+      }
+      return done;
+    }
+
+    // 淘汰至多 maxEvictions 个超出容量的结点，返回实际淘汰数
+    size_t trim(size_t maxEvictions) {
+      auto guard = reclaimer_.pin();
+      Layout& current = *layout_.load(std::memory_order_acquire);
+      size_t evicted = 0;
+      if (current.budget) {
+        while (evicted < maxEvictions && current.budget->excess() > 0 && current.budget->reclaim()) {
+          ++evicted;
+        }
+      }
+      for (auto& slice : current.slices) {
+        if (evicted >= maxEvictions) {
+          break;
+        }
+        evicted += slice->trim(maxEvictions - evicted);
+      }
+      return evicted;
+    }
+
+    // 清空缓存，回收资源(旧布局一并清空)；不得与其他操作并发
     void purge() {
-      for (auto& lfuSliceCache : lfuSliceCaches_) {
-        lfuSliceCache->purge();
-      }  
+      std::lock_guard<std::mutex> lock(reshardMutex_);
+      for (Layout* layout : {layout_.load(std::memory_order_relaxed), draining_.load(std::memory_order_relaxed)}) {
+        if (!layout) {
+          continue;
+        }
+        for (auto& lfuSliceCache : layout->slices) {
+          lfuSliceCache->purge();
+        }
+      }
     }
   };
+
+  // 绑定到 std::pmr::memory_resource 的版本
+  namespace pmr {
+    template<typename Key, typename Value>
+    using LfuCache = MyCache::LfuCache<Key, Value, PmrAlloc>;
+    template<typename Key, typename Value>
+    using HashLfuCache = MyCache::HashLfuCache<Key, Value, PmrAlloc>;
+  }
 } // namespace MyCache
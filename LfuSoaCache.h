@@ -0,0 +1,414 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+// x86上总是编译AVX2版本的减半(按函数开启目标指令集)，运行时按CPU支持选择，不依赖编译参数
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
+#include "CacheAllocator.h"
+#include "CachePolicy.h"
+#include "KeyIndex.h"
+#include "LockPolicy.h"
+#include "TryLock.h"
+
+namespace MyCache {
+  // LFU变体：频次计数器按槽位连续存放(结构数组)，使用8位饱和计数
+  // 老化时对整个计数数组做一次向量化减半，频次桶在下一次结构操作时按桶整体合并，不再逐结点重挂
+  // Lock：锁策略(见 LockPolicy.h)，单线程使用时传 NullLock
+  template<typename Key, typename Value, typename Alloc = DefaultAlloc, typename Lock = std::mutex>
+  class LfuSoaCache : public CachePolicy<Key, Value> {
+  public:
+    using Freq = uint8_t;
+    using KeyRef = typename KeyRefTraits<Key>::type;  // 字符串key只保存索引中驻留副本的指针(带缓存的哈希)
+    using allocator_type = Alloc;
+    using lock_type = Lock;
+    static constexpr uint32_t kNil = UINT32_MAX;
+    static constexpr int kMaxFreq = UINT8_MAX;  // 计数饱和上限
+  private:
+    static constexpr size_t kTrimPerOp = 4;  // 缩容后每次put/get顺带淘汰的上限
+
+    std::atomic<size_t> capacity_;  // 缓存容量，可在线调整；锁外只用于快速判断0容量
+    int maxAvgNum_;     // 最大平均访问次数
+    uint64_t curTotalNum_;  // 当前访问所有缓存次数总数
+    int minFreq_;       // 最小访问频次
+    int pendingShifts_; // 已对计数数组减半、但频次桶尚未合并的次数
+    template<typename T>
+    using Array = std::vector<T, RebindAlloc<Alloc, T>>;
+
+    Alloc alloc_;
+    Lock mutex_;
+    ContentionStats contention_;  // tryGet/tryPut 的抢锁统计
+    KeyIndex<Key, uint32_t, Alloc> nodeMap_;  // key -> 槽位
+
+    // 按槽位下标访问的并行数组，[0, nodeMap_.size()) 始终是连续占用的
+    Array<KeyRef> keys_;  // 只存索引返回的KeyRef：key不再多存一份，淘汰时按引用删除无需重新哈希
+    Array<Value> values_;
+    Array<Freq> freqs_;     // 长度补齐到32的倍数，方便整块向量处理
+    Array<uint32_t> prev_;  // 同频次桶内的双向链接
+    Array<uint32_t> next_;
+    std::array<uint32_t, kMaxFreq + 1> bucketHead_;  // 频次 -> 桶头(最早进入该频次的槽位)
+    std::array<uint32_t, kMaxFreq + 1> bucketTail_;
+
+  public:
+    explicit LfuSoaCache(size_t capacity, int maxAvgNum = 10, const Alloc& alloc = Alloc())
+      : capacity_(capacity), maxAvgNum_(maxAvgNum), curTotalNum_(0), minFreq_(1), pendingShifts_(0)
+      , alloc_(alloc), nodeMap_(alloc), keys_(alloc), values_(alloc), freqs_(alloc), prev_(alloc), next_(alloc) {
+      resizeArrays(capacity);
+      bucketHead_.fill(kNil);
+      bucketTail_.fill(kNil);
+      nodeMap_.reserve(capacity);
+      nodeMap_.sizeHint(capacity);
+    }
+
+    ~LfuSoaCache() override = default;
+
+    allocator_type get_allocator() const { return alloc_; }
+
+    void put(Key key, Value value) override {
+      if (capacity_.load(std::memory_order_relaxed) == 0) {
+        return;
+      }
+
+      std::lock_guard<Lock> lock(mutex_);
+      putLocked(key, value);
+    }
+
+    bool get(Key key, Value& value) override {
+      std::lock_guard<Lock> lock(mutex_);
+      return getLocked(key, value);
+    }
+
+    Value get(Key key) override {
+      Value value{};
+      get(key, value);
+      return value;
+    }
+
+    // 有界等待的读取：预算内抢不到锁返回Contended，不计访问频次，调用方按未命中处理
+    TryStatus tryGet(Key key, Value& value, const TryBudget& budget = TryBudget()) {
+      std::unique_lock<Lock> lock(mutex_, std::defer_lock);
+      if (!tryLockWithin(lock, budget, contention_)) {
+        return TryStatus::Contended;
+      }
+      return getLocked(key, value) ? TryStatus::Hit : TryStatus::Miss;
+    }
+
+    // 有界等待的写入：预算内抢不到锁则丢弃这次写入并返回false
+    bool tryPut(Key key, Value value, const TryBudget& budget = TryBudget()) {
+      if (capacity_.load(std::memory_order_relaxed) == 0) {
+        return true;
+      }
+      std::unique_lock<Lock> lock(mutex_, std::defer_lock);
+      if (!tryLockWithin(lock, budget, contention_)) {
+        return false;
+      }
+      putLocked(key, value);
+      return true;
+    }
+
+    const ContentionStats& contentionStats() const { return contention_; }
+
+    // 在线调整容量：扩容立即扩大各并行数组；缩容只改上限，超出的结点由后续put/get或 trim 分批淘汰，
+    // 每淘汰一个就把末尾槽位搬进空洞以保持 [0, size) 连续，清完后再收缩数组
+    void setCapacity(size_t capacity) {
+      std::lock_guard<Lock> lock(mutex_);
+      if (capacity > keys_.size()) {
+        resizeArrays(capacity);
+        nodeMap_.reserve(capacity);
+      }
+      capacity_.store(capacity, std::memory_order_relaxed);
+      nodeMap_.sizeHint(capacity);
+    }
+
+    size_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    // 淘汰至多 maxEvictions 个超出容量的结点，返回实际淘汰数
+    size_t trim(size_t maxEvictions) {
+      std::lock_guard<Lock> lock(mutex_);
+      return trimLocked(maxEvictions);
+    }
+
+    // 清空缓存
+    void purge() {
+      std::lock_guard<Lock> lock(mutex_);
+      nodeMap_.clear();
+      std::fill(freqs_.begin(), freqs_.end(), 0);
+      bucketHead_.fill(kNil);
+      bucketTail_.fill(kNil);
+      curTotalNum_ = 0;
+      minFreq_ = 1;
+      pendingShifts_ = 0;
+    }
+
+  private:
+    void putLocked(const Key& key, const Value& value) {
+      trimLocked(kTrimPerOp);
+      uint32_t* slot = nodeMap_.find(key);
+      if (slot) {
+        values_[*slot] = value;  // 重置value值，并计一次访问
+        touch(*slot);
+        return;
+      }
+      if (capacity_.load(std::memory_order_relaxed) == 0) {
+        return;  // 加锁前被并发缩到0，数组可能已收缩
+      }
+      putInternal(key, value);
+    }
+
+    bool getLocked(const Key& key, Value& value) {
+      trimLocked(kTrimPerOp);
+      uint32_t* slot = nodeMap_.find(key);
+      if (!slot) {
+        return false;
+      }
+      value = values_[*slot];
+      touch(*slot);
+      return true;
+    }
+
+    // 未占用槽位的频次保持为0，老化求和时不计入
+    void resizeArrays(size_t capacity) {
+      keys_.resize(capacity);
+      values_.resize(capacity);
+      freqs_.resize((capacity + 31) / 32 * 32, 0);
+      prev_.resize(capacity, kNil);
+      next_.resize(capacity, kNil);
+    }
+
+    size_t trimLocked(size_t maxEvictions) {
+      size_t limit = capacity_.load(std::memory_order_relaxed);
+      if (nodeMap_.size() <= limit) {
+        if (keys_.size() > limit) {
+          shrinkArrays(limit);
+        }
+        return 0;
+      }
+      reconcileBuckets();
+      size_t evicted = 0;
+      while (evicted < maxEvictions && nodeMap_.size() > limit) {
+        while (bucketHead_[minFreq_] == kNil) {
+          ++minFreq_;  // 淘汰可能清空最小频次桶，非空时必有更高频次的桶
+        }
+        uint32_t victim = bucketHead_[minFreq_];
+        unlink(victim);
+        curTotalNum_ -= freqs_[victim];
+        nodeMap_.erase(keys_[victim]);
+        fillHole(victim);
+        ++evicted;
+      }
+      if (nodeMap_.empty()) {
+        minFreq_ = 1;
+      } else {
+        while (bucketHead_[minFreq_] == kNil) {
+          ++minFreq_;
+        }
+      }
+      return evicted;
+    }
+
+    // 把末尾的占用槽位搬进hole：链内位置不变(桶内先后即淘汰次序)，只改邻居与索引指向
+    void fillHole(uint32_t hole) {
+      uint32_t last = static_cast<uint32_t>(nodeMap_.size());  // 调用前已从索引删除被淘汰的key
+      if (hole != last) {
+        int freq = freqs_[last];
+        keys_[hole] = keys_[last];  // 只搬引用，驻留的key不动
+        values_[hole] = std::move(values_[last]);
+        freqs_[hole] = freqs_[last];
+        prev_[hole] = prev_[last];
+        next_[hole] = next_[last];
+        (prev_[hole] != kNil ? next_[prev_[hole]] : bucketHead_[freq]) = hole;
+        (next_[hole] != kNil ? prev_[next_[hole]] : bucketTail_[freq]) = hole;
+        *nodeMap_.find(keys_[hole]) = hole;
+      }
+      keys_[last] = KeyRef();
+      values_[last] = Value();
+      freqs_[last] = 0;
+      prev_[last] = next_[last] = kNil;
+    }
+
+    // 超出部分清完后一次性收缩，归还缩容前的内存
+    void shrinkArrays(size_t capacity) {
+      resizeArrays(capacity);
+      keys_.shrink_to_fit();
+      values_.shrink_to_fit();
+      freqs_.shrink_to_fit();
+      prev_.shrink_to_fit();
+      next_.shrink_to_fit();
+    }
+
+    void putInternal(const Key& key, const Value& value) {
+      reconcileBuckets();
+      uint32_t slot;
+      if (nodeMap_.size() >= capacity_.load(std::memory_order_relaxed)) {
+        // 淘汰最小频次桶中最早的结点，直接复用它的槽位
+        slot = bucketHead_[minFreq_];
+        unlink(slot);
+        curTotalNum_ -= freqs_[slot];
+        nodeMap_.erase(keys_[slot]);
+      } else {
+        slot = static_cast<uint32_t>(nodeMap_.size());
+      }
+      keys_[slot] = nodeMap_.insert(key, slot);
+      values_[slot] = value;
+      freqs_[slot] = 1;
+      link(slot);
+      minFreq_ = 1;
+      addFreqNum();
+    }
+
+    // 命中一次：频次+1(饱和)，挂到新频次桶的尾部
+    void touch(uint32_t slot) {
+      reconcileBuckets();
+      int oldFreq = freqs_[slot];
+      unlink(slot);
+      if (oldFreq < kMaxFreq) {
+        freqs_[slot] = static_cast<Freq>(oldFreq + 1);
+      }
+      link(slot);
+      if (oldFreq == minFreq_ && bucketHead_[oldFreq] == kNil) {
+        minFreq_ = freqs_[slot];
+      }
+      addFreqNum();
+    }
+
+    void link(uint32_t slot) {
+      int freq = freqs_[slot];
+      prev_[slot] = bucketTail_[freq];
+      next_[slot] = kNil;
+      if (bucketTail_[freq] != kNil) {
+        next_[bucketTail_[freq]] = slot;
+      } else {
+        bucketHead_[freq] = slot;
+      }
+      bucketTail_[freq] = slot;
+    }
+
+    void unlink(uint32_t slot) {
+      int freq = freqs_[slot];
+      if (prev_[slot] != kNil) {
+        next_[prev_[slot]] = next_[slot];
+      } else {
+        bucketHead_[freq] = next_[slot];
+      }
+      if (next_[slot] != kNil) {
+        prev_[next_[slot]] = prev_[slot];
+      } else {
+        bucketTail_[freq] = prev_[slot];
+      }
+      prev_[slot] = next_[slot] = kNil;
+    }
+
+    void addFreqNum() {
+      ++curTotalNum_;
+      if (!nodeMap_.empty() && curTotalNum_ / nodeMap_.size() > static_cast<uint64_t>(maxAvgNum_)) {
+        handleOverMaxAvgNum();
+      }
+    }
+
+    // 所有计数减半(不低于1)，并同时求出新的总访问次数
+    void handleOverMaxAvgNum() {
+      reconcileBuckets();
+      curTotalNum_ = halveFreqs(freqs_.data(), freqs_.size());
+      ++pendingShifts_;
+    }
+
+    // 老化后同一个桶里的结点频次仍然相同，只需把桶 f 整体拼接到桶 max(f >> shift, 1) 后面
+    void reconcileBuckets() {
+      if (pendingShifts_ == 0) {
+        return;
+      }
+      std::array<uint32_t, kMaxFreq + 1> oldHead = bucketHead_;
+      std::array<uint32_t, kMaxFreq + 1> oldTail = bucketTail_;
+      bucketHead_.fill(kNil);
+      bucketTail_.fill(kNil);
+      minFreq_ = kMaxFreq;
+      for (int freq = 1; freq <= kMaxFreq; ++freq) {
+        if (oldHead[freq] == kNil) {
+          continue;
+        }
+        int target = std::max(freq >> std::min(pendingShifts_, 8), 1);
+        if (bucketTail_[target] == kNil) {
+          bucketHead_[target] = oldHead[freq];
+        } else {
+          next_[bucketTail_[target]] = oldHead[freq];
+          prev_[oldHead[freq]] = bucketTail_[target];
+        }
+        bucketTail_[target] = oldTail[freq];
+        minFreq_ = std::min(minFreq_, target);
+      }
+      pendingShifts_ = 0;
+    }
+
+  public:
+    // f -> max(f >> 1, min(f, 1))：空槽(0)保持为0，其余减半且不低于1，返回减半后的总和
+    // CPU支持AVX2时整块32个计数一起处理(编译时已开启 -mavx2 则直接调用)，尾部与不支持时走标量循环
+    static uint64_t halveFreqs(Freq* freqs, size_t n) {
+#if defined(__AVX2__)
+      return halveFreqsAvx2(freqs, n);
+#elif defined(__x86_64__) && defined(__GNUC__)
+      return vectorizedAging() ? halveFreqsAvx2(freqs, n) : halveFreqsScalar(freqs, n);
+#else
+      return halveFreqsScalar(freqs, n);
+#endif
+    }
+
+    // 老化是否走AVX2路径，仅用于观测与测试
+    static bool vectorizedAging() {
+#if defined(__AVX2__)
+      return true;
+#elif defined(__x86_64__) && defined(__GNUC__)
+      static const bool supported = __builtin_cpu_supports("avx2");
+      return supported;
+#else
+      return false;
+#endif
+    }
+
+    // 标量版本，从下标 begin 处理到末尾，total 为已处理部分的和
+    static uint64_t halveFreqsScalar(Freq* freqs, size_t n, size_t begin = 0, uint64_t total = 0) {
+      for (size_t i = begin; i < n; ++i) {
+        Freq f = freqs[i];
+        freqs[i] = static_cast<Freq>(std::max<int>(f >> 1, std::min<int>(f, 1)));
+        total += freqs[i];
+      }
+      return total;
+    }
+
+  private:
+#if defined(__x86_64__) && defined(__GNUC__)
+    __attribute__((target("avx2")))
+    static uint64_t halveFreqsAvx2(Freq* freqs, size_t n) {
+      const __m256i low7 = _mm256_set1_epi8(0x7f);
+      const __m256i ones = _mm256_set1_epi8(1);
+      const __m256i zero = _mm256_setzero_si256();
+      __m256i sums = zero;
+      size_t i = 0;
+      for (; i + 32 <= n; i += 32) {
+        __m256i* p = reinterpret_cast<__m256i*>(freqs + i);
+        __m256i v = _mm256_loadu_si256(p);
+        __m256i half = _mm256_and_si256(_mm256_srli_epi16(v, 1), low7);
+        __m256i r = _mm256_max_epu8(half, _mm256_min_epu8(v, ones));
+        _mm256_storeu_si256(p, r);
+        sums = _mm256_add_epi64(sums, _mm256_sad_epu8(r, zero));
+      }
+      alignas(32) uint64_t lanes[4];
+      _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sums);
+      return halveFreqsScalar(freqs, n, i, lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    }
+#endif
+  };
+
+  // 绑定到 std::pmr::memory_resource 的版本
+  namespace pmr {
+    template<typename Key, typename Value>
+    using LfuSoaCache = MyCache::LfuSoaCache<Key, Value, PmrAlloc>;
+  }
+} // namespace MyCache
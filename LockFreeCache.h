@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include "CacheAllocator.h"
+#include "CachePolicy.h"
+#include "EpochReclaimer.h"
+
+namespace MyCache {
+  // 无锁缓存：组相联哈希表(每个桶8路，恰好一个cache line的原子指针) + 桶内CLOCK近似淘汰
+  // get 只有原子读和(必要时)一次引用位写入，从不阻塞；put 通过CAS发布不可变结点，冲突时重试
+  // 被替换/淘汰的结点经 EpochReclaimer 延迟释放，读者无需引用计数
+  // 每个key只能落在自己的桶里，容量按整桶向上取整，淘汰是桶内局部的近似LRU
+  // 容量可在线调低(setCapacity)：按每桶可用的路数限制，不能超过构造时的表大小
+  // Alloc需线程安全(std::allocator、synchronized_pool_resource等)
+  template<typename Key, typename Value, typename Alloc = DefaultAlloc>
+  class LockFreeCache : public CachePolicy<Key, Value> {
+  public:
+    using allocator_type = Alloc;
+    static constexpr size_t kWays = 8;
+
+  private:
+    // 发布后只读，唯一可变的是CLOCK引用位
+    struct Item {
+      size_t hash;
+      Key key;
+      Value value;
+      std::atomic<uint8_t> referenced;
+
+      Item(size_t h, const Key& k, const Value& v) : hash(h), key(k), value(v), referenced(0) {}
+    };
+
+    struct alignas(64) Bucket {
+      std::atomic<Item*> ways[kWays];
+
+      Bucket() {
+        for (auto& way : ways) {
+          way.store(nullptr, std::memory_order_relaxed);
+        }
+      }
+    };
+
+    Alloc alloc_;
+    std::vector<Bucket, RebindAlloc<Alloc, Bucket>> buckets_;
+    size_t mask_;
+    std::atomic<size_t> waysLimit_;   // 每桶可插入新key的路数(前若干路)，setCapacity 调整
+    std::atomic<size_t> trimCursor_;  // trim 下一次从这个桶开始扫描
+    EpochReclaimer<Alloc> reclaimer_;  // 放在最后：析构时先于 alloc_ 释放剩余的待回收结点
+
+    static size_t bucketCount(size_t capacity) {
+      size_t needed = (capacity + kWays - 1) / kWays;
+      size_t count = 1;
+      while (count < needed) {
+        count <<= 1;
+      }
+      return count;
+    }
+
+    static size_t hashOf(const Key& key) {
+      return std::hash<Key>()(key);
+    }
+
+    // std::hash对整数是恒等映射，混合后取高位定桶
+    Bucket& bucketFor(size_t hash) {
+      uint64_t mixed = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+      return buckets_[(mixed >> 32) & mask_];
+    }
+
+    static bool matches(const Item* item, size_t hash, const Key& key) {
+      return item && item->hash == hash && item->key == key;
+    }
+
+    static void destroyItem(void* context, void* object) {
+      destroyObject(static_cast<LockFreeCache*>(context)->alloc_, static_cast<Item*>(object));
+    }
+
+    void retire(Item* item) {
+      reclaimer_.retire(item, &LockFreeCache::destroyItem, this);
+    }
+
+    // 各线程从不同位置开始扫描，减少并发淘汰撞到同一路
+    static size_t clockStart() {
+      thread_local uint32_t state = static_cast<uint32_t>(std::hash<const void*>()(&state)) | 1u;
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return state % kWays;
+    }
+
+    // 桶内CLOCK(只在前 ways 路中选)：空位优先；否则清掉沿途的引用位，选第一个未被引用的结点
+    size_t chooseVictim(Bucket& bucket, size_t ways) {
+      for (size_t way = 0; way < ways; ++way) {
+        if (!bucket.ways[way].load(std::memory_order_relaxed)) {
+          return way;
+        }
+      }
+      size_t start = clockStart() % ways;
+      for (size_t step = 0; step < ways * 2; ++step) {
+        size_t way = (start + step) % ways;
+        Item* item = bucket.ways[way].load(std::memory_order_acquire);
+        if (!item) {
+          return way;
+        }
+        if (item->referenced.load(std::memory_order_relaxed)) {
+          item->referenced.store(0, std::memory_order_relaxed);
+          continue;
+        }
+        return way;
+      }
+      return start;
+    }
+
+    // 缩容后清掉桶内限制路数之外的结点，返回清掉的个数；调用者需已pin
+    size_t clearOverflow(Bucket& bucket, size_t ways, size_t maxEvictions) {
+      size_t evicted = 0;
+      for (size_t way = ways; way < kWays && evicted < maxEvictions; ++way) {
+        Item* item = bucket.ways[way].load(std::memory_order_acquire);
+        if (item && bucket.ways[way].compare_exchange_strong(item, nullptr, std::memory_order_acq_rel)) {
+          retire(item);
+          ++evicted;
+        }
+      }
+      return evicted;
+    }
+
+    // 两个put并发插入同一个新key时可能落在不同的路，只保留下标较小的一份
+    void dropDuplicate(Bucket& bucket, size_t inserted, Item* fresh) {
+      for (size_t way = 0; way < kWays; ++way) {
+        if (way == inserted) {
+          continue;
+        }
+        Item* other = bucket.ways[way].load(std::memory_order_acquire);
+        if (other == fresh || !matches(other, fresh->hash, fresh->key)) {
+          continue;
+        }
+        if (way < inserted) {
+          if (bucket.ways[inserted].compare_exchange_strong(fresh, nullptr, std::memory_order_acq_rel)) {
+            retire(fresh);
+          }
+          return;
+        }
+        if (bucket.ways[way].compare_exchange_strong(other, nullptr, std::memory_order_acq_rel)) {
+          retire(other);
+        }
+      }
+    }
+
+  public:
+    explicit LockFreeCache(size_t capacity, const Alloc& alloc = Alloc())
+      : alloc_(alloc), buckets_(bucketCount(capacity), RebindAlloc<Alloc, Bucket>(alloc))
+      , mask_(buckets_.size() - 1), waysLimit_(kWays), trimCursor_(0), reclaimer_(alloc) {}
+
+    LockFreeCache(const LockFreeCache&) = delete;
+    LockFreeCache& operator=(const LockFreeCache&) = delete;
+
+    // 析构时不得有并发访问
+    ~LockFreeCache() override {
+      for (Bucket& bucket : buckets_) {
+        for (auto& way : bucket.ways) {
+          destroyObject(alloc_, way.load(std::memory_order_relaxed));
+        }
+      }
+    }
+
+    allocator_type get_allocator() const { return alloc_; }
+
+    void put(Key key, Value value) override {
+      size_t ways = waysLimit_.load(std::memory_order_relaxed);
+      if (ways == 0) {
+        return;
+      }
+      size_t hash = hashOf(key);
+      Item* fresh = allocateObject<Item>(alloc_, hash, key, value);
+      auto guard = reclaimer_.pin();
+      Bucket& bucket = bucketFor(hash);
+      if (ways < kWays) {
+        clearOverflow(bucket, ways, kWays);  // 缩容后顺带清理所在桶，同key的旧结点也在其中，之后按新key插入
+      }
+      for (;;) {
+        // 已存在：CAS替换为新结点，保留引用位
+        bool retry = false;
+        for (size_t way = 0; way < kWays && !retry; ++way) {
+          Item* current = bucket.ways[way].load(std::memory_order_acquire);
+          if (!matches(current, hash, key)) {
+            continue;
+          }
+          fresh->referenced.store(current->referenced.load(std::memory_order_relaxed), std::memory_order_relaxed);
+          if (bucket.ways[way].compare_exchange_strong(current, fresh, std::memory_order_acq_rel)) {
+            retire(current);
+            return;
+          }
+          retry = true;  // 同一路被并发修改，重新扫描
+        }
+        if (retry) {
+          continue;
+        }
+
+        size_t way = chooseVictim(bucket, ways);
+        Item* victim = bucket.ways[way].load(std::memory_order_acquire);
+        if (bucket.ways[way].compare_exchange_strong(victim, fresh, std::memory_order_acq_rel)) {
+          if (victim) {
+            retire(victim);
+          }
+          dropDuplicate(bucket, way, fresh);
+          return;
+        }
+      }
+    }
+
+    bool get(Key key, Value& value) override {
+      PinnedPtr<const Value> pinned = find(key);
+      if (pinned) {
+        value = *pinned;
+        return true;
+      }
+      return false;
+    }
+
+    Value get(Key key) override {
+      Value value{};
+      get(key, value);
+      return value;
+    }
+
+    // 零拷贝读取：返回的指针在PinnedPtr存活期间有效，不拷贝value也不做引用计数
+    PinnedPtr<const Value> find(const Key& key) {
+      size_t hash = hashOf(key);
+      auto guard = reclaimer_.pin();
+      Bucket& bucket = bucketFor(hash);
+      for (auto& way : bucket.ways) {
+        Item* item = way.load(std::memory_order_acquire);
+        if (matches(item, hash, key)) {
+          // 已置位时不再写，热点key的读不会反复弄脏cache line
+          if (!item->referenced.load(std::memory_order_relaxed)) {
+            item->referenced.store(1, std::memory_order_relaxed);
+          }
+          return PinnedPtr<const Value>(std::move(guard), &item->value);
+        }
+      }
+      return PinnedPtr<const Value>();
+    }
+
+    bool remove(Key key) {
+      size_t hash = hashOf(key);
+      auto guard = reclaimer_.pin();
+      Bucket& bucket = bucketFor(hash);
+      for (auto& way : bucket.ways) {
+        Item* item = way.load(std::memory_order_acquire);
+        if (matches(item, hash, key) && way.compare_exchange_strong(item, nullptr, std::memory_order_acq_rel)) {
+          retire(item);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // 扫描全表统计，仅用于观测
+    size_t size() const {
+      size_t count = 0;
+      for (const Bucket& bucket : buckets_) {
+        for (const auto& way : bucket.ways) {
+          count += way.load(std::memory_order_relaxed) != nullptr;
+        }
+      }
+      return count;
+    }
+
+    size_t capacity() const { return buckets_.size() * waysLimit_.load(std::memory_order_relaxed); }
+
+    // 表的总路数，容量的上限
+    size_t slotCount() const { return buckets_.size() * kWays; }
+
+    // 在线调整容量：按每桶可用路数生效(向上取整到桶数的整数倍)，桶数在构造时确定，
+    // 容量不能增长到 slotCount() 之外，超出的请求被截断，返回实际生效的容量
+    // 缩容后新结点只写入每桶的前若干路，超出的结点由后续put(清理所在桶)或 trim 分批淘汰
+    size_t setCapacity(size_t capacity) {
+      size_t ways = std::min(capacity / buckets_.size() + (capacity % buckets_.size() != 0), kWays);
+      waysLimit_.store(ways, std::memory_order_relaxed);
+      return buckets_.size() * ways;
+    }
+
+    // 淘汰至多 maxEvictions 个落在限制路数之外的结点，返回实际淘汰数；每次调用至多扫描一遍全表
+    size_t trim(size_t maxEvictions) {
+      size_t ways = waysLimit_.load(std::memory_order_relaxed);
+      if (ways == kWays) {
+        return 0;
+      }
+      auto guard = reclaimer_.pin();
+      size_t evicted = 0;
+      size_t start = trimCursor_.load(std::memory_order_relaxed);
+      for (size_t step = 0; step < buckets_.size() && evicted < maxEvictions; ++step) {
+        size_t index = (start + step) & mask_;
+        evicted += clearOverflow(buckets_[index], ways, maxEvictions - evicted);
+        trimCursor_.store(index, std::memory_order_relaxed);
+      }
+      return evicted;
+    }
+  };
+
+  namespace pmr {
+    template<typename Key, typename Value>
+    using LockFreeCache = MyCache::LockFreeCache<Key, Value, PmrAlloc>;
+  }
+} // namespace MyCache
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <utility>
+
+#include "SpinWait.h"
+
+// 缓存引擎的锁策略：作为模板参数传入，满足 lock/unlock/try_lock 即可
+//   NullLock          单线程使用(线程私有缓存、离线模拟)，不产生任何原子操作
+//   SpinLock          临界区极短、线程数不超过核数时使用，带指数退避
+//   std::mutex        默认
+//   std::shared_mutex 提供 lock_shared 时，peek 等只读操作走共享锁
+//   ByteLock          1字节的锁，竞争时在全局停车表上睡眠，适合大量细粒度锁
+namespace MyCache {
+  class NullLock {
+  public:
+    void lock() {}
+    void unlock() {}
+    bool try_lock() { return true; }
+  };
+
+  class SpinLock {
+  private:
+    std::atomic<bool> locked_{false};
+
+  public:
+    void lock() {
+      SpinWait spin;
+      while (locked_.exchange(true, std::memory_order_acquire)) {
+        // 先只读等待，避免反复抢占cache line
+        while (locked_.load(std::memory_order_relaxed)) {
+          spin.wait();
+        }
+      }
+    }
+
+    bool try_lock() {
+      return !locked_.load(std::memory_order_relaxed) && !locked_.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() {
+      locked_.store(false, std::memory_order_release);
+    }
+  };
+
+  namespace detail {
+    // 停在某个地址上的线程：各自一个条件变量，唤醒时只叫醒被选中的那一个
+    struct ParkedThread {
+      const void* address;
+      bool signaled = false;
+      ParkedThread* next = nullptr;
+      std::condition_variable cv;
+
+      explicit ParkedThread(const void* addr) : address(addr) {}
+    };
+
+    // 停车位：散列到这里的等待者按到达顺序排队；多个锁可能散列到同一位置，按地址区分
+    struct alignas(64) ParkingSlot {
+      std::mutex mutex;
+      ParkedThread* head = nullptr;
+      ParkedThread* tail = nullptr;
+
+      // 持 mutex 调用
+      void enqueue(ParkedThread* thread) {
+        if (tail) {
+          tail->next = thread;
+        } else {
+          head = thread;
+        }
+        tail = thread;
+      }
+
+      // 持 mutex 调用：摘下最早停在address上的线程(没有时返回nullptr)，
+      // moreRemain 返回队列里是否还有停在同一地址上的线程
+      ParkedThread* dequeue(const void* address, bool& moreRemain) {
+        moreRemain = false;
+        ParkedThread* prev = nullptr;
+        ParkedThread* found = head;
+        while (found && found->address != address) {
+          prev = found;
+          found = found->next;
+        }
+        if (!found) {
+          return nullptr;
+        }
+        (prev ? prev->next : head) = found->next;
+        if (tail == found) {
+          tail = prev;
+        }
+        for (ParkedThread* t = found->next; t; t = t->next) {
+          if (t->address == address) {
+            moreRemain = true;
+            break;
+          }
+        }
+        found->next = nullptr;
+        return found;
+      }
+    };
+
+    inline ParkingSlot& parkingSlot(const void* address) {
+      static ParkingSlot slots[64];
+      uintptr_t bits = reinterpret_cast<uintptr_t>(address);
+      return slots[((bits >> 4) * 0x9E3779B97F4A7C15ULL) >> 58];
+    }
+  } // namespace detail
+
+  // 1字节锁：无竞争时一次CAS；竞争时先短暂自旋，再置"有人停车"位后睡眠
+  // 停车位表示该锁还有线程在睡：解锁时看到它才去停车位，每次只唤醒一个，还有其他停车者时保留该位，
+  // 被唤醒的线程与新来的线程公平竞争，抢不到就重新停车。无竞争解锁只是一次CAS
+  // (C++17没有atomic::wait，用全局停车表代替futex)
+  class ByteLock {
+  private:
+    static constexpr uint8_t kLocked = 1;
+    static constexpr uint8_t kParked = 2;
+    static constexpr uint32_t kSpinRounds = 8;
+
+    std::atomic<uint8_t> state_{0};
+
+    void lockSlow() {
+      SpinWait spin;
+      for (;;) {
+        uint8_t state = state_.load(std::memory_order_relaxed);
+        if (!(state & kLocked)) {
+          // 抢到锁时原样保留停车位：其他停车者仍需解锁时唤醒
+          if (state_.compare_exchange_weak(state, state | kLocked, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return;
+          }
+          continue;
+        }
+        if (!(state & kParked) && spin.rounds() < kSpinRounds) {
+          spin.wait();
+          continue;
+        }
+        detail::ParkingSlot& slot = detail::parkingSlot(this);
+        std::unique_lock<std::mutex> guard(slot.mutex);
+        // 在停车位的锁内置位并排队：解锁者要么在置位前解锁(CAS失败重试)，要么看到停车位、
+        // 等这把锁之后从队列里摘人，置位与排队对它是一体的
+        state = state_.load(std::memory_order_relaxed);
+        if (!(state & kLocked)) {
+          continue;
+        }
+        if (!(state & kParked) &&
+            !state_.compare_exchange_strong(state, state | kParked, std::memory_order_relaxed)) {
+          continue;
+        }
+        detail::ParkedThread self(this);
+        slot.enqueue(&self);
+        self.cv.wait(guard, [&self]() { return self.signaled; });
+      }
+    }
+
+    // 持锁且停车位已置：唤醒最早停车的一个线程，队列里还有同一把锁的停车者时保留停车位
+    void unlockSlow() {
+      detail::ParkingSlot& slot = detail::parkingSlot(this);
+      std::lock_guard<std::mutex> guard(slot.mutex);
+      bool moreRemain = false;
+      detail::ParkedThread* thread = slot.dequeue(this, moreRemain);
+      state_.store(moreRemain ? kParked : 0, std::memory_order_release);
+      if (thread) {
+        thread->signaled = true;
+        thread->cv.notify_one();  // 持停车位的锁通知：对方在重新拿到这把锁之前不会返回，结点仍然有效
+      }
+    }
+
+  public:
+    void lock() {
+      uint8_t expected = 0;
+      if (!state_.compare_exchange_weak(expected, kLocked, std::memory_order_acquire, std::memory_order_relaxed)) {
+        lockSlow();
+      }
+    }
+
+    bool try_lock() {
+      uint8_t state = state_.load(std::memory_order_relaxed);
+      while (!(state & kLocked)) {
+        if (state_.compare_exchange_weak(state, state | kLocked, std::memory_order_acquire, std::memory_order_relaxed)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void unlock() {
+      uint8_t expected = kLocked;
+      if (!state_.compare_exchange_strong(expected, 0, std::memory_order_release, std::memory_order_relaxed)) {
+        unlockSlow();
+      }
+    }
+  };
+
+  static_assert(sizeof(ByteLock) == 1, "ByteLock must stay one byte");
+
+  template<typename Lock, typename = void>
+  struct SupportsSharedLock : std::false_type {};
+
+  template<typename Lock>
+  struct SupportsSharedLock<Lock, std::void_t<decltype(std::declval<Lock&>().lock_shared())>> : std::true_type {};
+
+  // 只读操作的守卫：锁支持共享模式时加共享锁，否则退化为独占锁
+  template<typename Lock>
+  class SharedGuard {
+  private:
+    Lock& lock_;
+
+  public:
+    explicit SharedGuard(Lock& lock) : lock_(lock) {
+      if constexpr (SupportsSharedLock<Lock>::value) {
+        lock_.lock_shared();
+      } else {
+        lock_.lock();
+      }
+    }
+
+    ~SharedGuard() {
+      if constexpr (SupportsSharedLock<Lock>::value) {
+        lock_.unlock_shared();
+      } else {
+        lock_.unlock();
+      }
+    }
+
+    SharedGuard(const SharedGuard&) = delete;
+    SharedGuard& operator=(const SharedGuard&) = delete;
+  };
+} // namespace MyCache
@@ -1,78 +1,174 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
-#include <list>
+#include <functional>
+#include <initializer_list>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
-#include <unordered_map>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "CacheAllocator.h"
 #include "CachePolicy.h"
+#include "CoarseClock.h"
+#include "Delegation.h"
+#include "EpochReclaimer.h"
+#include "FlatCombining.h"
+#include "HotKeys.h"
+#include "KeyIndex.h"
+#include "LockFreeCache.h"
+#include "LockPolicy.h"
+#include "Maintenance.h"
+#include "ShardBudget.h"
+#include "SlotStore.h"
+#include "TryLock.h"
 
 namespace MyCache {
-  template <typename Key, typename Value> class LruCache;
+  // LRU结点负载(冷数据)：key引用与value；前后链接、访问次数放在 SlotStore 的元数据数组里
   template <typename Key, typename Value>
-  class LruNode {
-  private:
-    Key key_;
-    Value value_;
-    size_t accessCount_;  // 访问次数
-    std::shared_ptr<LruNode<Key, Value>> prev_;
-    std::shared_ptr<LruNode<Key, Value>> next_;
-  public:
-    LruNode(Key key, Value value) : key_(key), value_(value), accessCount_(1), prev_(nullptr), next_(nullptr) {}
+  struct LruNode {
+    using KeyRef = typename KeyRefTraits<Key>::type;  // 字符串key只保存索引中驻留副本的指针
 
-    Key getKey() const { return key_; }
-    Value getValue() const { return value_; }
-    void setValue(const Value& value) { value_ = value; }
-    size_t getAccessCount() const { return accessCount_; }
-    void incrementAccessCount() { ++accessCount_; }
+    KeyRef key{};
+    Value value{};
+    uint32_t touched = 0;  // 共享预算下最近一次插入/提升时的预算代数，用于比较各分片尾部年龄
+  };
 
-    friend class LruCache<Key, Value>;
+  // 命中时的提升限流：被限流的命中不动链表、不写元数据，只读取value
+  // 两个条件同时满足才提升；默认值即每次命中都提升
+  struct PromotionPolicy {
+    uint32_t minInterval = 0;  // 距该结点上次提升/插入不足这么多次get时不提升，约等于"已在最近端附近"
+    double probability = 1.0;  // 满足间隔后按此概率提升
+    const ClockCell* clock = nullptr;  // 非空时 minInterval 按该时钟的毫秒计(如 CoarseClock::global().cell())，而不是按get次数
   };
 
-  template<typename Key, typename Value>
+  // Alloc：结点、索引等全部内存的来源(字节分配器，内部rebind)
+  // Lock：锁策略(见 LockPolicy.h)，单线程使用时传 NullLock
+  template<typename Key, typename Value, typename Alloc = DefaultAlloc, typename Lock = std::mutex>
   class LruCache : public CachePolicy<Key, Value> {
   public:
-    using LruNodetype = LruNode<Key, Value>;
-    using NodePtr = std::shared_ptr<LruNodeType>;
-    using NodeMap = std::unordered_map<Key, NodePtr>;
+    using LruNodeType = LruNode<Key, Value>;
+    using NodeStore = SlotStore<LruNodeType, Alloc>;
+    using NodeMap = KeyIndex<Key, SlotIndex, Alloc>;  // 整数key走直接寻址，其余走哈希
+    using allocator_type = Alloc;
+    using lock_type = Lock;
+    using Budget = ShardBudget<LruCache, Alloc>;
+    using EvictionListener = std::function<void(const Key&, const Value&)>;
+    using EraseHook = void (*)(void* context, const Key& key);
   private:
-    int capacity_;  // 缓存容量
-    NodeMap nodeMap_; // key -> Node
-    std::mutex mutex_;
-    NodePtr dummyHead_; // 虚拟头节点
-    NodePtr dummyTail_;
-  public:
-    LruCache(int capacity) : capacity_(capacity) {
+    static constexpr int kReclaimAttempts = 4;  // 共享预算下插入前最多回收几次，之后在本分片内淘汰
+    static constexpr size_t kTrimPerOp = 4;     // 缩容后每次put/get顺带淘汰的上限，把一次性的长淘汰摊到后续操作
+
+    static constexpr size_t kKeepEvictedCapacity = 64;  // 淘汰缓冲区至少这么大才在用完后归还复用
+
+    using Evicted = std::pair<Key, Value>;
+    using EvictedList = std::vector<Evicted, RebindAlloc<Alloc, Evicted>>;
+
+    // 加锁区间：离开时先取走持锁期间淘汰下来的结点再解锁，随后在锁外回调监听器、析构value
+    // 没有淘汰(或未开启转移)时只多一次判空
+    class EvictingLock {
+    private:
+      LruCache& cache_;
+      std::unique_lock<Lock> lock_;
+
+    public:
+      explicit EvictingLock(LruCache& cache) : cache_(cache), lock_(cache.mutex_) {}
+      EvictingLock(LruCache& cache, std::defer_lock_t) : cache_(cache), lock_(cache.mutex_, std::defer_lock) {}
+
+      EvictingLock(const EvictingLock&) = delete;
+      EvictingLock& operator=(const EvictingLock&) = delete;
 
+      ~EvictingLock() {
+        if (lock_.owns_lock() && !cache_.evicted_.empty()) {
+          releaseEvicted();
+        }
+      }
+
+      std::unique_lock<Lock>& lock() { return lock_; }
+
+    private:
+      // 慢路径不内联，免得拖累没有淘汰的get/put
+#if defined(__GNUC__)
+      __attribute__((noinline))
+#endif
+      void releaseEvicted() {
+        EvictedList batch(std::move(cache_.evicted_));
+        lock_.unlock();
+        if (cache_.listener_) {
+          for (const Evicted& entry : batch) {
+            cache_.listener_(entry.first, entry.second);
+          }
+        }
+        batch.clear();  // value持有的资源在锁外释放
+        if (batch.capacity() >= kKeepEvictedCapacity) {
+          // 批量淘汰的缓冲区较大，归还给缓存复用，避免每批都重新申请(大块内存往往伴随缺页)
+          lock_.lock();
+          if (cache_.evicted_.empty()) {
+            cache_.evicted_.swap(batch);
+          }
+          lock_.unlock();
+        }
+      }
+    };
+
+    std::atomic<int> capacity_;  // 缓存容量，可在线调整；锁外只用于快速判断0容量
+    Alloc alloc_;
+    NodeMap nodeMap_; // key -> 槽位
+    NodeStore store_; // 槽位 -> 元数据/负载
+    SlotList lruList_; // 头部最久未访问，尾部最近访问
+    Lock mutex_;
+    ContentionStats contention_;  // tryGet/tryPut 的抢锁统计
+    // 提升限流，持锁访问；结点上次提升时的戳(getClock_ 或时钟的相对毫秒数)记在元数据的 flags 里
+    uint32_t minInterval_ = 0;
+    const ClockCell* clock_ = nullptr;
+    uint64_t clockBase_ = 0;    // 相对时间戳的基准
+    uint32_t promoteThreshold_ = UINT32_MAX;  // 随机数小于它才提升，UINT32_MAX表示总是提升
+    uint32_t getClock_ = 0;     // 每次get递增，允许回绕
+    uint32_t randomState_ = 0x9E3779B9;
+    Budget* budget_ = nullptr;  // 非空时容量由全局预算约束，capacity_ 只是单分片上限
+    MaintenanceExecutor* maintenance_ = nullptr;  // 非空时超出容量的淘汰交给后台，前台只在越过高水位时淘汰
+    double highWatermark_ = kDefaultHighWatermark;
+    // 批量淘汰：写满(高水位即容量)时一次淘汰 容量*(1-lowWatermark_) 个，之后的插入不再逐个淘汰；1.0 即逐个淘汰
+    double lowWatermark_ = 1.0;
+    EvictionListener listener_;
+    bool moveEvicted_ = false;  // 有回调或批量淘汰时淘汰的key/value移入 evicted_，解锁后再回调、析构
+    EvictedList evicted_;
+    EraseHook eraseHook_ = nullptr;  // 结点删除时持锁调用，供外部副本随之失效
+    void* eraseContext_ = nullptr;
+  public:
+    explicit LruCache(int capacity, const Alloc& alloc = Alloc())
+      : capacity_(capacity), alloc_(alloc), nodeMap_(alloc), store_(alloc), evicted_(RebindAlloc<Alloc, Evicted>(alloc)) {
+      nodeMap_.sizeHint(static_cast<size_t>(std::max(capacity, 0)));
     }
 
     ~LruCache() override = default;
 
+    allocator_type get_allocator() const { return alloc_; }
+
     // 添加缓存
     void put(Key key, Value value) override {
-      if (capacity_ <= 0) {
+      if (capacity_.load(std::memory_order_relaxed) <= 0) {
         return;
       }
-
-      std::lock_guard<std::mutex> lock(mutex_);
-      auto it = nodeMap_.find(key);
-      if (it != nodeMap_.end()) {
-        updateExistingNode(node, value);
+      if (budget_) {
+        putShared(key, value);
         return;
       }
-      
+
+      EvictingLock lock(*this);
+      putLocked(key, value);
     }
 
     bool get(Key key, Value& value) override {
-      std::lock_guard<std::mutex> lock(mutex_);
-      auto it = nodeMap_.find(key);
-      if (it != nodeMap_.end()) {
-        move2MostRecent(it->second);
-        value = it->second->getValue();
-        return true;
-      }
-      return false;
+      EvictingLock lock(*this);
+      return getLocked(key, value);
     }
 
     Value get(Key key) override {
@@ -81,75 +177,428 @@ namespace MyCache {
       return value;
     }
 
+    // 有界等待的读取：预算内抢不到锁返回Contended，不读数据也不更新最近访问，调用方按未命中处理
+    TryStatus tryGet(Key key, Value& value, const TryBudget& budget = TryBudget()) {
+      EvictingLock lock(*this, std::defer_lock);
+      if (!tryLockWithin(lock.lock(), budget, contention_)) {
+        return TryStatus::Contended;
+      }
+      return getLocked(key, value) ? TryStatus::Hit : TryStatus::Miss;
+    }
+
+    // 有界等待的写入：预算内抢不到锁则丢弃这次写入并返回false
+    bool tryPut(Key key, Value value, const TryBudget& budget = TryBudget()) {
+      if (capacity_.load(std::memory_order_relaxed) <= 0) {
+        return true;
+      }
+      EvictingLock lock(*this, std::defer_lock);
+      if (!tryLockWithin(lock.lock(), budget, contention_)) {
+        return false;
+      }
+      putLocked(key, value);
+      return true;
+    }
+
+    // 只读查看：不更新最近访问，锁支持共享模式时多个peek可并行
+    bool peek(Key key, Value& value) {
+      SharedGuard<Lock> lock(mutex_);
+      SlotIndex* slot = nodeMap_.find(key);
+      if (slot) {
+        value = store_.payload(*slot).value;
+        return true;
+      }
+      return false;
+    }
+
+    // key存在时持锁调用 f(value)，不更新最近访问；与删除该结点互斥，供外部在锁内复制value
+    // f里不得再操作本缓存
+    template<typename F>
+    bool withValue(const Key& key, F&& f) {
+      SharedGuard<Lock> lock(mutex_);
+      SlotIndex* slot = nodeMap_.find(key);
+      if (slot) {
+        f(static_cast<const Value&>(store_.payload(*slot).value));
+        return true;
+      }
+      return false;
+    }
+
+    const ContentionStats& contentionStats() const { return contention_; }
+
+    void setPromotionPolicy(const PromotionPolicy& policy) {
+      std::lock_guard<Lock> lock(mutex_);
+      minInterval_ = policy.minInterval;
+      if (policy.clock != clock_) {
+        // 换了计时方式，已有结点的戳不再可比：统一记为当前时刻
+        clock_ = policy.clock;
+        clockBase_ = clock_ ? clock_->now() : 0;
+        uint32_t stamp = promotionStamp();
+        for (SlotIndex slot = lruList_.head; slot != kNilSlot; slot = store_.meta(slot).next) {
+          store_.meta(slot).flags = stamp;
+        }
+      }
+      if (policy.probability >= 1.0) {
+        promoteThreshold_ = UINT32_MAX;
+      } else if (policy.probability <= 0.0) {
+        promoteThreshold_ = 0;
+      } else {
+        promoteThreshold_ = static_cast<uint32_t>(policy.probability * UINT32_MAX);
+      }
+    }
+
     // 删除指定元素
     void remove(Key key) {
-      std::lock_guard<std::mutex> lock(mutex_);
-      auto it = nodeMap_.find(key);
-      if (it != nodeMap_.end()) {
-        removeNode(it->second);
-        nodeMap_.erase(it);
+      std::lock_guard<Lock> lock(mutex_);
+      SlotIndex* slot = nodeMap_.find(key);
+      if (slot) {
+        eraseSlot(*slot);
+      }
+    }
+
+    // 以下供重新分片时在分片间搬移结点
+    // 摘下指定key并取出value
+    bool take(const Key& key, Value& value) {
+      std::lock_guard<Lock> lock(mutex_);
+      SlotIndex* slot = nodeMap_.find(key);
+      if (!slot) {
+        return false;
+      }
+      SlotIndex target = *slot;
+      value = std::move(store_.payload(target).value);
+      eraseSlot(target);
+      return true;
+    }
+
+    // 摘下最久未访问的结点
+    bool takeLeastRecent(Key& key, Value& value) {
+      std::lock_guard<Lock> lock(mutex_);
+      if (lruList_.empty()) {
+        return false;
+      }
+      SlotIndex target = lruList_.head;
+      key = KeyRefTraits<Key>::toKey(store_.payload(target).key);  // 删除索引前拷出，字符串key的驻留副本随之释放
+      value = std::move(store_.payload(target).value);
+      eraseSlot(target);
+      return true;
+    }
+
+    // key不存在时插入到最近端；已存在(搬移期间有更新的写入)时保留现值，返回是否插入
+    bool putIfAbsent(const Key& key, const Value& value) {
+      if (capacity_.load(std::memory_order_relaxed) <= 0) {
+        return false;
       }
+      EvictingLock lock(*this);
+      if (nodeMap_.find(key)) {
+        return false;
+      }
+      putLocked(key, value);
+      return true;
+    }
+
+    // 在线调整容量：扩容立即生效；缩容只改上限，超出的结点由后续put/get每次顺带淘汰至多 kTrimPerOp 个，
+    // 或由后台任务调用 trim 分批淘汰，不在一次持锁中清空
+    void setCapacity(int capacity) {
+      std::lock_guard<Lock> lock(mutex_);
+      capacity_.store(capacity, std::memory_order_relaxed);
+      nodeMap_.sizeHint(static_cast<size_t>(std::max(capacity, 0)));
+      if (maintenance_ && nodeMap_.size() > static_cast<size_t>(std::max(capacity, 0))) {
+        maintenance_->notify();
+      }
+    }
+
+    int capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    size_t size() {
+      std::lock_guard<Lock> lock(mutex_);
+      return nodeMap_.size();
+    }
+
+    // 淘汰至多 maxEvictions 个超出容量的结点，返回实际淘汰数；调用方可循环调用直到返回0
+    size_t trim(size_t maxEvictions) {
+      EvictingLock lock(*this);
+      return trimLocked(maxEvictions);
+    }
+
+    // 延迟维护：executor非空时put只插入，超出容量的结点由后台调用 maintain 淘汰，get也不再顺带淘汰；
+    // 条目数涨到 容量*highWatermark 时前台退回同步淘汰。一般经 MaintenanceExecutor::watch 开启，传空指针恢复
+    void deferMaintenance(MaintenanceExecutor* executor, double highWatermark = kDefaultHighWatermark) {
+      std::lock_guard<Lock> lock(mutex_);
+      maintenance_ = executor;
+      highWatermark_ = highWatermark;
+    }
+
+    // 后台维护：淘汰至多 budget 个超出容量(低水位)的结点
+    size_t maintain(size_t budget) {
+      return trim(budget);
+    }
+
+    // 批量淘汰：插入时条目数达到容量就一次淘汰 容量*(1-ratio) 个，之后的插入不再逐个淘汰；
+    // 被淘汰的value(有回调时连同key)移入缓冲区，解锁后再回调、析构，锁内只剩链表与索引的删除。
+    // value可平凡析构且没有回调时锁外无事可做，不转移。代价是平均少存一些条目
+    // (场景14：ratio 0.9 时命中率低约1.2个百分点)。ratio>=1 恢复逐个淘汰
+    void setLowWatermark(double ratio) {
+      std::lock_guard<Lock> lock(mutex_);
+      lowWatermark_ = std::min(std::max(ratio, 0.0), 1.0);
+      updateMoveEvicted();
+    }
+
+    // 因容量(或共享预算)被淘汰的结点的回调，在解锁后由触发淘汰的线程调用；remove/take 不回调
+    // 须在并发使用前设置；回调里不得再操作本缓存
+    void setEvictionListener(EvictionListener listener) {
+      std::lock_guard<Lock> lock(mutex_);
+      listener_ = std::move(listener);
+      updateMoveEvicted();
+    }
+
+    // 结点因淘汰、缩容、remove/take 删除时，在持锁状态下调用 hook(context, key)
+    // 须在并发使用前设置；hook里不得再操作本缓存
+    void setEraseHook(EraseHook hook, void* context) {
+      std::lock_guard<Lock> lock(mutex_);
+      eraseHook_ = hook;
+      eraseContext_ = context;
+    }
+
+    // 加入共享预算：只能在缓存为空、尚未并发使用时调用
+    void attachBudget(Budget* budget) {
+      budget_ = budget;
+    }
+
+    // 供 ShardBudget 选择淘汰分片：尾部越久未访问分数越高，同龄时结点多的分片优先
+    bool evictionScore(uint64_t& score) {
+      std::lock_guard<Lock> lock(mutex_);
+      if (lruList_.empty()) {
+        return false;
+      }
+      uint32_t age = budget_->now() - store_.payload(lruList_.head).touched;
+      score = (static_cast<uint64_t>(age) << 32) | std::min<size_t>(nodeMap_.size(), UINT32_MAX);
+      return true;
+    }
+
+    bool evictForBudget() {
+      EvictingLock lock(*this);
+      if (lruList_.empty()) {
+        return false;
+      }
+      evictLeastRecent();
+      return true;
     }
   private:
-    void initList() {
-      dummyHead_ = std::make_shared<LruNodetype>(Key(), Value());
-      dummyTail_ = std::make_shared<LruNodetype>(Key(), Value());
-      dummyHead_ -> next_ = dummyTail_;
-      dummyTail_ -> prev_ = dummyHead_;
+    // 共享预算下的写入：预算用尽时先从采样到的最旧分片回收一个单位，回收时不持有本分片锁
+    void putShared(const Key& key, const Value& value) {
+      // 全局预算缩容后超出的部分同样分摊：每次写入先多回收几个单位
+      for (size_t i = 0; i < kTrimPerOp && budget_->excess() > 0; ++i) {
+        if (!budget_->reclaim()) {
+          break;
+        }
+      }
+      for (int attempt = 0; attempt < kReclaimAttempts; ++attempt) {
+        {
+          EvictingLock lock(*this);
+          trimInline();
+          SlotIndex* slot = nodeMap_.find(key);
+          if (slot) {
+            updateExistingNode(*slot, value);
+            return;
+          }
+          if (budget_->tryAcquire()) {
+            addNewNode(key, value);
+            return;
+          }
+        }
+        if (!budget_->reclaim()) {
+          break;
+        }
+      }
+      EvictingLock lock(*this);
+      putLocked(key, value);
     }
 
-    void removeNode(NodePtr node) {
-      node->prev_->next_ = node->next_;
-      node->next_->prev_ = node->prev_;
+    // 以下均在持锁时调用
+    void putLocked(const Key& key, const Value& value) {
+      trimInline();
+      SlotIndex* slot = nodeMap_.find(key);
+      if (slot) {
+        updateExistingNode(*slot, value);
+        return;
+      }
+      if (budget_ && !budget_->tryAcquire()) {
+        // 预算用尽且不回收其他分片(tryPut或回收失败)：在本分片内以旧换新，先占单位再淘汰，总数不超预算；
+        // 本分片没有可淘汰的结点时放弃这次写入
+        if (lruList_.empty()) {
+          return;
+        }
+        budget_->forceAcquire();
+        evictLeastRecent();
+      }
+      addNewNode(key, value);
+    }
+
+    bool getLocked(const Key& key, Value& value) {
+      ++getClock_;
+      trimInline();
+      SlotIndex* slot = nodeMap_.find(key);
+      if (slot) {
+        if (shouldPromote(*slot)) {
+          move2MostRecent(*slot);
+        }
+        value = store_.payload(*slot).value;
+        return true;
+      }
+      return false;
+    }
+
+    // 提升戳：按get次数计时取 getClock_，按时钟计时取相对毫秒数(一次relaxed load)
+    uint32_t promotionStamp() const {
+      return clock_ ? toRelative(clock_->now(), clockBase_) : getClock_;
+    }
+
+    bool shouldPromote(SlotIndex slot) {
+      if (minInterval_ > 0 && elapsedSince(store_.meta(slot).flags, promotionStamp()) < minInterval_) {
+        return false;
+      }
+      if (promoteThreshold_ != UINT32_MAX) {
+        // xorshift32
+        randomState_ ^= randomState_ << 13;
+        randomState_ ^= randomState_ >> 17;
+        randomState_ ^= randomState_ << 5;
+        return randomState_ < promoteThreshold_;
+      }
+      return true;
+    }
+
+    size_t trimLocked(size_t maxEvictions) {
+      size_t limit = static_cast<size_t>(std::max(capacity_.load(std::memory_order_relaxed), 0));
+      size_t evicted = 0;
+      while (evicted < maxEvictions && nodeMap_.size() > limit) {
+        evictLeastRecent();
+        ++evicted;
+      }
+      return evicted;
+    }
+
+    // put/get顺带的淘汰：延迟维护时交给后台
+    void trimInline() {
+      if (!maintenance_) {
+        trimLocked(kTrimPerOp);
+      }
+    }
+
+    // 持锁调用：有回调，或批量淘汰且value析构有代价时，才把淘汰的结点移到锁外
+    void updateMoveEvicted() {
+      moveEvicted_ = static_cast<bool>(listener_) || (lowWatermark_ < 1.0 && !std::is_trivially_destructible<Value>::value);
+    }
+
+    // 写满时淘汰一批：批量按容量计算(容量 - 容量*lowWatermark_，至少1个)，与当前超出容量多少无关；
+    // 缩容留下的超额仍由 trimInline/trim 分批淘汰，不在一次插入里持锁清完
+    void evictToLowWatermark(size_t capacity) {
+      size_t target = static_cast<size_t>(static_cast<double>(capacity) * lowWatermark_);
+      size_t batch = capacity > target ? capacity - target : 1;
+      if (moveEvicted_) {
+        evicted_.reserve(evicted_.size() + batch);
+      }
+      for (size_t i = 0; i < batch && !lruList_.empty(); ++i) {
+        evictLeastRecent();
+      }
+    }
+
+    void eraseSlot(SlotIndex slot) {
+      notifyErase(slot);
+      removeNode(slot);
+      nodeMap_.erase(store_.payload(slot).key);
+      store_.release(slot);
+      if (budget_) {
+        budget_->release();
+      }
+    }
+
+    void notifyErase(SlotIndex slot) {
+      if (eraseHook_) {
+        eraseHook_(eraseContext_, KeyRefTraits<Key>::toKey(store_.payload(slot).key));
+      }
+    }
+
+    void removeNode(SlotIndex slot) {
+      lruList_.remove(store_, slot);
     }
 
     // 从尾部插入
-    void insertNode(NodePtr node) {
-      node->next_ = dummyTail_->next;
-      node->prev_ = dummyTail_->prev_;
-      dummyTail_->prev_->next_ = node;
-      dummyTail_->prev_ = node;
+    void insertNode(SlotIndex slot) {
+      lruList_.pushBack(store_, slot);
     }
 
-    // 驱逐最近最少访问
+    // 驱逐最近最少访问：链表操作只碰元数据，负载只在删除索引时读取一次key引用
     void evictLeastRecent() {
-      NodePtr leastRecent = dummyHead_->next_;  // 队头
+      SlotIndex leastRecent = lruList_.head;  // 队头
+      if (moveEvicted_) {
+        LruNodeType& node = store_.payload(leastRecent);
+        evicted_.emplace_back(listener_ ? KeyRefTraits<Key>::toKey(node.key) : Key(), std::move(node.value));
+      }
+      notifyErase(leastRecent);
       removeNode(leastRecent);
-      nodeMap_.erase(leastRecent->getKey());
+      nodeMap_.erase(store_.payload(leastRecent).key);  // 按结点保存的KeyRef删除，无需拷贝key
+      store_.release(leastRecent);
+      if (budget_) {
+        budget_->release();
+      }
     }
 
     // 移动到最新位置
-    void move2MostRecent(NodePtr node) {
-      removeNode(node);
-      insertNode(node);
+    void move2MostRecent(SlotIndex slot) {
+      removeNode(slot);
+      insertNode(slot);
+      SlotMeta& meta = store_.meta(slot);
+      ++meta.count;
+      meta.flags = promotionStamp();
+      if (budget_) {
+        store_.payload(slot).touched = budget_->now();
+      }
     }
 
     // 更新缓存中的节点值
-    void updateExistingNode(NodePtr node, const Value& value) {
-      node->setValue(value);
-      move2MostRecent(node);
+    void updateExistingNode(SlotIndex slot, const Value& value) {
+      store_.payload(slot).value = value;
+      move2MostRecent(slot);
     }
 
     // 添加新节点
     void addNewNode(const Key& key, const Value& value) {
-      if (nodeMap_.size() >= capacity_) {
-        evictLeastRecent();
+      // 并发缩到0时链表可能已空，多出的这一个结点由下次操作裁掉
+      size_t capacity = static_cast<size_t>(std::max(capacity_.load(std::memory_order_relaxed), 0));
+      if (maintenance_) {
+        if (!lruList_.empty() && nodeMap_.size() >= highWatermarkLimit(capacity, highWatermark_)) {
+          evictLeastRecent();
+        }
+      } else if (!lruList_.empty() && nodeMap_.size() >= capacity) {
+        evictToLowWatermark(capacity);
+      }
+      SlotIndex slot = store_.allocate();
+      store_.meta(slot).count = 1;
+      store_.meta(slot).flags = promotionStamp();
+      insertNode(slot);
+      LruNodeType& node = store_.payload(slot);
+      node.value = value;
+      node.key = nodeMap_.insert(key, slot);
+      if (budget_) {
+        node.touched = budget_->now();
+      }
+      if (maintenance_ && nodeMap_.size() >= wakeLimit(capacity, highWatermark_)) {
+        maintenance_->notify();  // 超额积累到一定量，唤醒后台淘汰
       }
-      NodePtr newNode = std::make_shared<LruNodetype>(key, value);
-      insertNode(newNode);
-      nodeMap_[key] = newNode;
     }
   };
   
   // 优化：LRU-k
-  template<typename Key, typename Value>
-  class LruKCache : public LruCache<Key, Value> {
+  template<typename Key, typename Value, typename Alloc = DefaultAlloc, typename Lock = std::mutex>
+  class LruKCache : public LruCache<Key, Value, Alloc, Lock> {
   private:
+    using Base = LruCache<Key, Value, Alloc, Lock>;
+    using HistoryList = LruCache<Key, size_t, Alloc, Lock>;
+
     int k_;   // 进入缓存队列的评判标准
-    std::unique_ptr<LruCache<Key, size_t>> historyList_;  // 访问数据历史记录(value=访问次数)
+    AllocUniquePtr<HistoryList, Alloc> historyList_;  // 访问数据历史记录(value=访问次数)
   public:
-    LruKCache(int capacity, int historyCapacity, int k) 
-      : LruKCache<Key, Value>(capacity), historyList_(std::make_unique<LruCache<Key, size_t>>(historyCapacity)), k_(k)
+    LruKCache(int capacity, int historyCapacity, int k, const Alloc& alloc = Alloc())
+      : Base(capacity, alloc), k_(k), historyList_(allocateUnique<HistoryList>(alloc, historyCapacity, alloc))
       {}
     
     Value get(Key key) {
@@ -158,13 +607,15 @@ namespace MyCache {
       // 存在，count++
       historyList_->put(key, ++historyCount);
       // 读数据（不一定能获取到）
-      return LruCache<Key, Value>::get(key);
+      return Base::get(key);
     }
 
     void put(Key key, Value value) {
       // 判断是否存在缓存中
-      if (LruCache<Key, Value>::get(key) != "") {
-        LruCache<Key, Value>::put(key, value);  // 存在，直接覆盖
+      Value existing{};
+      if (Base::get(key, existing)) {
+        Base::put(key, value);  // 存在，直接覆盖
+        return;
       }
 
       // 获取访问次数
@@ -172,51 +623,738 @@ namespace MyCache {
       historyList_->put(key, ++historyCount);
 
       // 次数达到上限，添加入缓存
-      if (historyCount >= k_) {
+      if (historyCount >= static_cast<size_t>(k_)) {
         historyList_->remove(key);
-        LruCache<Key, Value::put(key, value);
+        Base::put(key, value);
       }
     }
   };
 
+  // 分片的同步方式
+  enum class ShardMode {
+    Locked,         // 各分片自带互斥锁，调用线程直接操作
+    FlatCombining,  // 操作挂到分片的发布槽，由抢到合并锁的线程批量执行
+    Delegated,      // 每个分片由一个属主线程独占(分片不带锁)，其他线程经MPSC队列提交请求，管理操作也经队列执行
+  };
+
   // 优化：lru分片，提高高并发使用性能 (没有继承)
-  template<typename Key, typename Value>
+  // 分片对象本身也经由Alloc分配，整个缓存的内存都来自同一个分配器
+  // 分片数可在线调整(reshard)：路由切到新布局后，旧布局的结点按最久未访问优先逐步搬到新布局，
+  // 搬移期间查找先查新布局、未命中再查旧布局；布局的生命周期由epoch保护，每次操作只公布一次epoch
+  template<typename Key, typename Value, typename Alloc = DefaultAlloc>
   class HashLruCaches {
   private:
-    size_t capacity_; // 总容量
-    int sliceNum_;    // 切片数量
-    std::vector<std::unique_ptr<LruCache<Key, Value>>> lruSliceCaches_; // 切片lru缓存
+    using Slice = LruCache<Key, Value, Alloc>;
+    using SlicePtr = AllocUniquePtr<Slice, Alloc>;
+    // FlatCombining模式的分片仍带锁：共享预算下别的分片会直接回收本分片(evictForBudget)，重新分片的搬移与
+    // 管理操作(onSlice)也直接访问分片，都不经合并者。合并路径上锁只被合并者持有，不争用，代价是一次本核原子操作
+    using Combiner = FlatCombiner<Slice>;
+    using CombinerPtr = AllocUniquePtr<Combiner, Alloc>;
+    using OwnedSlice = LruCache<Key, Value, Alloc, NullLock>;  // Delegated模式的分片：只被属主线程访问
+    using OwnedSlicePtr = AllocUniquePtr<OwnedSlice, Alloc>;
+    using Owner = ShardOwner<OwnedSlice, Key, Value, Alloc>;
+    using OwnerPtr = AllocUniquePtr<Owner, Alloc>;
+    using Op = typename Owner::Op;
+    using OpKind = typename Owner::OpKind;
+    using Budget = typename Slice::Budget;
+    using BudgetPtr = AllocUniquePtr<Budget, Alloc>;
+    using HotSet = LockFreeCache<Key, Value, Alloc>;
+    using HotSetPtr = AllocUniquePtr<HotSet, Alloc>;
+    using Detector = HotKeyDetector<Alloc>;
+    using DetectorPtr = AllocUniquePtr<Detector, Alloc>;
+
+    static constexpr size_t kMigratePerOp = 4;  // 重新分片期间每次操作顺带搬移的结点数
+
+    // 一种分片布局，重新分片时整体替换；成员按析构顺序倒序排列
+    struct Layout {
+      int sliceNum;     // 切片数量
+      BudgetPtr budget;  // Shared容量模式下各分片共用，须比分片后析构
+      std::vector<SlicePtr, RebindAlloc<Alloc, SlicePtr>> slices; // 切片lru缓存(Locked/FlatCombining模式)
+      std::vector<OwnedSlicePtr, RebindAlloc<Alloc, OwnedSlicePtr>> ownedSlices;  // Delegated模式的分片
+      std::vector<CombinerPtr, RebindAlloc<Alloc, CombinerPtr>> combiners;  // FlatCombining模式下每个分片一个
+      std::vector<OwnerPtr, RebindAlloc<Alloc, OwnerPtr>> owners;           // Delegated模式下每个分片一个属主线程，最先析构
+      std::atomic<size_t> cursor;  // 作为旧布局被搬空时，轮流从各分片摘结点
+      std::mutex migrateMutex;     // 作为旧布局时，一个结点的"摘下-放入新布局"与remove互斥，删除的key不会被搬回
+
+      Layout(int n, const Alloc& alloc)
+        : sliceNum(n), budget(nullptr, AllocDeleter<Budget, Alloc>{alloc}), slices(RebindAlloc<Alloc, SlicePtr>(alloc))
+        , ownedSlices(RebindAlloc<Alloc, OwnedSlicePtr>(alloc)), combiners(RebindAlloc<Alloc, CombinerPtr>(alloc))
+        , owners(RebindAlloc<Alloc, OwnerPtr>(alloc)), cursor(0) {}
+
+      size_t indexOf(size_t hash) const { return hash % sliceNum; }
+    };
+
+    std::atomic<size_t> capacity_; // 总容量
+    ShardMode mode_;
+    ShardCapacity capacityMode_;
+    Alloc alloc_;
+    // 写入与管理操作持有布局指针期间公布epoch：切换后等宽限期即可确认旧布局不再有写入者(封存)
+    // get 在非Delegated模式下不 pin，只 acquire 读布局指针，见 retireLayout
+    mutable EpochReclaimer<Alloc> reclaimer_;
+    std::atomic<Layout*> layout_;       // 当前布局
+    std::atomic<Layout*> draining_;     // 重新分片期间的旧布局，搬空后为空
+    std::atomic<bool> sealed_;          // 旧布局已不再有写入者(切换前开始的操作都已结束)，此后才开始搬移
+    mutable std::mutex reshardMutex_;   // 串行化布局的替换与释放，以及需要遍历布局的管理操作
+    std::vector<Layout*, RebindAlloc<Alloc, Layout*>> retiredLayouts_;  // 搬空的旧布局，析构时释放；受 reshardMutex_ 保护
+    PromotionPolicy promotionPolicy_;   // 新布局沿用，受 reshardMutex_ 保护
+    MaintenanceExecutor* maintenance_ = nullptr;  // 同上，新布局的分片沿用延迟维护设置
+    double highWatermark_ = kDefaultHighWatermark;
+    double lowWatermark_ = 1.0;                   // 同上，新布局的分片沿用批量淘汰与淘汰回调
+    typename Slice::EvictionListener listener_;
+    // 热点key复制：检测到的热点key在无锁集合里保留一份副本，未采样的读取直接从副本返回，不碰分片锁
+    HotSetPtr hotSet_;
+    DetectorPtr detector_;
+    uint32_t sampleRate_;
 
     // 将key转为对应Hash值
     size_t Hash(Key key) {
       std::hash<Key> hashFunc;
       return hashFunc(key);
     }
+
+    // 分片删除结点时同步删除其副本(持分片锁调用)
+    static void dropHotReplica(void* context, const Key& key) {
+      static_cast<HotSet*>(context)->remove(key);
+    }
+
+    // 新分片沿用提升限流、延迟维护、批量淘汰与淘汰回调设置，开启热点复制时挂上副本失效回调
+    template<typename S>
+    void configureSlice(S& slice) {
+      slice.setPromotionPolicy(promotionPolicy_);
+      if (maintenance_) {
+        slice.deferMaintenance(maintenance_, highWatermark_);
+      }
+      if (lowWatermark_ < 1.0) {
+        slice.setLowWatermark(lowWatermark_);
+      }
+      if (listener_) {
+        slice.setEvictionListener(listener_);
+      }
+      if (hotSet_) {
+        slice.setEraseHook(&HashLruCaches::dropHotReplica, hotSet_.get());
+      }
+    }
+
+    Layout* buildLayout(int sliceNum) {
+      Layout* layout = allocateObject<Layout>(alloc_, sliceNum, alloc_);
+      size_t capacity = capacity_.load(std::memory_order_relaxed);
+      size_t sliceSize = std::ceil(capacity / static_cast<double>(sliceNum));  // 获取每个分片的大小
+      if (mode_ == ShardMode::Delegated) {
+        for (int i = 0; i < sliceNum; ++i) {
+          layout->ownedSlices.push_back(allocateUnique<OwnedSlice>(alloc_, sliceSize, alloc_));
+          configureSlice(*layout->ownedSlices.back());  // 属主线程启动前配置，之后只经队列访问
+          layout->owners.push_back(allocateUnique<Owner>(alloc_, *layout->ownedSlices.back(), alloc_));
+        }
+        return layout;
+      }
+      if (capacityMode_ == ShardCapacity::Shared) {
+        layout->budget = allocateUnique<Budget>(alloc_, capacity, alloc_);
+        sliceSize = capacity;  // 单个分片最多可用满总容量
+      }
+      for (int i = 0; i < sliceNum; ++i) {
+        layout->slices.push_back(allocateUnique<Slice>(alloc_, sliceSize, alloc_));
+        Slice& slice = *layout->slices.back();
+        configureSlice(slice);
+        if (layout->budget) {
+          slice.attachBudget(layout->budget.get());
+          layout->budget->addShard(&slice);
+        }
+        if (mode_ == ShardMode::FlatCombining) {
+          layout->combiners.push_back(allocateUnique<Combiner>(alloc_, slice));
+        }
+      }
+      return layout;
+    }
+
+    // 以下要求调用方已 pin 住 reclaimer_，或是 get 的快速路径(非Delegated模式的布局不会在析构前释放)
+    // 直接访问带锁的分片，仅用于Locked/FlatCombining模式
+    Slice& sliceOf(Layout& layout, const Key& key) {
+      return *layout.slices[layout.indexOf(Hash(key))];
+    }
+
+    // 在第index个分片上执行 f(slice)：Delegated模式下投递到属主线程执行并等待，其余模式直接调用(分片自带锁)
+    // 两种分片类型都会实例化f，须写成泛型lambda
+    template<typename F>
+    void onSlice(Layout& layout, size_t index, F&& f) {
+      if (mode_ == ShardMode::Delegated) {
+        layout.owners[index]->execute(f);
+      } else {
+        f(*layout.slices[index]);
+      }
+    }
+
+    template<typename F>
+    void forEachSlice(Layout& layout, F&& f) {
+      for (size_t i = 0; i < static_cast<size_t>(layout.sliceNum); ++i) {
+        onSlice(layout, i, f);
+      }
+    }
+
+    // 新布局未命中时查旧布局：封存前旧布局可能仍有写入，只读；封存后连同value搬到新布局
+    // 持旧布局的搬移锁：调用方查过新布局之后才被搬走的key此时已放入新布局，旧布局未命中时再查一次新布局
+    bool getFromDraining(Layout& current, Layout& old, const Key& key, Value& value) {
+      size_t hash = Hash(key);
+      bool found = false;
+      std::lock_guard<std::mutex> lock(old.migrateMutex);
+      if (!sealed_.load(std::memory_order_acquire)) {
+        onSlice(old, old.indexOf(hash), [&key, &value, &found](auto& slice) { found = slice.peek(key, value); });
+      } else {
+        onSlice(old, old.indexOf(hash), [&key, &value, &found](auto& slice) { found = slice.take(key, value); });
+        if (found) {
+          onSlice(current, current.indexOf(hash), [&key, &value](auto& slice) { slice.putIfAbsent(key, value); });
+        }
+      }
+      return found || getIn(current, key, value);
+    }
+
+    // 从旧布局摘下至多 maxEntries 个最久未访问的结点，放到新布局的最近端：先搬的先进，
+    // 新布局里大致保持原先的先后；新布局已有同key(更新的写入)时丢弃旧值。旧布局已空时返回true
+    // 每个结点持旧布局的搬移锁搬移；wait为false(操作顺带搬移)时锁被占用即放弃，不在别人的搬移后排队
+    // 从游标处起依次试各分片，全都为空才算搬空：封存后旧布局只减不增，持锁扫一遍即可确认，
+    // 不能按游标连续取空计数，游标被其他线程推进时可能只轮到空分片
+    bool migrateFrom(Layout& current, Layout& old, size_t maxEntries, size_t& moved, bool wait = false) {
+      if (!sealed_.load(std::memory_order_acquire)) {
+        return false;
+      }
+      Key key{};
+      Value value{};
+      while (moved < maxEntries) {
+        std::unique_lock<std::mutex> lock(old.migrateMutex, std::defer_lock);
+        if (wait) {
+          lock.lock();
+        } else if (!lock.try_lock()) {
+          return false;
+        }
+        size_t start = old.cursor.fetch_add(1, std::memory_order_relaxed);
+        bool taken = false;
+        for (size_t i = 0; i < static_cast<size_t>(old.sliceNum) && !taken; ++i) {
+          onSlice(old, (start + i) % old.sliceNum, [&key, &value, &taken](auto& slice) { taken = slice.takeLeastRecent(key, value); });
+        }
+        if (!taken) {
+          return true;
+        }
+        onSlice(current, current.indexOf(Hash(key)), [&key, &value](auto& slice) { slice.putIfAbsent(key, value); });
+        ++moved;
+      }
+      return false;
+    }
+
+    // 旧布局搬空后释放：调用方不得 pin 住 reclaimer_；已被其他线程释放(或换成了更新的旧布局)时不做事
+    void finishReshard(Layout* old) {
+      std::lock_guard<std::mutex> lock(reshardMutex_);
+      if (draining_.load(std::memory_order_relaxed) == old) {
+        finishReshardLocked();
+      }
+    }
+
+    // 持 reshardMutex_ 调用：搬空旧布局(若尚未搬空)后交给 retireLayout
+    void finishReshardLocked() {
+      Layout* old = draining_.load(std::memory_order_relaxed);
+      if (!old) {
+        return;
+      }
+      Layout* current = layout_.load(std::memory_order_relaxed);
+      size_t moved = 0;
+      migrateFrom(*current, *old, SIZE_MAX, moved, true);  // 持锁时旧布局必已封存，一次搬空
+      draining_.store(nullptr, std::memory_order_release);
+      retireLayout(old);
+    }
+
+    // 持 reshardMutex_ 调用。Delegated模式下所有操作都 pin，等宽限期后连同属主线程释放；
+    // 其余模式的 get 不 pin，可能仍在读这个(已空的)布局，留到析构时释放。
+    // 保留的只是空分片，占用随重新分片次数增长，换来读路径上没有 pin 的 seq_cst 写入
+    void retireLayout(Layout* old) {
+      if (mode_ == ShardMode::Delegated) {
+        reclaimer_.synchronize();
+        destroyObject(alloc_, old);
+      } else {
+        retiredLayouts_.push_back(old);
+      }
+    }
+
+    // 把分片中的当前值复制到热点集合(已 pin)
+    // 副本的写入(提升、写后刷新)与删除(分片的淘汰、缩容、remove、搬移摘下)都在该key所在分片的锁内，
+    // 副本因而总是分片中仍存在的值，热点集合是缓存的子集：提升早于某次写入时，写者写完分片后一定能看到副本并刷新；
+    // 晚于写入时在锁内读到的就是新值
+    void promoteHotKey(Layout& current, const Key& key) {
+      HotSet& hotSet = *hotSet_;
+      onSlice(current, current.indexOf(Hash(key)), [&hotSet, &key](auto& slice) {
+        slice.withValue(key, [&hotSet, &key](const Value& value) {
+          if (!hotSet.find(key)) {
+            hotSet.put(key, value);
+          }
+        });
+      });
+    }
+
+    // 写入分片后调用(已 pin)：副本存在时在分片锁内按当前值重写，并发写者谁后刷新都以分片中最后的写入为准
+    void refreshHotKey(Layout& current, const Key& key) {
+      if (!hotSet_->find(key)) {
+        return;
+      }
+      HotSet& hotSet = *hotSet_;
+      onSlice(current, current.indexOf(Hash(key)), [&hotSet, &key](auto& slice) {
+        slice.withValue(key, [&hotSet, &key](const Value& value) { hotSet.put(key, value); });
+      });
+    }
+
+    // 按分片模式同步读取一个布局(已 pin)
+    bool getIn(Layout& layout, const Key& key, Value& value) {
+      size_t sliceIndex = layout.indexOf(Hash(key));
+      if (mode_ == ShardMode::Delegated) {
+        bool found = false;
+        Completion done;
+        Op op;
+        op.kind = OpKind::Get;
+        op.key = key;
+        op.out = &value;
+        op.found = &found;
+        op.done = &done;
+        layout.owners[sliceIndex]->submit(std::move(op));
+        done.wait();
+        return found;
+      }
+      if (mode_ == ShardMode::FlatCombining) {
+        bool found = false;
+        layout.combiners[sliceIndex]->execute([&key, &value, &found](Slice& slice) { found = slice.get(key, value); });
+        return found;
+      }
+      return layout.slices[sliceIndex]->get(key, value);
+    }
   public:
-    HashLruCaches(size_t capacity, int sliceNum)
-      : capacity_(capacity), sliceNum_(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency()) {
-      size_t sliceSize = std::ceil(capacity / static_cast<double>(sliceNum_));  // 获取每个分片的大小
-      for (int i = 0; i < sliceNum_; ++i) {
-        lruSliceCaches_.emplace_back(new LruCache<Key, Value>(sliceSize));
+    HashLruCaches(size_t capacity, int sliceNum, const Alloc& alloc = Alloc())
+      : HashLruCaches(capacity, sliceNum, ShardMode::Locked, alloc) {}
+
+    HashLruCaches(size_t capacity, int sliceNum, ShardMode mode, const Alloc& alloc = Alloc())
+      : HashLruCaches(capacity, sliceNum, mode, ShardCapacity::Fixed, alloc) {}
+
+    // ShardCapacity::Shared：分片按需伸缩，总量受全局预算约束，倾斜的key分布下命中率接近不分片的LRU
+    // Delegated模式只支持Fixed：共享预算的跨分片回收会从一个属主线程去淘汰别的属主线程的分片
+    HashLruCaches(size_t capacity, int sliceNum, ShardMode mode, ShardCapacity capacityMode, const Alloc& alloc = Alloc())
+      : capacity_(capacity), mode_(mode)
+      , capacityMode_(mode == ShardMode::Delegated ? ShardCapacity::Fixed : capacityMode), alloc_(alloc)
+      , reclaimer_(alloc), layout_(nullptr), draining_(nullptr), sealed_(true)
+      , retiredLayouts_(RebindAlloc<Alloc, Layout*>(alloc))
+      , hotSet_(nullptr, AllocDeleter<HotSet, Alloc>{alloc}), detector_(nullptr, AllocDeleter<Detector, Alloc>{alloc})
+      , sampleRate_(0) {
+      layout_.store(buildLayout(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency()), std::memory_order_relaxed);
+    }
+
+    HashLruCaches(const HashLruCaches&) = delete;
+    HashLruCaches& operator=(const HashLruCaches&) = delete;
+
+    // 析构时不得有并发访问
+    ~HashLruCaches() {
+      if (Layout* old = draining_.load(std::memory_order_relaxed)) {
+        destroyObject(alloc_, old);
+      }
+      for (Layout* retired : retiredLayouts_) {
+        destroyObject(alloc_, retired);
       }
+      destroyObject(alloc_, layout_.load(std::memory_order_relaxed));
     }
 
+    // Delegated模式下put只投递不等待：同一线程随后的get经同一队列，仍能读到这次写入
     void put(Key key, Value value) {
-      // 获取key的hash值，计算对应的分片索引
-      size_t sliceIndex = Hash(key) % sliceNum_;
-      return lruSliceCaches_[sliceIndex]->put(key, value);
+      putAsync(key, value, nullptr);
     }
 
     bool get(Key key, Value& value) {
-      size_t sliceIndex = Hash(key) % sliceNum_;
-      return lruSliceCaches_[sliceIndex]->get(key, value);
+      bool sampled = false;
+      if (hotSet_) {
+        if (!sampleThisRead(sampleRate_)) {
+          PinnedPtr<const Value> pinned = hotSet_->find(key);
+          if (pinned) {
+            value = *pinned;
+            return true;
+          }
+        } else {
+          sampled = true;  // 采样的读取照常走分片(维持分片内的最近访问)，并参与热点检测
+        }
+      }
+      // 快速路径：没有重新分片时不 pin。读取不往布局里写入，封存旧布局不需要等它；布局不会在析构前释放。
+      // 未命中且期间切换了布局时，key可能刚被搬走(搬移持分片锁，之后再读布局指针必能看到切换)，改走完整路径
+      if (mode_ != ShardMode::Delegated) {
+        Layout* current = layout_.load(std::memory_order_acquire);
+        if (!draining_.load(std::memory_order_acquire)) {
+          bool found = getIn(*current, key, value);
+          if (found || layout_.load(std::memory_order_acquire) == current) {
+            if (sampled && found && detector_->record(Hash(key))) {
+              promoteHotKey(*current, key);
+            }
+            return found;
+          }
+        }
+      }
+      bool found = false;
+      Layout* drained = nullptr;
+      {
+        auto guard = reclaimer_.pin();
+        Layout& current = *layout_.load(std::memory_order_acquire);
+        // 先于查新布局读取旧布局：查完新布局后旧布局才搬空、清除时，仍能经旧布局的搬移锁再查一次新布局
+        Layout* old = draining_.load(std::memory_order_acquire);
+        size_t hash = Hash(key);
+        found = getIn(current, key, value);
+        if (old) {
+          if (!found) {
+            found = getFromDraining(current, *old, key, value);
+          }
+          size_t moved = 0;
+          drained = migrateFrom(current, *old, kMigratePerOp, moved) ? old : nullptr;
+        }
+        if (sampled && found && detector_->record(hash)) {
+          promoteHotKey(current, key);
+        }
+      }
+      if (drained) {
+        finishReshard(drained);
+      }
+      return found;
     }
-    
+
+    // 异步写入：done非空时执行完调用 done->arrive()；非Delegated模式下立即同步完成
+    // 重新分片期间只写新布局，旧布局中的同key由搬移时丢弃
+    void putAsync(Key key, Value value, Completion* done) {
+      Layout* drained = nullptr;
+      {
+        auto guard = reclaimer_.pin();
+        Layout& current = *layout_.load(std::memory_order_acquire);
+        if (Layout* old = draining_.load(std::memory_order_acquire)) {
+          size_t moved = 0;
+          drained = migrateFrom(current, *old, kMigratePerOp, moved) ? old : nullptr;
+        }
+        // 获取key的hash值，计算对应的分片索引
+        size_t sliceIndex = current.indexOf(Hash(key));
+        if (mode_ == ShardMode::Delegated) {
+          Op op;
+          op.kind = OpKind::Put;
+          op.key = std::move(key);
+          op.value = std::move(value);
+          op.done = done;
+          current.owners[sliceIndex]->submit(std::move(op));
+        } else {
+          if (mode_ == ShardMode::FlatCombining) {
+            current.combiners[sliceIndex]->execute([&key, &value](Slice& slice) { slice.put(key, value); });
+          } else {
+            current.slices[sliceIndex]->put(key, value);
+          }
+          if (hotSet_) {
+            refreshHotKey(current, key);
+          }
+          if (done) {
+            done->arrive();
+          }
+        }
+      }
+      if (drained) {
+        finishReshard(drained);
+      }
+    }
+
+    // 异步读取：value、found与done须在完成前保持有效
+    // 重新分片期间需要在新布局未命中后再查旧布局，退化为同步执行
+    void getAsync(Key key, Value& value, bool& found, Completion& done) {
+      Layout* drained = nullptr;
+      {
+        auto guard = reclaimer_.pin();
+        Layout& current = *layout_.load(std::memory_order_acquire);
+        Layout* old = draining_.load(std::memory_order_acquire);
+        size_t sliceIndex = current.indexOf(Hash(key));
+        if (old) {
+          found = getIn(current, key, value) || getFromDraining(current, *old, key, value);
+          size_t moved = 0;
+          drained = migrateFrom(current, *old, kMigratePerOp, moved) ? old : nullptr;
+          done.arrive();
+        } else if (mode_ == ShardMode::Delegated) {
+          Op op;
+          op.kind = OpKind::Get;
+          op.key = std::move(key);
+          op.out = &value;
+          op.found = &found;
+          op.done = &done;
+          current.owners[sliceIndex]->submit(std::move(op));
+        } else {
+          found = getIn(current, key, value);
+          done.arrive();
+        }
+      }
+      if (drained) {
+        finishReshard(drained);
+      }
+    }
+
+    // 批量读取：一次把所有请求投递到各分片再统一等待，各分片并行执行
+    void getBatch(const Key* keys, size_t count, Value* values, bool* found) {
+      Completion done(static_cast<uint32_t>(count));
+      for (size_t i = 0; i < count; ++i) {
+        getAsync(keys[i], values[i], found[i], done);
+      }
+      done.wait();
+    }
+
+    void putBatch(const Key* keys, const Value* values, size_t count) {
+      Completion done(static_cast<uint32_t>(count));
+      for (size_t i = 0; i < count; ++i) {
+        putAsync(keys[i], values[i], &done);
+      }
+      done.wait();
+    }
+
     Value get(Key key) {
       Value value{};
       get(key, value);
       return value;
     }
+
+    // 有界等待版本只在Locked模式下直接抢分片锁；FlatCombining/Delegated模式本身不在分片锁上排队，
+    // 退化为普通的同步get/put；重新分片期间新布局抢锁失败即返回Contended，不再查旧布局
+    TryStatus tryGet(Key key, Value& value, const TryBudget& budget = TryBudget()) {
+      if (mode_ != ShardMode::Locked) {
+        return get(key, value) ? TryStatus::Hit : TryStatus::Miss;
+      }
+      if (hotSet_) {
+        PinnedPtr<const Value> pinned = hotSet_->find(key);
+        if (pinned) {
+          value = *pinned;
+          return TryStatus::Hit;
+        }
+      }
+      auto guard = reclaimer_.pin();
+      Layout& current = *layout_.load(std::memory_order_acquire);
+      Layout* old = draining_.load(std::memory_order_acquire);  // 先于查新布局读取，见 get
+      TryStatus status = sliceOf(current, key).tryGet(key, value, budget);
+      if (status == TryStatus::Miss && old && getFromDraining(current, *old, key, value)) {
+        return TryStatus::Hit;
+      }
+      return status;
+    }
+
+    bool tryPut(Key key, Value value, const TryBudget& budget = TryBudget()) {
+      if (mode_ != ShardMode::Locked) {
+        put(key, value);
+        return true;
+      }
+      auto guard = reclaimer_.pin();
+      Layout& current = *layout_.load(std::memory_order_acquire);
+      if (!sliceOf(current, key).tryPut(key, value, budget)) {
+        return false;
+      }
+      if (hotSet_) {
+        refreshHotKey(current, key);
+      }
+      return true;
+    }
+
+    // 删除key，任何模式下都可调用；重新分片期间新旧布局中的同key一并删除
+    void remove(Key key) {
+      auto guard = reclaimer_.pin();
+      Layout& current = *layout_.load(std::memory_order_acquire);
+      std::unique_lock<std::mutex> lock;
+      if (Layout* old = draining_.load(std::memory_order_acquire)) {
+        lock = std::unique_lock<std::mutex>(old->migrateMutex);  // 已摘下、尚未放入新布局的同key放入后再删
+        onSlice(*old, old->indexOf(Hash(key)), [&key](auto& slice) { slice.remove(key); });
+      }
+      onSlice(current, current.indexOf(Hash(key)), [&key](auto& slice) { slice.remove(key); });
+    }
+
+    // 在线调整分片数：立即切换路由，旧布局的结点随后续操作(每次至多 kMigratePerOp 个)或 migrate 搬到新布局
+    // 会等待切换前开始的操作结束(宽限期)；上一次重新分片尚未搬完时先同步搬完
+    // 搬移期间两套布局同时占用内存，总条目数可能短暂超过容量
+    void reshard(int sliceNum) {
+      if (sliceNum <= 0) {
+        sliceNum = std::thread::hardware_concurrency();
+      }
+      std::lock_guard<std::mutex> lock(reshardMutex_);
+      finishReshardLocked();
+      Layout* old = layout_.load(std::memory_order_relaxed);
+      if (old->sliceNum == sliceNum) {
+        return;
+      }
+      Layout* fresh = buildLayout(sliceNum);
+      sealed_.store(false, std::memory_order_relaxed);
+      draining_.store(old, std::memory_order_release);  // 先于切换公布：看到新布局的读者一定能查到旧布局
+      layout_.store(fresh, std::memory_order_release);
+      reclaimer_.synchronize();
+      // 此后不会再有写入投递到旧布局(非Delegated模式的 get 不 pin，仍可能读它)。Delegated模式下向各属主线程投递一个空操作作为屏障，
+      // 等队列里已有的写入执行完；旧布局的属主线程继续为搬移服务，随旧布局一起释放
+      for (auto& owner : old->owners) {
+        owner->execute([](OwnedSlice&) {});
+      }
+      // 合并器随旧布局保留：get 的快速路径不 pin，可能仍经旧布局的合并器读取
+      sealed_.store(true, std::memory_order_release);
+    }
+
+    // 搬移至多 maxEntries 个结点，返回实际搬移数；供后台任务在重新分片后加快搬移，搬空时释放旧布局
+    size_t migrate(size_t maxEntries) {
+      size_t moved = 0;
+      Layout* drained = nullptr;
+      {
+        auto guard = reclaimer_.pin();
+        Layout* old = draining_.load(std::memory_order_acquire);
+        if (!old) {
+          return 0;
+        }
+        drained = migrateFrom(*layout_.load(std::memory_order_acquire), *old, maxEntries, moved, true) ? old : nullptr;
+      }
+      if (drained) {
+        finishReshard(drained);
+      }
+      return moved;
+    }
+
+    // 是否有尚未搬空的旧布局
+    bool resharding() const { return draining_.load(std::memory_order_acquire) != nullptr; }
+
+    int sliceCount() const {
+      auto guard = reclaimer_.pin();
+      return layout_.load(std::memory_order_acquire)->sliceNum;
+    }
+
+    // 开启热点key复制：须在并发使用前调用；Delegated模式下写入是异步的，无法保证副本与分片的先后，不支持
+    // 热点key的写入(包括tryPut)会同步更新副本；分片淘汰、缩容或删除key时副本随之删除
+    void enableHotKeys(const HotKeyOptions& options = HotKeyOptions()) {
+      if (mode_ == ShardMode::Delegated) {
+        return;
+      }
+      hotSet_ = allocateUnique<HotSet>(alloc_, options.hotCapacity, alloc_);
+      detector_ = allocateUnique<Detector>(alloc_, options.threshold, options.decayPeriod, alloc_);
+      sampleRate_ = options.sampleRate;
+      for (Layout* layout : {layout_.load(std::memory_order_relaxed), draining_.load(std::memory_order_relaxed)}) {
+        if (layout) {
+          forEachSlice(*layout, [this](auto& slice) { slice.setEraseHook(&HashLruCaches::dropHotReplica, hotSet_.get()); });
+        }
+      }
+    }
+
+    // 热点集合当前的副本数，仅用于观测
+    size_t hotKeyCount() const {
+      return hotSet_ ? hotSet_->size() : 0;
+    }
+
+    // 分片各自持锁设置(Delegated模式下由属主线程执行)，任何模式下都可调用；之后重新分片建出的分片沿用
+    void setPromotionPolicy(const PromotionPolicy& policy) {
+      std::lock_guard<std::mutex> lock(reshardMutex_);
+      promotionPolicy_ = policy;
+      forEachSlice(*layout_.load(std::memory_order_relaxed), [&policy](auto& slice) { slice.setPromotionPolicy(policy); });
+    }
+
+    // 在线调整总容量，任何模式下都可调用：Fixed按分片均分，Shared只改全局预算(单分片上限随之变为总容量)
+    // 缩容后超出的结点由后续操作分批淘汰，或由后台任务循环调用 trim
+    void setCapacity(size_t capacity) {
+      std::lock_guard<std::mutex> lock(reshardMutex_);
+      capacity_.store(capacity, std::memory_order_relaxed);
+      Layout* current = layout_.load(std::memory_order_relaxed);
+      size_t sliceSize = std::ceil(capacity / static_cast<double>(current->sliceNum));
+      if (current->budget) {
+        current->budget->setCapacity(capacity);
+        sliceSize = capacity;
+      }
+      forEachSlice(*current, [sliceSize](auto& slice) { slice.setCapacity(static_cast<int>(sliceSize)); });
+    }
+
+    size_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    // 条目总数：当前布局与重新分片中的旧布局各分片之和；各分片分别加锁统计，并发写入时只是近似
+    size_t size() {
+      auto guard = reclaimer_.pin();
+      size_t total = 0;
+      for (Layout* layout : {layout_.load(std::memory_order_acquire), draining_.load(std::memory_order_acquire)}) {
+        if (layout) {
+          forEachSlice(*layout, [&total](auto& slice) { total += slice.size(); });
+        }
+      }
+      return total;
+    }
+
+    // 各分片切到延迟维护(见 LruCache::deferMaintenance)，之后重新分片建出的分片沿用；
+    // Shared容量模式下跨分片的预算回收仍在写入时进行
+    void deferMaintenance(MaintenanceExecutor* executor, double highWatermark = kDefaultHighWatermark) {
+      std::lock_guard<std::mutex> lock(reshardMutex_);
+      maintenance_ = executor;
+      highWatermark_ = highWatermark;
+      for (Layout* layout : {layout_.load(std::memory_order_relaxed), draining_.load(std::memory_order_relaxed)}) {
+        if (layout) {
+          forEachSlice(*layout, [executor, highWatermark](auto& slice) { slice.deferMaintenance(executor, highWatermark); });
+        }
+      }
+    }
+
+    // 各分片的批量淘汰(见 LruCache::setLowWatermark)，之后重新分片建出的分片沿用
+    void setLowWatermark(double ratio) {
+      std::lock_guard<std::mutex> lock(reshardMutex_);
+      lowWatermark_ = ratio;
+      for (Layout* layout : {layout_.load(std::memory_order_relaxed), draining_.load(std::memory_order_relaxed)}) {
+        if (layout) {
+          forEachSlice(*layout, [ratio](auto& slice) { slice.setLowWatermark(ratio); });
+        }
+      }
+    }
+
+    // 各分片的淘汰回调(见 LruCache::setEvictionListener)：须在并发使用前设置；重新分片的搬移不回调
+    // Delegated模式下回调在属主线程上执行，回调里不得再同步访问本缓存
+    void setEvictionListener(typename Slice::EvictionListener listener) {
+      std::lock_guard<std::mutex> lock(reshardMutex_);
+      listener_ = std::move(listener);
+      for (Layout* layout : {layout_.load(std::memory_order_relaxed), draining_.load(std::memory_order_relaxed)}) {
+        if (layout) {
+          forEachSlice(*layout, [this](auto& slice) { slice.setEvictionListener(listener_); });
+        }
+      }
+    }
+
+    // 后台维护：先推进尚未完成的重新分片，剩余额度用于把各分片淘汰到容量以内
+    size_t maintain(size_t budget) {
+      size_t done = migrate(budget);
+      return done + (done < budget ? trim(budget - done) : 0);
+    }
+
+    // 淘汰至多 maxEvictions 个超出容量的结点，返回实际淘汰数
+    size_t trim(size_t maxEvictions) {
+      auto guard = reclaimer_.pin();
+      Layout& current = *layout_.load(std::memory_order_acquire);
+      size_t evicted = 0;
+      if (current.budget) {
+        while (evicted < maxEvictions && current.budget->excess() > 0 && current.budget->reclaim()) {
+          ++evicted;
+        }
+      }
+      for (size_t i = 0; i < static_cast<size_t>(current.sliceNum) && evicted < maxEvictions; ++i) {
+        onSlice(current, i, [&evicted, maxEvictions](auto& slice) { evicted += slice.trim(maxEvictions - evicted); });
+      }
+      return evicted;
+    }
+
+    // 当前布局各分片抢锁统计之和(重新分片后从新分片重新计数；Delegated模式的分片不抢锁，为0)
+    uint64_t contendedCount() const {
+      auto guard = reclaimer_.pin();
+      uint64_t total = 0;
+      for (const auto& slice : layout_.load(std::memory_order_acquire)->slices) {
+        total += slice->contentionStats().contended();
+      }
+      return total;
+    }
+
+    uint64_t tryAttemptCount() const {
+      auto guard = reclaimer_.pin();
+      uint64_t total = 0;
+      for (const auto& slice : layout_.load(std::memory_order_acquire)->slices) {
+        total += slice->contentionStats().attempts();
+      }
+      return total;
+    }
+
+    ShardMode mode() const { return mode_; }
   };
-  
+
+  // 绑定到 std::pmr::memory_resource 的版本，例如：
+  //   std::pmr::monotonic_buffer_resource arena;
+  //   MyCache::pmr::LruCache<int, std::string> cache(1024, &arena);
+  namespace pmr {
+    template<typename Key, typename Value>
+    using LruCache = MyCache::LruCache<Key, Value, PmrAlloc>;
+    template<typename Key, typename Value>
+    using LruKCache = MyCache::LruKCache<Key, Value, PmrAlloc>;
+    template<typename Key, typename Value>
+    using HashLruCaches = MyCache::HashLruCaches<Key, Value, PmrAlloc>;
+  }
 }
\ No newline at end of file
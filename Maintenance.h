@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace MyCache {
+  // 水位：低水位即缓存容量，后台维护把条目数淘汰到它为止；
+  // 高水位 = 容量 * highWatermark，后台跟不上、条目数涨到这里时前台才退回同步淘汰，保证内存有界
+  constexpr double kDefaultHighWatermark = 1.25;
+
+  // 延迟维护模式下按高水位算前台的硬上限，至少比容量多一个，避免每次插入都退回同步淘汰
+  inline size_t highWatermarkLimit(size_t capacity, double highWatermark) {
+    size_t limit = static_cast<size_t>(static_cast<double>(capacity) * highWatermark);
+    return std::max(limit, capacity + 1);
+  }
+
+  // 超出容量的部分积累到高水位余量的1/4才唤醒后台，避免写满后每次插入都唤醒一次；更少的超额由周期性维护处理
+  inline size_t wakeLimit(size_t capacity, double highWatermark) {
+    return capacity + std::max<size_t>((highWatermarkLimit(capacity, highWatermark) - capacity) / 4, 1);
+  }
+
+  // 后台维护执行器：一个线程轮流调用登记的维护任务(淘汰到低水位、老化、清理幽灵表)
+  // 缓存开启延迟维护后，前台put只插入，超出低水位时 notify() 唤醒后台；
+  // 每个任务每轮至多做 batch 单位的工作(一次持锁)，有任务做满一批就继续下一轮，否则睡到下个周期或被唤醒
+  // 执行器须比登记的缓存活得久；缓存析构前先 unwatch
+  // 用法：
+  //   MyCache::MaintenanceExecutor maintenance;
+  //   maintenance.watch(cache);
+  //   maintenance.start();
+  class MaintenanceExecutor {
+  public:
+    using Task = std::function<size_t(size_t budget)>;  // 返回实际完成的工作量，0表示无事可做
+    using Handle = uint64_t;
+
+  private:
+    static constexpr size_t kMaxRounds = 64;  // 一次 runOnce 最多的轮数，前台写入快过淘汰时也能及时响应 stop
+
+    struct Entry {
+      Handle handle;
+      Task task;
+      std::function<void()> detach;  // 取消登记时恢复同步维护，可为空
+    };
+
+    size_t batch_;
+    std::chrono::milliseconds interval_;
+    std::mutex tasksMutex_;  // 保护 entries_；任务在持有它时运行，unwatch 返回后任务不会再被调用
+    std::vector<Entry> entries_;
+    Handle nextHandle_ = 1;
+    std::atomic<bool> pending_{false};  // 有缓存越过低水位，等待后台处理
+    std::atomic<uint64_t> rounds_{0};
+    std::atomic<uint64_t> work_{0};
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = true;
+    std::thread worker_;
+
+    void run() {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!stop_) {
+        cv_.wait_for(lock, interval_, [this] { return stop_ || pending_.load(std::memory_order_relaxed); });
+        if (stop_) {
+          break;
+        }
+        lock.unlock();
+        runOnce();
+        lock.lock();
+      }
+    }
+
+  public:
+    explicit MaintenanceExecutor(size_t batch = 256, std::chrono::milliseconds interval = std::chrono::milliseconds(10))
+      : batch_(std::max<size_t>(batch, 1)), interval_(interval) {}
+
+    MaintenanceExecutor(const MaintenanceExecutor&) = delete;
+    MaintenanceExecutor& operator=(const MaintenanceExecutor&) = delete;
+
+    ~MaintenanceExecutor() { stop(); }
+
+    Handle add(Task task, std::function<void()> detach = nullptr) {
+      std::lock_guard<std::mutex> lock(tasksMutex_);
+      Handle handle = nextHandle_++;
+      entries_.push_back(Entry{handle, std::move(task), std::move(detach)});
+      return handle;
+    }
+
+    // 登记提供 deferMaintenance() / maintain() 的缓存，并把它切到延迟维护模式
+    template<typename Cache>
+    Handle watch(Cache& cache, double highWatermark = kDefaultHighWatermark) {
+      cache.deferMaintenance(this, highWatermark);
+      return add([&cache](size_t budget) { return cache.maintain(budget); },
+                 [&cache]() { cache.deferMaintenance(nullptr); });
+    }
+
+    // 取消登记；缓存恢复同步维护，积压的超额由之后的put/get分批淘汰
+    void unwatch(Handle handle) {
+      std::lock_guard<std::mutex> lock(tasksMutex_);
+      auto it = std::find_if(entries_.begin(), entries_.end(), [handle](const Entry& e) { return e.handle == handle; });
+      if (it != entries_.end()) {
+        if (it->detach) {
+          it->detach();
+        }
+        entries_.erase(it);
+      }
+    }
+
+    // 前台在超额积累到 wakeLimit 时调用：只在状态翻转时通知一次；未加锁通知可能丢失，最迟下个周期处理
+    void notify() {
+      if (!pending_.load(std::memory_order_relaxed) && !pending_.exchange(true, std::memory_order_acq_rel)) {
+        cv_.notify_one();
+      }
+    }
+
+    // 把所有任务做到没有积压为止(至多 kMaxRounds 轮，仍有积压时留待下次立即继续)，返回总工作量
+    // 后台线程与手动驱动(测试)共用
+    size_t runOnce() {
+      pending_.store(false, std::memory_order_relaxed);
+      std::lock_guard<std::mutex> lock(tasksMutex_);
+      size_t total = 0;
+      bool more = true;
+      for (size_t round = 0; more && round < kMaxRounds; ++round) {
+        more = false;
+        for (auto& entry : entries_) {
+          size_t done = entry.task(batch_);
+          total += done;
+          more = more || done >= batch_;
+        }
+        rounds_.fetch_add(1, std::memory_order_relaxed);
+      }
+      if (more) {
+        pending_.store(true, std::memory_order_relaxed);
+      }
+      work_.fetch_add(total, std::memory_order_relaxed);
+      return total;
+    }
+
+    void start() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!stop_) {
+        return;
+      }
+      stop_ = false;
+      worker_ = std::thread(&MaintenanceExecutor::run, this);
+    }
+
+    void stop() {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) {
+          return;
+        }
+        stop_ = true;
+      }
+      cv_.notify_one();
+      worker_.join();
+    }
+
+    uint64_t roundCount() const { return rounds_.load(std::memory_order_relaxed); }
+    uint64_t workCount() const { return work_.load(std::memory_order_relaxed); }
+  };
+} // namespace MyCache
@@ -0,0 +1,383 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace MyCache {
+  // 一次内存压力采样
+  struct PressureSample {
+    double someAvg10 = 0;     // PSI：近10秒内至少一个任务因内存停顿的时间占比(%)
+    double fullAvg10 = 0;     // PSI：近10秒内所有任务同时停顿的时间占比(%)
+    uint64_t usageBytes = 0;  // 当前内存用量
+    uint64_t limitBytes = 0;  // 内存上限，0 表示没有上限或读不到
+
+    double usageRatio() const {
+      return limitBytes > 0 ? static_cast<double>(usageBytes) / static_cast<double>(limitBytes) : 0;
+    }
+  };
+
+  // 压力来源：监视器只通过它取样，测试时换成 FakePressureSource
+  class PressureSource {
+  public:
+    virtual ~PressureSource() = default;
+
+    // 读不到数据时返回false，监视器本轮不做调整
+    virtual bool sample(PressureSample& out) = 0;
+  };
+
+  // 读 cgroup v2 的 memory.pressure / memory.current / memory.max
+  // 没有PSI的内核只按用量比例判断；cgroup v1 退回 memory.usage_in_bytes / memory.limit_in_bytes
+  class CgroupPressureSource : public PressureSource {
+  private:
+    std::string dir_;
+
+    static bool readFile(const std::string& path, std::string& out) {
+      FILE* file = std::fopen(path.c_str(), "r");
+      if (!file) {
+        return false;
+      }
+      char buffer[512];
+      out.clear();
+      size_t n;
+      while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        out.append(buffer, n);
+      }
+      std::fclose(file);
+      return true;
+    }
+
+    // "max" 或读不到都返回false
+    static bool readNumber(const std::string& path, uint64_t& out) {
+      std::string text;
+      if (!readFile(path, text) || text.compare(0, 3, "max") == 0) {
+        return false;
+      }
+      char* end = nullptr;
+      unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+      if (end == text.c_str()) {
+        return false;
+      }
+      out = value;
+      return true;
+    }
+
+    // 格式："some avg10=0.12 avg60=0.05 avg300=0.01 total=12345"，下一行以 full 开头
+    static bool parseAvg10(const std::string& text, const char* kind, double& out) {
+      size_t line = text.find(kind);
+      if (line == std::string::npos) {
+        return false;
+      }
+      size_t field = text.find("avg10=", line);
+      if (field == std::string::npos) {
+        return false;
+      }
+      out = std::strtod(text.c_str() + field + 6, nullptr);
+      return true;
+    }
+
+  public:
+    explicit CgroupPressureSource(std::string dir = "/sys/fs/cgroup") : dir_(std::move(dir)) {}
+
+    // 当前进程所在的 cgroup 目录：优先 v2("0::/path" 一行)，没有 memory.current 时退回 v1 的 memory 控制器
+    static CgroupPressureSource forSelf(const std::string& mountPoint = "/sys/fs/cgroup") {
+      std::string text;
+      if (!readFile("/proc/self/cgroup", text)) {
+        return CgroupPressureSource(mountPoint);
+      }
+      text.insert(text.begin(), '\n');  // 每行都以换行开头，便于按行首匹配
+      auto pathAfter = [&text](const char* prefix, std::string& path) {
+        size_t pos = text.find(prefix);
+        if (pos == std::string::npos) {
+          return false;
+        }
+        pos += std::strlen(prefix);
+        size_t end = text.find('\n', pos);
+        path = text.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        if (path == "/") {
+          path.clear();
+        }
+        return true;
+      };
+      std::string path;
+      uint64_t unused;
+      if (pathAfter("\n0::", path) && readNumber(mountPoint + path + "/memory.current", unused)) {
+        return CgroupPressureSource(mountPoint + path);
+      }
+      if (pathAfter(":memory:", path)) {
+        return CgroupPressureSource(mountPoint + "/memory" + path);
+      }
+      return CgroupPressureSource(mountPoint);
+    }
+
+    bool sample(PressureSample& out) override {
+      PressureSample s;
+      std::string psi;
+      bool havePsi = readFile(dir_ + "/memory.pressure", psi) && parseAvg10(psi, "some", s.someAvg10);
+      if (havePsi) {
+        parseAvg10(psi, "full", s.fullAvg10);
+      }
+      bool haveUsage = readNumber(dir_ + "/memory.current", s.usageBytes) ||
+                       readNumber(dir_ + "/memory.usage_in_bytes", s.usageBytes);
+      if (haveUsage && !readNumber(dir_ + "/memory.max", s.limitBytes) &&
+          !readNumber(dir_ + "/memory.limit_in_bytes", s.limitBytes)) {
+        s.limitBytes = 0;
+      }
+      if (s.limitBytes >= (uint64_t(1) << 62)) {
+        s.limitBytes = 0;  // v1 没有上限时是一个接近 INT64_MAX 的页对齐值
+      }
+      if (!havePsi && !haveUsage) {
+        return false;
+      }
+      out = s;
+      return true;
+    }
+
+    const std::string& directory() const { return dir_; }
+  };
+
+  // 手动设置的压力来源：测试与回放时替代 CgroupPressureSource
+  class FakePressureSource : public PressureSource {
+  private:
+    std::mutex mutex_;
+    PressureSample sample_;
+    bool available_ = true;
+
+  public:
+    void set(const PressureSample& sample) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      sample_ = sample;
+      available_ = true;
+    }
+
+    void setPressure(double someAvg10, double fullAvg10 = 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      sample_.someAvg10 = someAvg10;
+      sample_.fullAvg10 = fullAvg10;
+      available_ = true;
+    }
+
+    void setUsage(uint64_t usageBytes, uint64_t limitBytes) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      sample_.usageBytes = usageBytes;
+      sample_.limitBytes = limitBytes;
+      available_ = true;
+    }
+
+    // 模拟读不到数据(文件不存在、内核不支持PSI)
+    void setUnavailable() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      available_ = false;
+    }
+
+    bool sample(PressureSample& out) override {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!available_) {
+        return false;
+      }
+      out = sample_;
+      return true;
+    }
+  };
+
+  struct PressureOptions {
+    double someShrinkAbove = 10.0;  // some avg10 超过此值(%)即收缩
+    double fullShrinkAbove = 1.0;   // full avg10 超过此值(%)即收缩
+    double usageShrinkAbove = 0.90; // 用量/上限 超过此比例即收缩
+    double someGrowBelow = 1.0;     // 压力与用量都低于这两条线才算平静，中间区间保持不动
+    double usageGrowBelow = 0.75;
+    double shrinkFactor = 0.75;     // 每轮收缩后的预算 = 当前预算 * shrinkFactor
+    double growStep = 0.10;         // 每轮恢复基准预算的这一比例
+    double minScale = 0.10;         // 预算最低压到基准的这一比例
+    unsigned calmPolls = 3;         // 连续平静这么多轮才开始恢复，避免在阈值附近来回抖动
+    size_t trimPerPoll = 1024;      // 每轮每个缓存最多淘汰的条目数，剩余超额由缓存自身的读写或下一轮继续清
+  };
+
+  // 内存压力监视器：按采样结果逐级收缩已登记缓存的预算，压力解除后逐级恢复
+  // 预算以登记时的基准值乘以统一的比例 scale 计算；登记期间缓存的容量由监视器决定
+  // 可以由后台线程定期 poll()，也可以由调用方(或测试)手动 poll()
+  // 用法：
+  //   auto source = MyCache::CgroupPressureSource::forSelf();
+  //   MyCache::MemoryPressureMonitor monitor(source);
+  //   monitor.watch(cache);
+  //   monitor.start(std::chrono::seconds(1));
+  class MemoryPressureMonitor {
+  public:
+    using Handle = uint64_t;
+
+  private:
+    struct Entry {
+      Handle handle;
+      size_t base;                                 // 登记时的预算(条目数或字节数)
+      std::function<void(size_t)> setBudget;
+      std::function<size_t(size_t)> trim;          // 可为空
+    };
+
+    PressureSource& source_;
+    PressureOptions options_;
+    std::mutex mutex_;              // 保护 entries_ 与调整状态；poll 之间互斥
+    std::vector<Entry> entries_;
+    Handle nextHandle_ = 1;
+    double scale_ = 1.0;
+    unsigned calm_ = 0;
+    PressureSample last_;
+    std::atomic<uint64_t> shrinks_{0};
+    std::atomic<uint64_t> grows_{0};
+
+    std::mutex threadMutex_;
+    std::condition_variable cv_;
+    bool stop_ = true;
+    std::thread worker_;
+
+    static size_t scaled(size_t base, double scale) {
+      return static_cast<size_t>(static_cast<double>(base) * scale + 0.5);
+    }
+
+    void applyLocked() {
+      for (auto& entry : entries_) {
+        entry.setBudget(scaled(entry.base, scale_));
+      }
+    }
+
+    void trimLocked() {
+      if (scale_ >= 1.0 || options_.trimPerPoll == 0) {
+        return;
+      }
+      for (auto& entry : entries_) {
+        if (entry.trim) {
+          entry.trim(options_.trimPerPoll);
+        }
+      }
+    }
+
+    void run(std::chrono::milliseconds interval) {
+      std::unique_lock<std::mutex> lock(threadMutex_);
+      while (!cv_.wait_for(lock, interval, [this] { return stop_; })) {
+        lock.unlock();
+        poll();
+        lock.lock();
+      }
+    }
+
+  public:
+    explicit MemoryPressureMonitor(PressureSource& source, const PressureOptions& options = PressureOptions())
+      : source_(source), options_(options) {}
+
+    MemoryPressureMonitor(const MemoryPressureMonitor&) = delete;
+    MemoryPressureMonitor& operator=(const MemoryPressureMonitor&) = delete;
+
+    // 析构前停止后台线程；登记的缓存保持最后一次设置的预算
+    ~MemoryPressureMonitor() { stop(); }
+
+    // 登记任意预算：setBudget 接收新的预算值，trim 每轮淘汰至多给定个数的超额条目(可为空)
+    Handle watch(size_t baseBudget, std::function<void(size_t)> setBudget,
+                 std::function<size_t(size_t)> trim = nullptr) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      Handle handle = nextHandle_++;
+      entries_.push_back(Entry{handle, baseBudget, std::move(setBudget), std::move(trim)});
+      if (scale_ < 1.0) {
+        entries_.back().setBudget(scaled(baseBudget, scale_));  // 压力期间登记的缓存立刻按当前比例收缩
+      }
+      return handle;
+    }
+
+    // 登记提供 capacity() / setCapacity() / trim() 的缓存，以当前容量为基准
+    template<typename Cache>
+    Handle watch(Cache& cache) {
+      using Capacity = decltype(cache.capacity());
+      return watch(static_cast<size_t>(cache.capacity()),
+                   [&cache](size_t budget) { cache.setCapacity(static_cast<Capacity>(budget)); },
+                   [&cache](size_t maxEvictions) { return cache.trim(maxEvictions); });
+    }
+
+    // 取消登记并恢复基准预算；缓存析构前必须取消登记
+    void unwatch(Handle handle) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = std::find_if(entries_.begin(), entries_.end(), [handle](const Entry& e) { return e.handle == handle; });
+      if (it != entries_.end()) {
+        it->setBudget(it->base);
+        entries_.erase(it);
+      }
+    }
+
+    // 采样一次并调整预算，返回调整后的比例
+    double poll() {
+      PressureSample sample;
+      bool ok = source_.sample(sample);
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!ok) {
+        trimLocked();
+        return scale_;
+      }
+      last_ = sample;
+      double usage = sample.usageRatio();
+      bool pressured = sample.someAvg10 > options_.someShrinkAbove || sample.fullAvg10 > options_.fullShrinkAbove ||
+                       usage > options_.usageShrinkAbove;
+      bool calm = sample.someAvg10 < options_.someGrowBelow && usage < options_.usageGrowBelow;
+      if (pressured) {
+        calm_ = 0;
+        double next = std::max(options_.minScale, scale_ * options_.shrinkFactor);
+        if (next < scale_) {
+          scale_ = next;
+          shrinks_.fetch_add(1, std::memory_order_relaxed);
+          applyLocked();
+        }
+      } else if (calm) {
+        if (scale_ < 1.0 && ++calm_ >= options_.calmPolls) {
+          scale_ = std::min(1.0, scale_ + options_.growStep);
+          grows_.fetch_add(1, std::memory_order_relaxed);
+          applyLocked();
+        }
+      } else {
+        calm_ = 0;
+      }
+      trimLocked();
+      return scale_;
+    }
+
+    void start(std::chrono::milliseconds interval = std::chrono::milliseconds(1000)) {
+      std::lock_guard<std::mutex> lock(threadMutex_);
+      if (!stop_) {
+        return;
+      }
+      stop_ = false;
+      worker_ = std::thread(&MemoryPressureMonitor::run, this, interval);
+    }
+
+    void stop() {
+      {
+        std::lock_guard<std::mutex> lock(threadMutex_);
+        if (stop_) {
+          return;
+        }
+        stop_ = true;
+      }
+      cv_.notify_one();
+      worker_.join();
+    }
+
+    double scale() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return scale_;
+    }
+
+    PressureSample lastSample() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return last_;
+    }
+
+    uint64_t shrinkCount() const { return shrinks_.load(std::memory_order_relaxed); }
+    uint64_t growCount() const { return grows_.load(std::memory_order_relaxed); }
+  };
+} // namespace MyCache
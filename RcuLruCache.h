@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "CacheAllocator.h"
+#include "CachePolicy.h"
+#include "EpochReclaimer.h"
+
+namespace MyCache {
+  // 读多写少场景的LRU：读者在epoch临界区内无锁遍历索引，只公布一次epoch，从不等待写者
+  // 写者之间用互斥锁串行，新结点整体构造好再发布，被替换/淘汰的结点经宽限期后释放
+  // 读者不移动链表，只置结点的访问位；写者淘汰时给置位的结点第二次机会(移回最近端)，近似LRU
+  // 结点只在写者锁内分配和释放，Alloc无需线程安全
+  template<typename Key, typename Value, typename Alloc = DefaultAlloc>
+  class RcuLruCache : public CachePolicy<Key, Value> {
+  public:
+    using allocator_type = Alloc;
+
+  private:
+    struct Node {
+      size_t hash;
+      Key key;
+      Value value;                     // 发布后不再修改，更新时整结点替换
+      std::atomic<Node*> chain;        // 同桶下一个结点，读者遍历
+      std::atomic<uint8_t> referenced; // 读者置位的访问标记
+      Node* prev;                      // LRU链表，仅写者在锁内访问
+      Node* next;
+
+      Node(size_t h, const Key& k, const Value& v)
+        : hash(h), key(k), value(v), chain(nullptr), referenced(0), prev(nullptr), next(nullptr) {}
+    };
+
+    using BucketHead = std::atomic<Node*>;
+
+    static constexpr size_t kTrimPerOp = 4;  // 缩容后每次put顺带淘汰的上限(读者不加锁，不参与淘汰)
+
+    std::atomic<int> capacity_;  // 可在线调整；桶数按构造时的容量定，扩容后只是链变长
+    size_t size_;
+    Alloc alloc_;
+    std::mutex mutex_;  // 只串行化写者
+    std::vector<BucketHead, RebindAlloc<Alloc, BucketHead>> buckets_;
+    size_t mask_;
+    // LRU链表：头部最久未访问，尾部最近写入/提升
+    Node* lruHead_;
+    Node* lruTail_;
+    // 放在最后：析构时先于 alloc_ 释放剩余的待回收结点
+    // 读者首次pin时在写锁之外登记记录，而 Alloc 无需线程安全，故回收器的记录与待回收列表固定走全局堆
+    EpochReclaimer<> reclaimer_;
+
+    static size_t bucketCount(int capacity) {
+      size_t count = 16;
+      while (count < static_cast<size_t>(capacity > 0 ? capacity : 0)) {
+        count <<= 1;
+      }
+      return count;
+    }
+
+    static size_t hashOf(const Key& key) {
+      return std::hash<Key>()(key);
+    }
+
+    BucketHead& bucketFor(size_t hash) {
+      uint64_t mixed = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+      return buckets_[(mixed >> 32) & mask_];
+    }
+
+    static void destroyNode(void* context, void* object) {
+      destroyObject(static_cast<RcuLruCache*>(context)->alloc_, static_cast<Node*>(object));
+    }
+
+    // 写者查找：返回指向该结点的链接(桶头或前驱的chain)，不存在时返回nullptr
+    BucketHead* findLink(size_t hash, const Key& key) {
+      BucketHead* link = &bucketFor(hash);
+      for (Node* node = link->load(std::memory_order_relaxed); node; node = node->chain.load(std::memory_order_relaxed)) {
+        if (node->hash == hash && node->key == key) {
+          return link;
+        }
+        link = &node->chain;
+      }
+      return nullptr;
+    }
+
+    void unlinkLru(Node* node) {
+      (node->prev ? node->prev->next : lruHead_) = node->next;
+      (node->next ? node->next->prev : lruTail_) = node->prev;
+      node->prev = node->next = nullptr;
+    }
+
+    void appendLru(Node* node) {
+      node->prev = lruTail_;
+      node->next = nullptr;
+      (lruTail_ ? lruTail_->next : lruHead_) = node;
+      lruTail_ = node;
+    }
+
+    // 从索引摘下并进入宽限期
+    void unpublish(BucketHead* link, Node* node) {
+      link->store(node->chain.load(std::memory_order_relaxed), std::memory_order_release);
+      unlinkLru(node);
+      reclaimer_.retire(node, &RcuLruCache::destroyNode, this);
+      --size_;
+    }
+
+    // 第二次机会：队头结点被读过则清位移回尾部，最多转一圈
+    size_t trimLocked(size_t maxEvictions) {
+      size_t limit = static_cast<size_t>(std::max(capacity_.load(std::memory_order_relaxed), 0));
+      size_t evicted = 0;
+      while (evicted < maxEvictions && size_ > limit) {
+        evictLeastRecent();
+        ++evicted;
+      }
+      return evicted;
+    }
+
+    void evictLeastRecent() {
+      for (size_t scanned = 0; scanned < size_ && lruHead_->referenced.load(std::memory_order_relaxed); ++scanned) {
+        Node* node = lruHead_;
+        node->referenced.store(0, std::memory_order_relaxed);
+        unlinkLru(node);
+        appendLru(node);
+      }
+      Node* victim = lruHead_;
+      unpublish(findLink(victim->hash, victim->key), victim);
+    }
+
+  public:
+    explicit RcuLruCache(int capacity, const Alloc& alloc = Alloc())
+      : capacity_(capacity), size_(0), alloc_(alloc)
+      , buckets_(bucketCount(capacity), RebindAlloc<Alloc, BucketHead>(alloc))
+      , mask_(buckets_.size() - 1), lruHead_(nullptr), lruTail_(nullptr) {}
+
+    RcuLruCache(const RcuLruCache&) = delete;
+    RcuLruCache& operator=(const RcuLruCache&) = delete;
+
+    // 析构时不得有并发访问
+    ~RcuLruCache() override {
+      Node* node = lruHead_;
+      while (node) {
+        Node* next = node->next;
+        destroyObject(alloc_, node);
+        node = next;
+      }
+    }
+
+    allocator_type get_allocator() const { return alloc_; }
+
+    void put(Key key, Value value) override {
+      if (capacity_.load(std::memory_order_relaxed) <= 0) {
+        return;
+      }
+      size_t hash = hashOf(key);
+      std::lock_guard<std::mutex> lock(mutex_);
+      trimLocked(kTrimPerOp);
+      Node* fresh = allocateObject<Node>(alloc_, hash, key, value);
+      BucketHead* link = findLink(hash, key);
+      if (link) {
+        // 替换：新结点接管旧结点的后继后再发布，读者看到的要么是旧值要么是新值
+        Node* old = link->load(std::memory_order_relaxed);
+        fresh->chain.store(old->chain.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        link->store(fresh, std::memory_order_release);
+        unlinkLru(old);
+        appendLru(fresh);
+        reclaimer_.retire(old, &RcuLruCache::destroyNode, this);
+        return;
+      }
+      if (size_ > 0 && size_ >= static_cast<size_t>(capacity_.load(std::memory_order_relaxed))) {
+        evictLeastRecent();
+      }
+      BucketHead& head = bucketFor(hash);
+      fresh->chain.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      head.store(fresh, std::memory_order_release);
+      appendLru(fresh);
+      ++size_;
+    }
+
+    bool get(Key key, Value& value) override {
+      PinnedPtr<const Value> pinned = find(key);
+      if (pinned) {
+        value = *pinned;
+        return true;
+      }
+      return false;
+    }
+
+    Value get(Key key) override {
+      Value value{};
+      get(key, value);
+      return value;
+    }
+
+    // 零拷贝读取：返回的指针在PinnedPtr存活期间有效，不拷贝value也不做引用计数
+    PinnedPtr<const Value> find(const Key& key) {
+      size_t hash = hashOf(key);
+      auto guard = reclaimer_.pin();
+      for (Node* node = bucketFor(hash).load(std::memory_order_acquire); node;
+           node = node->chain.load(std::memory_order_acquire)) {
+        if (node->hash == hash && node->key == key) {
+          // 已置位时不再写，热点key的读不会反复弄脏cache line
+          if (!node->referenced.load(std::memory_order_relaxed)) {
+            node->referenced.store(1, std::memory_order_relaxed);
+          }
+          return PinnedPtr<const Value>(std::move(guard), &node->value);
+        }
+      }
+      return PinnedPtr<const Value>();
+    }
+
+    // 在线调整容量：扩容立即生效；缩容超出的结点由后续put或 trim 分批淘汰，读者不受影响
+    void setCapacity(int capacity) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      capacity_.store(capacity, std::memory_order_relaxed);
+    }
+
+    int capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    // 淘汰至多 maxEvictions 个超出容量的结点，返回实际淘汰数
+    size_t trim(size_t maxEvictions) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return trimLocked(maxEvictions);
+    }
+
+    void remove(Key key) {
+      size_t hash = hashOf(key);
+      std::lock_guard<std::mutex> lock(mutex_);
+      BucketHead* link = findLink(hash, key);
+      if (link) {
+        unpublish(link, link->load(std::memory_order_relaxed));
+      }
+    }
+  };
+
+  namespace pmr {
+    template<typename Key, typename Value>
+    using RcuLruCache = MyCache::RcuLruCache<Key, Value, PmrAlloc>;
+  }
+} // namespace MyCache
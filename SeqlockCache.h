@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "CacheAllocator.h"
+#include "CachePolicy.h"
+
+namespace MyCache {
+  // 小型POD缓存：每个槽位由序列号保护，读者乐观拷贝key/value，序列号变化则重试
+  // 读路径不加锁、不写槽位所在的cache line，多核并发读同一热点时不会互相作废缓存行
+  // 唯一的读侧写入是CLOCK访问位：放在独立数组中，且只在未置位时写一次
+  // 写者按桶持有自旋锁，写前后各推进一次序列号(奇数表示正在写)
+  // 组相联：每桶4路，key只落在自己的桶里，桶满时按CLOCK选择淘汰路
+  // 容量可在线调低(setCapacity)：按每桶可用的路数限制，不能超过构造时的表大小
+  template<typename Key, typename Value, typename Alloc = DefaultAlloc>
+  class SeqlockCache : public CachePolicy<Key, Value> {
+    static_assert(std::is_trivially_copyable<Key>::value, "SeqlockCache requires a trivially copyable key");
+    static_assert(std::is_trivially_copyable<Value>::value, "SeqlockCache requires a trivially copyable value");
+
+  public:
+    using allocator_type = Alloc;
+    static constexpr size_t kWays = 4;
+
+  private:
+    // key与value按8字节分词存放，读写都是relaxed原子操作，乐观读不构成数据竞争
+    static constexpr size_t kWords = (sizeof(Key) + sizeof(Value) + 7) / 8;
+
+    struct Slot {
+      std::atomic<uint32_t> seq;
+      std::atomic<uint32_t> occupied;
+      std::atomic<uint64_t> words[kWords];
+    };
+
+    struct alignas(64) Bucket {
+      std::atomic<uint32_t> writeLock;  // 只有写者访问
+      uint32_t hand;                    // CLOCK指针，持锁访问
+      Slot slots[kWays];
+
+      Bucket() : writeLock(0), hand(0) {
+        for (Slot& slot : slots) {
+          slot.seq.store(0, std::memory_order_relaxed);
+          slot.occupied.store(0, std::memory_order_relaxed);
+          for (auto& word : slot.words) {
+            word.store(0, std::memory_order_relaxed);
+          }
+        }
+      }
+    };
+
+    using RefBit = std::atomic<uint8_t>;
+
+    Alloc alloc_;
+    std::vector<Bucket, RebindAlloc<Alloc, Bucket>> buckets_;
+    std::vector<RefBit, RebindAlloc<Alloc, RefBit>> referenced_;  // 与槽位数据分开，读侧置位不弄脏数据行
+    size_t mask_;
+    std::atomic<size_t> waysLimit_;   // 每桶可写入的路数(前若干路)，setCapacity 调整
+    std::atomic<size_t> trimCursor_;  // trim 下一次从这个桶开始扫描
+
+    static size_t bucketCount(size_t capacity) {
+      size_t needed = (capacity + kWays - 1) / kWays;
+      size_t count = 1;
+      while (count < needed) {
+        count <<= 1;
+      }
+      return count;
+    }
+
+    size_t bucketIndex(const Key& key) const {
+      uint64_t mixed = static_cast<uint64_t>(std::hash<Key>()(key)) * 0x9E3779B97F4A7C15ULL;
+      return (mixed >> 32) & mask_;
+    }
+
+    RefBit& refBit(size_t bucket, size_t way) {
+      return referenced_[bucket * kWays + way];
+    }
+
+    static void pack(const Key& key, const Value& value, uint64_t (&buffer)[kWords]) {
+      std::memset(buffer, 0, sizeof(buffer));
+      std::memcpy(buffer, &key, sizeof(Key));
+      std::memcpy(reinterpret_cast<char*>(buffer) + sizeof(Key), &value, sizeof(Value));
+    }
+
+    // 乐观读取一个槽位；返回false表示空槽
+    static bool readSlot(const Slot& slot, Key& key, Value& value) {
+      uint64_t buffer[kWords];
+      uint32_t before;
+      uint32_t occupied;
+      for (;;) {
+        before = slot.seq.load(std::memory_order_acquire);
+        if (before & 1) {
+          std::this_thread::yield();  // 写者正在修改
+          continue;
+        }
+        occupied = slot.occupied.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < kWords; ++i) {
+          buffer[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == before) {
+          break;
+        }
+      }
+      if (!occupied) {
+        return false;
+      }
+      std::memcpy(&key, buffer, sizeof(Key));
+      std::memcpy(&value, reinterpret_cast<const char*>(buffer) + sizeof(Key), sizeof(Value));
+      return true;
+    }
+
+    // 持桶锁调用
+    static void writeSlot(Slot& slot, const Key& key, const Value& value) {
+      uint64_t buffer[kWords];
+      pack(key, value, buffer);
+      uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+      slot.seq.store(seq + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      for (size_t i = 0; i < kWords; ++i) {
+        slot.words[i].store(buffer[i], std::memory_order_relaxed);
+      }
+      slot.occupied.store(1, std::memory_order_relaxed);
+      slot.seq.store(seq + 2, std::memory_order_release);
+    }
+
+    static void clearSlot(Slot& slot) {
+      uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+      slot.seq.store(seq + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      slot.occupied.store(0, std::memory_order_relaxed);
+      slot.seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // 持锁时槽位不会被其他写者修改，可直接读取
+    static bool slotHolds(const Slot& slot, const Key& key) {
+      if (!slot.occupied.load(std::memory_order_relaxed)) {
+        return false;
+      }
+      uint64_t buffer[kWords];
+      for (size_t i = 0; i < kWords; ++i) {
+        buffer[i] = slot.words[i].load(std::memory_order_relaxed);
+      }
+      Key stored;
+      std::memcpy(&stored, buffer, sizeof(Key));
+      return stored == key;
+    }
+
+    static void lockBucket(Bucket& bucket) {
+      while (bucket.writeLock.exchange(1, std::memory_order_acquire)) {
+        while (bucket.writeLock.load(std::memory_order_relaxed)) {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    static void unlockBucket(Bucket& bucket) {
+      bucket.writeLock.store(0, std::memory_order_release);
+    }
+
+    // 缩容后清掉桶内限制路数之外的槽，返回清掉的个数；持桶锁调用
+    static size_t clearOverflow(Bucket& bucket, size_t ways, size_t maxEvictions) {
+      size_t evicted = 0;
+      for (size_t way = ways; way < kWays && evicted < maxEvictions; ++way) {
+        if (bucket.slots[way].occupied.load(std::memory_order_relaxed)) {
+          clearSlot(bucket.slots[way]);
+          ++evicted;
+        }
+      }
+      return evicted;
+    }
+
+    // 桶内CLOCK(只在前 ways 路中选)：空槽优先，否则从hand开始清掉沿途访问位，选第一个未被访问的槽
+    size_t chooseVictim(size_t index, Bucket& bucket, size_t ways) {
+      for (size_t way = 0; way < ways; ++way) {
+        if (!bucket.slots[way].occupied.load(std::memory_order_relaxed)) {
+          return way;
+        }
+      }
+      for (;;) {
+        size_t way = bucket.hand % ways;
+        bucket.hand = static_cast<uint32_t>((way + 1) % ways);
+        RefBit& bit = refBit(index, way);
+        if (!bit.load(std::memory_order_relaxed)) {
+          return way;
+        }
+        bit.store(0, std::memory_order_relaxed);
+      }
+    }
+
+  public:
+    explicit SeqlockCache(size_t capacity, const Alloc& alloc = Alloc())
+      : alloc_(alloc), buckets_(bucketCount(capacity), RebindAlloc<Alloc, Bucket>(alloc))
+      , referenced_(buckets_.size() * kWays, RebindAlloc<Alloc, RefBit>(alloc))
+      , mask_(buckets_.size() - 1), waysLimit_(kWays), trimCursor_(0) {}
+
+    allocator_type get_allocator() const { return alloc_; }
+
+    void put(Key key, Value value) override {
+      size_t index = bucketIndex(key);
+      Bucket& bucket = buckets_[index];
+      lockBucket(bucket);
+      size_t ways = waysLimit_.load(std::memory_order_relaxed);
+      if (ways == 0) {
+        unlockBucket(bucket);
+        return;
+      }
+      clearOverflow(bucket, ways, kWays);  // 缩容后顺带清理所在桶，同key的旧值也在其中，之后按新key写入
+      size_t target = kWays;
+      for (size_t way = 0; way < ways; ++way) {
+        if (slotHolds(bucket.slots[way], key)) {
+          target = way;
+          break;
+        }
+      }
+      if (target == kWays) {
+        target = chooseVictim(index, bucket, ways);
+        refBit(index, target).store(0, std::memory_order_relaxed);
+      }
+      writeSlot(bucket.slots[target], key, value);
+      unlockBucket(bucket);
+    }
+
+    bool get(Key key, Value& value) override {
+      size_t index = bucketIndex(key);
+      const Bucket& bucket = buckets_[index];
+      for (size_t way = 0; way < kWays; ++way) {
+        Key stored;
+        Value candidate;
+        if (readSlot(bucket.slots[way], stored, candidate) && stored == key) {
+          RefBit& bit = refBit(index, way);
+          if (!bit.load(std::memory_order_relaxed)) {
+            bit.store(1, std::memory_order_relaxed);
+          }
+          value = candidate;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    Value get(Key key) override {
+      Value value{};
+      get(key, value);
+      return value;
+    }
+
+    bool remove(Key key) {
+      size_t index = bucketIndex(key);
+      Bucket& bucket = buckets_[index];
+      lockBucket(bucket);
+      bool removed = false;
+      for (size_t way = 0; way < kWays; ++way) {
+        if (slotHolds(bucket.slots[way], key)) {
+          clearSlot(bucket.slots[way]);
+          removed = true;
+          break;
+        }
+      }
+      unlockBucket(bucket);
+      return removed;
+    }
+
+    // 扫描全表统计，仅用于观测
+    size_t size() const {
+      size_t count = 0;
+      for (const Bucket& bucket : buckets_) {
+        for (const Slot& slot : bucket.slots) {
+          count += slot.occupied.load(std::memory_order_relaxed) != 0;
+        }
+      }
+      return count;
+    }
+
+    size_t capacity() const { return buckets_.size() * waysLimit_.load(std::memory_order_relaxed); }
+
+    // 表的总路数，容量的上限
+    size_t slotCount() const { return buckets_.size() * kWays; }
+
+    // 在线调整容量：按每桶可用路数生效(向上取整到桶数的整数倍)，桶数在构造时确定，
+    // 容量不能增长到 slotCount() 之外，超出的请求被截断，返回实际生效的容量
+    // 缩容后只写入每桶的前若干路，超出的槽由后续put(清理所在桶)或 trim 分批淘汰
+    size_t setCapacity(size_t capacity) {
+      size_t ways = std::min(capacity / buckets_.size() + (capacity % buckets_.size() != 0), kWays);
+      waysLimit_.store(ways, std::memory_order_relaxed);
+      return buckets_.size() * ways;
+    }
+
+    // 淘汰至多 maxEvictions 个落在限制路数之外的槽，返回实际淘汰数；每次调用至多扫描一遍全表
+    size_t trim(size_t maxEvictions) {
+      size_t ways = waysLimit_.load(std::memory_order_relaxed);
+      if (ways == kWays) {
+        return 0;
+      }
+      size_t evicted = 0;
+      size_t start = trimCursor_.load(std::memory_order_relaxed);
+      for (size_t step = 0; step < buckets_.size() && evicted < maxEvictions; ++step) {
+        size_t index = (start + step) & mask_;
+        Bucket& bucket = buckets_[index];
+        lockBucket(bucket);
+        evicted += clearOverflow(bucket, ways, maxEvictions - evicted);
+        unlockBucket(bucket);
+        trimCursor_.store(index, std::memory_order_relaxed);
+      }
+      return evicted;
+    }
+  };
+
+  namespace pmr {
+    template<typename Key, typename Value>
+    using SeqlockCache = MyCache::SeqlockCache<Key, Value, PmrAlloc>;
+  }
+} // namespace MyCache
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CacheAllocator.h"
+
+namespace MyCache {
+  // 分片容量的分配方式
+  enum class ShardCapacity {
+    Fixed,   // 每个分片固定 ceil(capacity / sliceNum)
+    Shared,  // 所有分片共用一个全局预算，单个分片最多可用满总容量
+  };
+
+  // 全局容量预算：分片插入新结点前先申请一个单位，删除/淘汰时归还
+  // 预算用尽时采样几个分片，按各自给出的淘汰分数(越大越该淘汰，例如LRU尾部的年龄)选一个分片淘汰一个结点；
+  // 采样到的分片都为空(结点集中在少数分片)时依次扫描全部分片，只要还有结点就能回收到一个单位
+  // 年龄以"全局插入次数"计：每成功申请一次推进一代，分片在结点被访问时记下当前代数
+  // Shard 需提供：
+  //   bool evictionScore(uint64_t& score)  分片为空时返回false
+  //   bool evictForBudget()                淘汰一个结点(并归还预算)，分片为空时返回false
+  // 两者各自加分片锁；调用 reclaim 时调用方不得持有任何分片锁
+  template<typename Shard, typename Alloc = DefaultAlloc>
+  class ShardBudget {
+  private:
+    static constexpr size_t kSamples = 3;
+
+    std::atomic<size_t> capacity_;  // 可在线调整；缩小后 used_ 暂时超出，由分片写入时的回收逐步归还
+    std::atomic<size_t> used_;
+    std::atomic<uint32_t> generation_;
+    std::vector<Shard*, RebindAlloc<Alloc, Shard*>> shards_;
+
+    static uint32_t nextRandom() {
+      thread_local uint32_t state = (0x9E3779B9u ^ static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&state))) | 1;
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return state;
+    }
+
+  public:
+    explicit ShardBudget(size_t capacity, const Alloc& alloc = Alloc())
+      : capacity_(capacity), used_(0), generation_(0), shards_(RebindAlloc<Alloc, Shard*>(alloc)) {}
+
+    ShardBudget(const ShardBudget&) = delete;
+    ShardBudget& operator=(const ShardBudget&) = delete;
+
+    // 构造期间登记分片，之后不再变化
+    void addShard(Shard* shard) { shards_.push_back(shard); }
+
+    bool tryAcquire() {
+      size_t used = used_.load(std::memory_order_relaxed);
+      while (used < capacity_.load(std::memory_order_relaxed)) {
+        if (used_.compare_exchange_weak(used, used + 1, std::memory_order_relaxed)) {
+          generation_.fetch_add(1, std::memory_order_relaxed);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // 不检查上限：分片以旧换新时先占住新结点的单位，再淘汰旧结点归还，期间其他分片申请不到这个单位
+    void forceAcquire() {
+      used_.fetch_add(1, std::memory_order_relaxed);
+      generation_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release(size_t count = 1) {
+      used_.fetch_sub(count, std::memory_order_relaxed);
+    }
+
+    // 采样分片，从淘汰分数最高的分片淘汰一个结点；采样不到(或期间被并发清空)时从随机位置起扫描全部分片
+    // 所有分片都为空时返回false
+    bool reclaim() {
+      if (shards_.empty()) {
+        return false;
+      }
+      Shard* victim = nullptr;
+      uint64_t best = 0;
+      for (size_t i = 0; i < kSamples; ++i) {
+        Shard* shard = shards_[nextRandom() % shards_.size()];
+        uint64_t score = 0;
+        if (shard->evictionScore(score) && (!victim || score > best)) {
+          victim = shard;
+          best = score;
+        }
+      }
+      if (victim && victim->evictForBudget()) {
+        return true;
+      }
+      size_t start = nextRandom() % shards_.size();
+      for (size_t i = 0; i < shards_.size(); ++i) {
+        if (shards_[(start + i) % shards_.size()]->evictForBudget()) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void setCapacity(size_t capacity) { capacity_.store(capacity, std::memory_order_relaxed); }
+
+    // 超出上限的单位数
+    size_t excess() const {
+      size_t used = used_.load(std::memory_order_relaxed);
+      size_t capacity = capacity_.load(std::memory_order_relaxed);
+      return used > capacity ? used - capacity : 0;
+    }
+
+    uint32_t now() const { return generation_.load(std::memory_order_relaxed); }
+    size_t used() const { return used_.load(std::memory_order_relaxed); }
+    size_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+  };
+} // namespace MyCache
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "CacheAllocator.h"
+
+namespace MyCache {
+  using SlotIndex = uint32_t;
+  constexpr SlotIndex kNilSlot = UINT32_MAX;
+
+  // 结点的热元数据：链表链接、访问计数、标志位，16字节，一个cache line容纳4个
+  struct SlotMeta {
+    SlotIndex prev = kNilSlot;
+    SlotIndex next = kNilSlot;
+    uint32_t count = 0;   // 访问次数/频次，由各引擎自行解释
+    uint32_t flags = 0;
+  };
+
+  // 冷热分离的结点存储：元数据与key/value负载分放在两组定长块里，按槽位下标一一对应
+  // 链表调整、淘汰扫描、老化都只读写元数据块，不会把负载所在的cache line拉进来
+  // 按块增长：扩容只追加新块，已有结点的元数据与负载不搬动(地址在release之前保持不变)；
+  // 分配优先取编号最小的、仍有空闲槽位的块(块内后进先出)，末尾的块整块空出后归还给分配器(保留一个空块作缓冲，避免在块边界上反复申请释放)
+  template<typename Payload, typename Alloc = DefaultAlloc>
+  class SlotStore {
+  public:
+    static constexpr size_t kChunkShift = 10;
+    static constexpr size_t kChunkSlots = size_t(1) << kChunkShift;  // 每块1024个槽位
+  private:
+    static constexpr size_t kChunkMask = kChunkSlots - 1;
+
+    using MetaAlloc = RebindAlloc<Alloc, SlotMeta>;
+    using PayloadAlloc = RebindAlloc<Alloc, Payload>;
+
+    struct Chunk {
+      SlotMeta* meta;
+      Payload* payload;
+      SlotIndex freeHead;  // 块内空闲槽位经 meta.next 串起来
+      uint32_t used;
+    };
+
+    MetaAlloc metaAlloc_;
+    PayloadAlloc payloadAlloc_;
+    std::vector<Chunk, RebindAlloc<Alloc, Chunk>> chunks_;  // 只存块指针，增长时搬动的是这张小目录
+    size_t firstFree_;  // 可能有空闲槽位的最小块号
+    size_t used_;
+
+    void addChunk() {
+      Chunk chunk;
+      chunk.meta = std::allocator_traits<MetaAlloc>::allocate(metaAlloc_, kChunkSlots);
+      try {
+        chunk.payload = std::allocator_traits<PayloadAlloc>::allocate(payloadAlloc_, kChunkSlots);
+      } catch (...) {
+        std::allocator_traits<MetaAlloc>::deallocate(metaAlloc_, chunk.meta, kChunkSlots);
+        throw;
+      }
+      size_t constructed = 0;
+      try {
+        for (; constructed < kChunkSlots; ++constructed) {
+          ::new (static_cast<void*>(chunk.payload + constructed)) Payload();
+        }
+      } catch (...) {
+        for (size_t i = 0; i < constructed; ++i) {
+          chunk.payload[i].~Payload();
+        }
+        std::allocator_traits<PayloadAlloc>::deallocate(payloadAlloc_, chunk.payload, kChunkSlots);
+        std::allocator_traits<MetaAlloc>::deallocate(metaAlloc_, chunk.meta, kChunkSlots);
+        throw;
+      }
+      // 块内槽位按下标顺序串成空闲链表
+      SlotIndex base = static_cast<SlotIndex>(chunks_.size() << kChunkShift);
+      for (size_t i = 0; i < kChunkSlots; ++i) {
+        ::new (static_cast<void*>(chunk.meta + i)) SlotMeta();
+        chunk.meta[i].next = i + 1 < kChunkSlots ? base + static_cast<SlotIndex>(i + 1) : kNilSlot;
+      }
+      chunk.freeHead = base;
+      chunk.used = 0;
+      try {
+        chunks_.push_back(chunk);
+      } catch (...) {
+        freeChunk(chunk);
+        throw;
+      }
+    }
+
+    void freeChunk(Chunk& chunk) {
+      for (size_t i = 0; i < kChunkSlots; ++i) {
+        chunk.payload[i].~Payload();
+      }
+      std::allocator_traits<PayloadAlloc>::deallocate(payloadAlloc_, chunk.payload, kChunkSlots);
+      std::allocator_traits<MetaAlloc>::deallocate(metaAlloc_, chunk.meta, kChunkSlots);
+    }
+
+    // 末尾连续两个空块时释放最后一块，最终保留一个空块
+    void releaseTrailingChunks() {
+      while (chunks_.size() >= 2 && chunks_.back().used == 0 && chunks_[chunks_.size() - 2].used == 0) {
+        freeChunk(chunks_.back());
+        chunks_.pop_back();
+      }
+      firstFree_ = std::min(firstFree_, chunks_.size());
+    }
+
+  public:
+    explicit SlotStore(const Alloc& alloc = Alloc())
+      : metaAlloc_(alloc), payloadAlloc_(alloc), chunks_(RebindAlloc<Alloc, Chunk>(alloc))
+      , firstFree_(0), used_(0) {}
+
+    SlotStore(const SlotStore&) = delete;
+    SlotStore& operator=(const SlotStore&) = delete;
+
+    ~SlotStore() { clear(); }
+
+    void reserve(size_t n) {
+      while (chunks_.size() * kChunkSlots < n) {
+        addChunk();
+      }
+    }
+
+    // 取一个槽位，元数据已重置；负载保持上次release后的默认值
+    SlotIndex allocate() {
+      size_t c = firstFree_;
+      while (c < chunks_.size() && chunks_[c].freeHead == kNilSlot) {
+        ++c;
+      }
+      if (c == chunks_.size()) {
+        addChunk();
+      }
+      firstFree_ = c;
+      Chunk& chunk = chunks_[c];
+      SlotIndex slot = chunk.freeHead;
+      SlotMeta& m = chunk.meta[slot & kChunkMask];
+      chunk.freeHead = m.next;
+      m = SlotMeta();
+      ++chunk.used;
+      ++used_;
+      return slot;
+    }
+
+    // 归还槽位并清空负载(释放value持有的资源)
+    void release(SlotIndex slot) {
+      size_t c = slot >> kChunkShift;
+      Chunk& chunk = chunks_[c];
+      chunk.payload[slot & kChunkMask] = Payload();
+      SlotMeta& m = chunk.meta[slot & kChunkMask];
+      m = SlotMeta();
+      m.next = chunk.freeHead;
+      chunk.freeHead = slot;
+      --chunk.used;
+      --used_;
+      firstFree_ = std::min(firstFree_, c);
+      if (chunk.used == 0 && c + 1 == chunks_.size()) {
+        releaseTrailingChunks();
+      }
+    }
+
+    SlotMeta& meta(SlotIndex slot) { return chunks_[slot >> kChunkShift].meta[slot & kChunkMask]; }
+    Payload& payload(SlotIndex slot) { return chunks_[slot >> kChunkShift].payload[slot & kChunkMask]; }
+
+    size_t size() const { return used_; }
+
+    // 现有块覆盖的槽位下标上界(含空闲槽位，其元数据count为0)，按下标顺序扫描元数据时使用
+    size_t slotCount() const { return chunks_.size() * kChunkSlots; }
+
+    size_t chunkCount() const { return chunks_.size(); }
+
+    void clear() {
+      for (Chunk& chunk : chunks_) {
+        freeChunk(chunk);
+      }
+      chunks_.clear();
+      firstFree_ = 0;
+      used_ = 0;
+    }
+  };
+
+  // 以槽位下标串起来的双向链表，只持有头尾，链接存放在 SlotStore 的元数据里
+  struct SlotList {
+    SlotIndex head = kNilSlot;
+    SlotIndex tail = kNilSlot;
+    size_t size = 0;
+
+    bool empty() const { return head == kNilSlot; }
+
+    template<typename Store>
+    void pushBack(Store& store, SlotIndex slot) {
+      SlotMeta& m = store.meta(slot);
+      m.prev = tail;
+      m.next = kNilSlot;
+      if (tail != kNilSlot) {
+        store.meta(tail).next = slot;
+      } else {
+        head = slot;
+      }
+      tail = slot;
+      ++size;
+    }
+
+    template<typename Store>
+    void pushFront(Store& store, SlotIndex slot) {
+      SlotMeta& m = store.meta(slot);
+      m.prev = kNilSlot;
+      m.next = head;
+      if (head != kNilSlot) {
+        store.meta(head).prev = slot;
+      } else {
+        tail = slot;
+      }
+      head = slot;
+      ++size;
+    }
+
+    template<typename Store>
+    void remove(Store& store, SlotIndex slot) {
+      SlotMeta& m = store.meta(slot);
+      if (m.prev != kNilSlot) {
+        store.meta(m.prev).next = m.next;
+      } else {
+        head = m.next;
+      }
+      if (m.next != kNilSlot) {
+        store.meta(m.next).prev = m.prev;
+      } else {
+        tail = m.prev;
+      }
+      m.prev = m.next = kNilSlot;
+      --size;
+    }
+  };
+} // namespace MyCache
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace MyCache {
+  // 忙等循环里的处理器提示：降低功耗，并让出超线程的执行资源
+  inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
+
+  // 单核机器上自旋等不到别的线程推进(持有者/生产者要等本线程让出CPU才能运行)，只会白白耗掉时间片
+  inline bool uniprocessor() {
+    static const bool single = std::thread::hardware_concurrency() == 1;
+    return single;
+  }
+
+  // 指数退避：先短暂自旋，逐步拉长，超过上限后改为让出时间片；单核时直接让出
+  class SpinWait {
+  private:
+    static constexpr uint32_t kMaxSpins = 64;
+    uint32_t spins_;
+    uint32_t rounds_;
+
+  public:
+    SpinWait() : spins_(1), rounds_(0) {}
+
+    void wait() {
+      ++rounds_;
+      if (spins_ > kMaxSpins || uniprocessor()) {
+        std::this_thread::yield();
+        return;
+      }
+      for (uint32_t i = 0; i < spins_; ++i) {
+        cpuRelax();
+      }
+      spins_ <<= 1;
+    }
+
+    uint32_t rounds() const { return rounds_; }
+
+    void reset() {
+      spins_ = 1;
+      rounds_ = 0;
+    }
+  };
+} // namespace MyCache
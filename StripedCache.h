@@ -0,0 +1,289 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include "CacheAllocator.h"
+#include "CachePolicy.h"
+#include "LockPolicy.h"
+#include "SlotStore.h"
+
+namespace MyCache {
+  // 锁分段缓存：一个全局哈希索引 + 一个全局条目数组，索引桶按下标映射到几千把1字节的分段锁上
+  // 与 HashLruCaches 相比：竞争被分散到数千把锁，但容量不切分，所有条目共用一个CLOCK淘汰
+  // 近似LRU：命中只置访问位(已置位则不写)；淘汰时各线程按块领取CLOCK扫描区间，互不重叠
+  // 条目所属的桶记在 owner_ 中：淘汰者先读 owner_ 找到分段锁，加锁后复核再摘链，任何时刻最多持有一把分段锁
+  template<typename Key, typename Value, typename Alloc = DefaultAlloc, typename Lock = ByteLock>
+  class StripedCache : public CachePolicy<Key, Value> {
+  public:
+    using allocator_type = Alloc;
+    using lock_type = Lock;
+    static constexpr size_t kDefaultStripes = 4096;
+
+  private:
+    static constexpr uint32_t kFree = UINT32_MAX;  // owner_：条目不在任何桶中
+    static constexpr size_t kSweepChunk = 64;      // 每次领取的CLOCK扫描区间长度
+    static constexpr size_t kTrimPerOp = 4;        // 缩容后每次put顺带淘汰的上限
+
+    struct Entry {
+      Key key{};
+      Value value{};
+      SlotIndex next = kNilSlot;  // 同桶下一条目，受桶的分段锁保护
+    };
+
+    using Owner = std::atomic<uint32_t>;
+    using RefBit = std::atomic<uint8_t>;
+
+    size_t capacity_;             // 条目数组的大小，构造后不变
+    std::atomic<size_t> limit_;   // 在线调整的容量，不超过 capacity_
+    Alloc alloc_;
+    std::vector<Entry, RebindAlloc<Alloc, Entry>> entries_;
+    std::vector<Owner, RebindAlloc<Alloc, Owner>> owner_;       // 条目 -> 所在桶
+    std::vector<RefBit, RebindAlloc<Alloc, RefBit>> referenced_;  // 与条目数据分开，读侧置位不弄脏数据行
+    std::vector<SlotIndex, RebindAlloc<Alloc, SlotIndex>> buckets_;
+    std::vector<Lock, RebindAlloc<Alloc, Lock>> stripes_;
+    size_t bucketMask_;
+    size_t stripeMask_;
+    std::atomic<size_t> fresh_;   // 从未使用过的条目从这里依次领取
+    std::atomic<size_t> hand_;    // CLOCK指针，按块推进
+    std::atomic<size_t> size_;
+    SpinLock freeLock_;           // remove归还的条目
+    std::vector<SlotIndex, RebindAlloc<Alloc, SlotIndex>> free_;
+    std::atomic<size_t> freeCount_;  // free_.size() 的无锁提示，为0时不去抢 freeLock_
+
+    static size_t roundUp(size_t n) {
+      size_t size = 1;
+      while (size < n) {
+        size <<= 1;
+      }
+      return size;
+    }
+
+    size_t bucketOf(const Key& key) const {
+      uint64_t mixed = static_cast<uint64_t>(std::hash<Key>()(key)) * 0x9E3779B97F4A7C15ULL;
+      return (mixed >> 32) & bucketMask_;
+    }
+
+    Lock& stripeOf(size_t bucket) {
+      return stripes_[bucket & stripeMask_];
+    }
+
+    // 持分段锁调用
+    SlotIndex findInBucket(size_t bucket, const Key& key) const {
+      for (SlotIndex slot = buckets_[bucket]; slot != kNilSlot; slot = entries_[slot].next) {
+        if (entries_[slot].key == key) {
+          return slot;
+        }
+      }
+      return kNilSlot;
+    }
+
+    // 持分段锁调用
+    void unlink(size_t bucket, SlotIndex slot) {
+      SlotIndex* link = &buckets_[bucket];
+      while (*link != slot) {
+        link = &entries_[*link].next;
+      }
+      *link = entries_[slot].next;
+      entries_[slot].next = kNilSlot;
+      entries_[slot].value = Value();  // 及早释放value持有的资源
+      owner_[slot].store(kFree, std::memory_order_relaxed);
+      size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void touch(SlotIndex slot) {
+      RefBit& bit = referenced_[slot];
+      if (!bit.load(std::memory_order_relaxed)) {
+        bit.store(1, std::memory_order_relaxed);
+      }
+    }
+
+    void releaseSlot(SlotIndex slot) {
+      std::lock_guard<SpinLock> guard(freeLock_);
+      free_.push_back(slot);
+      freeCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 调用时不持有任何分段锁，淘汰时可以直接阻塞等待目标分段
+    SlotIndex acquireSlot() {
+      if (size_.load(std::memory_order_relaxed) >= limit_.load(std::memory_order_relaxed)) {
+        return evictOne(SIZE_MAX);  // 已到上限(可能低于条目数组大小)：以旧换新，不再领取空闲条目
+      }
+      size_t fresh = fresh_.load(std::memory_order_relaxed);
+      while (fresh < capacity_) {
+        if (fresh_.compare_exchange_weak(fresh, fresh + 1, std::memory_order_relaxed)) {
+          return static_cast<SlotIndex>(fresh);
+        }
+      }
+      if (freeCount_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<SpinLock> guard(freeLock_);
+        if (!free_.empty()) {
+          SlotIndex slot = free_.back();
+          free_.pop_back();
+          freeCount_.fetch_sub(1, std::memory_order_relaxed);
+          return slot;
+        }
+      }
+      return evictOne(SIZE_MAX);
+    }
+
+    // CLOCK：领取一段区间扫描，清掉沿途访问位，摘下第一个未被访问的条目
+    // 最多领取 maxChunks 段，仍未淘汰到(条目都刚被访问或正被他人领走)时返回 kNilSlot
+    SlotIndex evictOne(size_t maxChunks) {
+      for (size_t chunk = 0; chunk < maxChunks; ++chunk) {
+        size_t start = hand_.fetch_add(kSweepChunk, std::memory_order_relaxed);
+        for (size_t i = 0; i < kSweepChunk; ++i) {
+          SlotIndex slot = static_cast<SlotIndex>((start + i) % capacity_);
+          uint32_t bucket = owner_[slot].load(std::memory_order_relaxed);
+          if (bucket == kFree) {
+            continue;  // 其他线程刚领走、尚未挂入的条目
+          }
+          RefBit& bit = referenced_[slot];
+          if (bit.load(std::memory_order_relaxed)) {
+            bit.store(0, std::memory_order_relaxed);
+            continue;
+          }
+          std::lock_guard<Lock> guard(stripeOf(bucket));
+          // 加锁前条目可能已被淘汰、删除或重新挂到别的桶
+          if (owner_[slot].load(std::memory_order_relaxed) != bucket || bit.load(std::memory_order_relaxed)) {
+            continue;
+          }
+          unlink(bucket, slot);
+          return slot;
+        }
+      }
+      return kNilSlot;
+    }
+
+  public:
+    // stripes：分段锁数量，取整为2的幂且不超过桶数
+    explicit StripedCache(size_t capacity, size_t stripes = kDefaultStripes, const Alloc& alloc = Alloc())
+      : capacity_(capacity), limit_(capacity), alloc_(alloc)
+      , entries_(capacity, RebindAlloc<Alloc, Entry>(alloc))
+      , owner_(capacity, RebindAlloc<Alloc, Owner>(alloc))
+      , referenced_(capacity, RebindAlloc<Alloc, RefBit>(alloc))
+      , buckets_(roundUp(capacity > 0 ? capacity : 1), kNilSlot, RebindAlloc<Alloc, SlotIndex>(alloc))
+      , stripes_(std::min(roundUp(stripes > 0 ? stripes : 1), buckets_.size()), RebindAlloc<Alloc, Lock>(alloc))
+      , bucketMask_(buckets_.size() - 1), stripeMask_(stripes_.size() - 1)
+      , fresh_(0), hand_(0), size_(0), free_(RebindAlloc<Alloc, SlotIndex>(alloc)), freeCount_(0) {
+      for (Owner& owner : owner_) {
+        owner.store(kFree, std::memory_order_relaxed);
+      }
+      free_.reserve(capacity);
+    }
+
+    StripedCache(const StripedCache&) = delete;
+    StripedCache& operator=(const StripedCache&) = delete;
+
+    allocator_type get_allocator() const { return alloc_; }
+
+    void put(Key key, Value value) override {
+      if (limit_.load(std::memory_order_relaxed) == 0) {
+        return;
+      }
+      if (size_.load(std::memory_order_relaxed) > limit_.load(std::memory_order_relaxed)) {
+        trim(kTrimPerOp);
+      }
+      size_t bucket = bucketOf(key);
+      {
+        std::lock_guard<Lock> guard(stripeOf(bucket));
+        SlotIndex slot = findInBucket(bucket, key);
+        if (slot != kNilSlot) {
+          entries_[slot].value = value;
+          touch(slot);
+          return;
+        }
+      }
+      // 领取空闲条目(可能要淘汰)时不持有本分段锁，之后重新查找：期间可能有人写入了同一个key
+      SlotIndex slot = acquireSlot();
+      std::lock_guard<Lock> guard(stripeOf(bucket));
+      SlotIndex existing = findInBucket(bucket, key);
+      if (existing != kNilSlot) {
+        entries_[existing].value = value;
+        touch(existing);
+        releaseSlot(slot);
+        return;
+      }
+      Entry& entry = entries_[slot];
+      entry.key = key;
+      entry.value = value;
+      entry.next = buckets_[bucket];
+      buckets_[bucket] = slot;
+      referenced_[slot].store(0, std::memory_order_relaxed);
+      owner_[slot].store(static_cast<uint32_t>(bucket), std::memory_order_relaxed);
+      size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool get(Key key, Value& value) override {
+      size_t bucket = bucketOf(key);
+      std::lock_guard<Lock> guard(stripeOf(bucket));
+      SlotIndex slot = findInBucket(bucket, key);
+      if (slot == kNilSlot) {
+        return false;
+      }
+      touch(slot);
+      value = entries_[slot].value;
+      return true;
+    }
+
+    Value get(Key key) override {
+      Value value{};
+      get(key, value);
+      return value;
+    }
+
+    bool remove(Key key) {
+      size_t bucket = bucketOf(key);
+      SlotIndex slot;
+      {
+        std::lock_guard<Lock> guard(stripeOf(bucket));
+        slot = findInBucket(bucket, key);
+        if (slot == kNilSlot) {
+          return false;
+        }
+        unlink(bucket, slot);
+      }
+      releaseSlot(slot);
+      return true;
+    }
+
+    // 在线调整容量：条目数组在构造时分配，容量不能增长到构造时的大小之外，超出的请求被截断，返回实际生效的容量
+    // 在构造大小以内调大立即生效；缩容超出的条目由后续put或 trim 分批淘汰
+    size_t setCapacity(size_t capacity) {
+      size_t applied = std::min(capacity, capacity_);
+      limit_.store(applied, std::memory_order_relaxed);
+      return applied;
+    }
+
+    // 淘汰至多 maxEvictions 个超出容量的条目，返回实际淘汰数；调用时不得持有分段锁
+    size_t trim(size_t maxEvictions) {
+      size_t sweepChunks = 2 * ((capacity_ + kSweepChunk - 1) / kSweepChunk);  // 约两圈：第一圈可能只清访问位
+      size_t evicted = 0;
+      while (evicted < maxEvictions &&
+             size_.load(std::memory_order_relaxed) > limit_.load(std::memory_order_relaxed)) {
+        SlotIndex slot = evictOne(sweepChunks);
+        if (slot == kNilSlot) {
+          break;
+        }
+        releaseSlot(slot);
+        ++evicted;
+      }
+      return evicted;
+    }
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    size_t capacity() const { return limit_.load(std::memory_order_relaxed); }
+    size_t stripeCount() const { return stripes_.size(); }
+  };
+
+  namespace pmr {
+    template<typename Key, typename Value>
+    using StripedCache = MyCache::StripedCache<Key, Value, PmrAlloc>;
+  }
+} // namespace MyCache
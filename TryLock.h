@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "SpinWait.h"
+
+namespace MyCache {
+  // tryGet 的结果：Contended 表示锁被占用、在预算内没抢到，调用方按未命中处理
+  enum class TryStatus { Hit, Miss, Contended };
+
+  // 抢锁预算：先最多尝试 spins 次(带退避)；timeout 非零时改为在截止时间前持续尝试
+  struct TryBudget {
+    uint32_t spins = 16;
+    std::chrono::nanoseconds timeout{0};
+  };
+
+  // 竞争统计，relaxed计数，只用于观测
+  class ContentionStats {
+  private:
+    std::atomic<uint64_t> attempts_{0};   // tryGet/tryPut 调用次数
+    std::atomic<uint64_t> contended_{0};  // 因竞争放弃的次数
+
+  public:
+    void recordAttempt() { attempts_.fetch_add(1, std::memory_order_relaxed); }
+    void recordContended() { contended_.fetch_add(1, std::memory_order_relaxed); }
+
+    uint64_t attempts() const { return attempts_.load(std::memory_order_relaxed); }
+    uint64_t contended() const { return contended_.load(std::memory_order_relaxed); }
+  };
+
+  namespace detail {
+    // 第round次重试前的退避：pause次数指数增长，封顶64次；从不让出时间片，保证延迟有界
+    inline void tryLockBackoff(uint32_t round) {
+      uint32_t pauses = 1u << (round < 6 ? round : 6);
+      for (uint32_t i = 0; i < pauses; ++i) {
+        cpuRelax();
+      }
+    }
+  } // namespace detail
+
+  // 在预算内尝试锁住lock(std::unique_lock等，需支持try_lock)，失败时计入统计
+  template<typename Lock>
+  bool tryLockWithin(Lock& lock, const TryBudget& budget, ContentionStats& stats) {
+    stats.recordAttempt();
+    if (lock.try_lock()) {
+      return true;
+    }
+    if (budget.timeout.count() > 0) {
+      auto deadline = std::chrono::steady_clock::now() + budget.timeout;
+      uint32_t round = 0;
+      do {
+        detail::tryLockBackoff(round++);
+        if (lock.try_lock()) {
+          return true;
+        }
+      } while (std::chrono::steady_clock::now() < deadline);
+    } else {
+      for (uint32_t round = 0; round < budget.spins; ++round) {
+        detail::tryLockBackoff(round);
+        if (lock.try_lock()) {
+          return true;
+        }
+      }
+    }
+    stats.recordContended();
+    return false;
+  }
+} // namespace MyCache
@@ -1,15 +1,48 @@
 #include <iostream>
+#include <cstring>
 #include <string>
 #include <chrono>
 #include <vector>
 #include <iomanip>
 #include <random>
 #include <algorithm>
+#include <functional>
+#include <array>
+#include <list>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <unordered_map>
+#include <atomic>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include "CachePolicy.h"
+#include "EpochReclaimer.h"
+#include "FlatCombining.h"
+#include "HugePageResource.h"
+#include "KeyIndex.h"
 #include "LruCache.h"
 #include "LfuCache.h"
+#include "LfuSoaCache.h"
+#include "LockPolicy.h"
+#include "Maintenance.h"
+#include "MemoryPressure.h"
+#include "SlotStore.h"
 #include "ArcCache/ArcCache.h"
+#include "CuckooCache.h"
+#include "LockFreeCache.h"
+#include "RcuLruCache.h"
+#include "SeqlockCache.h"
+#include "StripedCache.h"
 
 class Timer {
   public:
@@ -24,6 +57,58 @@ class Timer {
     std::chrono::time_point<std::chrono::high_resolution_clock> start_;
 };
 
+// 用户态dTLB读缺失计数(perf_event)，内核不允许时 available() 为false
+class DtlbMissCounter {
+  public:
+    DtlbMissCounter() : fd_(-1) {
+#if defined(__linux__)
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~DtlbMissCounter() {
+#if defined(__linux__)
+      if (fd_ >= 0) {
+        close(fd_);
+      }
+#endif
+    }
+
+    bool available() const { return fd_ >= 0; }
+
+    void start() {
+#if defined(__linux__)
+      if (fd_ >= 0) {
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+    }
+
+    long long stop() {
+      long long count = 0;
+#if defined(__linux__)
+      if (fd_ >= 0) {
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+          count = 0;
+        }
+      }
+#endif
+      return count;
+    }
+
+  private:
+    int fd_;
+};
+
 void printResult(const std::string& testName, int capacity, const std::vector<int>& hits, const std::vector<int>& get_operations) {
   std::cout << "Test: " << testName << ", Capacity: " << capacity << "\n";
   std::cout << "LRU - Hits: " << std::fixed << std::setprecision(2) << 100 * hits[0] / get_operations[0] << "%\n";
@@ -32,6 +117,16 @@ void printResult(const std::string& testName, int capacity, const std::vector<in
   std::cout << std::endl;
 }
 
+// 断言式检查：不依赖assert，NDEBUG下同样生效；失败时打印位置，main最终以非0退出
+int checkFailures = 0;
+#define CHECK(cond)                                                              \
+  do {                                                                           \
+    if (!(cond)) {                                                               \
+      std::cerr << __FILE__ << ":" << __LINE__ << " 检查失败: " << #cond << "\n"; \
+      ++checkFailures;                                                           \
+    }                                                                            \
+  } while (0)
+
 void testHotDataAccess() {
   std::cout << "\n ===== 测试场景1: 热点数据访问测试 ===== \n";
 
@@ -51,7 +146,7 @@ void testHotDataAccess() {
   std::vector<int> hits(3, 0);
   std::vector<int> get_operations(3, 0);
 
-  for (int i = 0; i < caches.size(); ++i) {
+  for (size_t i = 0; i < caches.size(); ++i) {
     // put操作
     for (int op = 0; op < OPERATIONS; ++op) {
       // 70 热点数据 30 冷数据
@@ -68,9 +163,9 @@ void testHotDataAccess() {
         ++hits[i];
       }
     }
-
-    printResult("热点数据访问测试", CAPACITY, hits, get_operations);
   }
+
+  printResult("热点数据访问测试", CAPACITY, hits, get_operations);
 }
 
 
@@ -90,7 +185,7 @@ void testLoopPattern() {
   std::vector<int> hits(3, 0);
   std::vector<int> get_operations(3, 0);
 
-  for (int i = 0; i < caches.size(); ++i) {
+  for (size_t i = 0; i < caches.size(); ++i) {
     // 填充LOOP_SIZE个数据
     for (int key = 0; key < LOOP_SIZE; ++key) {
       std::string value = "loop" + std::to_string(key);
@@ -116,9 +211,9 @@ void testLoopPattern() {
         ++hits[i];
       }
     }
-
-    printResult("循环扫描测试", CAPACITY, hits, get_operations);
   }
+
+  printResult("循环扫描测试", CAPACITY, hits, get_operations);
 }
 
 
@@ -142,7 +237,7 @@ void testWorkkLoadShift() {
   std::vector<int> hits(3, 0);
   std::vector<int> get_operations(3, 0);
 
-  for (int i = 0; i < caches.size(); ++i) {
+  for (size_t i = 0; i < caches.size(); ++i) {
     // 填充LOOP_SIZE个数据
     for (int key = 0; key < DATA_SIZE; ++key) {
       std::string value = "init" + std::to_string(key);
@@ -153,8 +248,8 @@ void testWorkkLoadShift() {
     for (int op = 0; op < OPERATIONS; ++op) {
       int key;
       // 根据不同阶段选择不同的访问模式
-      if (op < PHASE_LENGTH) {
-        
+      if (op < PHASE_LENGTH) {  // 热点访问
+        key = gen() % HOT_KEYS;
       } else if (op < PHASE_LENGTH * 2) { // 大范围随机访问
         key = gen() % DATA_SIZE;
       } else if (op < PHASE_LENGTH * 3) { // 顺序扫描
@@ -185,17 +280,2684 @@ void testWorkkLoadShift() {
         caches[i]->put(key, value);
       }
     }
+  }
+
+  printResult("工作负载剧烈变化测试", CAPACITY, hits, get_operations);
+
+}
+
+// 大容量下随机查找：默认分配器 vs 大页内存资源，对比耗时与dTLB缺失
+template<typename Cache>
+void runTlbLookups(const std::string& name, Cache& cache, int keys, int operations) {
+  for (int key = 0; key < keys; ++key) {
+    cache.put(key, key);
+  }
+  std::mt19937 gen(42);
+  DtlbMissCounter counter;
+  int found = 0;
+  int value = 0;
+  Timer timer;
+  counter.start();
+  for (int op = 0; op < operations; ++op) {
+    found += cache.get(static_cast<int>(gen() % keys), value);
+  }
+  long long misses = counter.stop();
+  std::cout << name << " - Time: " << std::fixed << std::setprecision(2) << timer.elapsed() / 1000 << "ms, Hits: " << found;
+  if (counter.available()) {
+    std::cout << ", dTLB misses: " << misses;
+  } else {
+    std::cout << ", dTLB misses: 不可用(perf_event受限)";
+  }
+  std::cout << "\n";
+}
+
+void testHugePageTlb() {
+  std::cout << "\n ===== 测试场景4: 大页内存与dTLB缺失 ===== \n";
+  const int KEYS = 2000000;
+  const int OPERATIONS = 2000000;
+
+  {
+    MyCache::LruCache<int, int> lru(KEYS);
+    runTlbLookups("LRU(默认分配器)", lru, KEYS, OPERATIONS);
+  }
+  {
+    MyCache::HugePageOptions options;
+    options.prefaultBytes = size_t(256) << 20;
+    MyCache::HugePageResource hugePages(options);
+    MyCache::pmr::LruCache<int, int> lru(KEYS, &hugePages);
+    runTlbLookups("LRU(大页内存)", lru, KEYS, OPERATIONS);
+    std::cout << "大页映射: " << (hugePages.regions().mappedBytes() >> 20) << "MB (hugetlb "
+              << (hugePages.regions().hugetlbBytes() >> 20) << "MB, THP "
+              << (hugePages.regions().transparentHugePageBytes() >> 20) << "MB)\n";
+  }
+}
+
+// 多线程读多写少：每个线程按固定种子随机访问，统计总吞吐
+template<typename Cache>
+void runConcurrentOps(const std::string& name, Cache& cache, int threads, int keys, int operationsPerThread) {
+  for (int key = 0; key < keys; ++key) {
+    cache.put(key, key);
+  }
+  std::vector<std::thread> workers;
+  Timer timer;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&cache, t, keys, operationsPerThread]() {
+      std::mt19937 gen(t + 1);
+      int value = 0;
+      for (int op = 0; op < operationsPerThread; ++op) {
+        int key = static_cast<int>(gen() % keys);
+        if (op % 10 == 0) {
+          cache.put(key, op);  // 10% 写
+        } else {
+          cache.get(key, value);
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  double seconds = timer.elapsed() / 1e6;
+  std::cout << name << " - 线程: " << threads << ", 吞吐: " << std::fixed << std::setprecision(2)
+            << threads * operationsPerThread / seconds / 1e6 << " Mops/s\n";
+}
+
+void testConcurrentThroughput() {
+  std::cout << "\n ===== 测试场景5: 多线程吞吐 ===== \n";
+  const int KEYS = 100000;
+  const int OPERATIONS = 1000000;
+  int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    MyCache::HashLruCaches<int, int> sharded(KEYS, 16);
+    runConcurrentOps("HashLruCaches(16分片)", sharded, threads, KEYS, OPERATIONS);
+    MyCache::HashLruCaches<int, int> combining(KEYS, 16, MyCache::ShardMode::FlatCombining);
+    runConcurrentOps("HashLruCaches(扁平合并)", combining, threads, KEYS, OPERATIONS);
+    // 属主线程按核数创建，每核一个分片。每次同步get都要切到属主线程执行再切回：
+    // 单核机器上这是两次上下文切换(约2us)，吞吐远低于直接加锁；委托要在多核且分片锁竞争激烈时才有收益
+    MyCache::HashLruCaches<int, int> delegated(KEYS, maxThreads, MyCache::ShardMode::Delegated);
+    runConcurrentOps("HashLruCaches(分片属主线程)", delegated, threads, KEYS, OPERATIONS);
+    MyCache::LockFreeCache<int, int> lockFree(KEYS);
+    runConcurrentOps("LockFreeCache", lockFree, threads, KEYS, OPERATIONS);
+    MyCache::RcuLruCache<int, int> rcu(KEYS);
+    runConcurrentOps("RcuLruCache", rcu, threads, KEYS, OPERATIONS);
+    MyCache::SeqlockCache<int, int> seqlock(KEYS);
+    runConcurrentOps("SeqlockCache", seqlock, threads, KEYS, OPERATIONS);
+    MyCache::CuckooCache<int, int> cuckoo(KEYS);
+    runConcurrentOps("CuckooCache", cuckoo, threads, KEYS, OPERATIONS);
+    MyCache::StripedCache<int, int> striped(KEYS);
+    runConcurrentOps("StripedCache(4096把1字节锁)", striped, threads, KEYS, OPERATIONS);
+  }
+}
+
+// 单线程下各锁策略的固定开销：同一LRU，只换锁类型
+template<typename Lock>
+void runLockCost(const std::string& name, int keys, int operations) {
+  MyCache::LruCache<int, int, MyCache::DefaultAlloc, Lock> cache(keys);
+  for (int key = 0; key < keys; ++key) {
+    cache.put(key, key);
+  }
+  std::mt19937 gen(42);
+  int value = 0;
+  int found = 0;
+  Timer timer;
+  for (int op = 0; op < operations; ++op) {
+    int key = static_cast<int>(gen() % keys);
+    if (op % 10 == 0) {
+      cache.put(key, op);
+    } else {
+      found += cache.get(key, value);
+    }
+  }
+  double elapsed = timer.elapsed();
+  std::cout << name << " - Time: " << std::fixed << std::setprecision(2) << elapsed / 1000 << "ms, "
+            << elapsed * 1000 / operations << "ns/op, Hits: " << found << "\n";
+}
+
+void testLockPolicyCost() {
+  std::cout << "\n ===== 测试场景6: 锁策略开销 ===== \n";
+  const int KEYS = 10000;
+  const int OPERATIONS = 5000000;
+  runLockCost<MyCache::NullLock>("LRU(NullLock)", KEYS, OPERATIONS);
+  runLockCost<MyCache::SpinLock>("LRU(SpinLock)", KEYS, OPERATIONS);
+  runLockCost<std::mutex>("LRU(std::mutex)", KEYS, OPERATIONS);
+  runLockCost<std::shared_mutex>("LRU(std::shared_mutex)", KEYS, OPERATIONS);
+  runLockCost<MyCache::ByteLock>("LRU(ByteLock)", KEYS, OPERATIONS);
+
+  // 有竞争时：所有线程共用一个LRU
+  const int THREADS = std::max(2u, std::thread::hardware_concurrency());
+  const int PER_THREAD = OPERATIONS / THREADS;
+  {
+    MyCache::LruCache<int, int, MyCache::DefaultAlloc, MyCache::SpinLock> cache(KEYS);
+    runConcurrentOps("LRU(SpinLock, 共享)", cache, THREADS, KEYS, PER_THREAD);
+  }
+  {
+    MyCache::LruCache<int, int> cache(KEYS);
+    runConcurrentOps("LRU(std::mutex, 共享)", cache, THREADS, KEYS, PER_THREAD);
+  }
+  {
+    MyCache::LruCache<int, int, MyCache::DefaultAlloc, std::shared_mutex> cache(KEYS);
+    runConcurrentOps("LRU(std::shared_mutex, 共享)", cache, THREADS, KEYS, PER_THREAD);
+  }
+  {
+    MyCache::LruCache<int, int, MyCache::DefaultAlloc, MyCache::ByteLock> cache(KEYS);
+    runConcurrentOps("LRU(ByteLock, 共享)", cache, THREADS, KEYS, PER_THREAD);
+  }
+}
+
+// 命中提升限流：热点读为主的负载下，对比命中率与耗时
+void runPromotionPolicy(const std::string& name, const MyCache::PromotionPolicy& policy, int capacity, int operations) {
+  MyCache::LruCache<int, int> cache(capacity);
+  cache.setPromotionPolicy(policy);
+  std::mt19937 gen(42);
+  int hits = 0;
+  int gets = 0;
+  int value = 0;
+  Timer timer;
+  for (int op = 0; op < operations; ++op) {
+    // 80% 访问 capacity/100 个热点key，其余访问 10 倍容量的冷key
+    int key = op % 10 < 8 ? gen() % (capacity / 100) : capacity + gen() % (capacity * 10);
+    if (cache.get(key, value)) {
+      ++hits;
+    } else {
+      cache.put(key, key);
+    }
+    ++gets;
+  }
+  std::cout << name << " - Time: " << std::fixed << std::setprecision(2) << timer.elapsed() / 1000
+            << "ms, Hits: " << 100.0 * hits / gets << "%\n";
+}
+
+void testPromotionThrottling() {
+  std::cout << "\n ===== 测试场景7: 命中提升限流 ===== \n";
+  const int CAPACITY = 100000;
+  const int OPERATIONS = 5000000;
+  MyCache::PromotionPolicy always;
+  runPromotionPolicy("LRU(每次命中提升)", always, CAPACITY, OPERATIONS);
+  MyCache::PromotionPolicy byAge;
+  byAge.minInterval = CAPACITY / 4;
+  runPromotionPolicy("LRU(间隔 capacity/4 次get)", byAge, CAPACITY, OPERATIONS);
+  MyCache::PromotionPolicy byChance;
+  byChance.probability = 0.25;
+  runPromotionPolicy("LRU(概率 25%)", byChance, CAPACITY, OPERATIONS);
+}
+
+// key分布倾斜到少数分片时，固定分片容量与共享全局预算的命中率对比
+template<typename Cache>
+void runSkewedShards(const std::string& name, Cache& cache, int capacity, int operations) {
+  std::mt19937 gen(42);
+  int hits = 0;
+  int value = 0;
+  for (int op = 0; op < operations; ++op) {
+    // 热点集中在 key%16 < 4 的分片；70% 访问 capacity/2 个热点key，其余为冷key
+    int hot = op % 10 < 7;
+    int base = hot ? static_cast<int>(gen() % (capacity / 2)) : static_cast<int>(gen() % (capacity * 4));
+    int key = hot ? (base / 4) * 16 + base % 4 : capacity * 64 + base;
+    if (cache.get(key, value)) {
+      ++hits;
+    } else {
+      cache.put(key, key);
+    }
+  }
+  std::cout << name << " - Hits: " << std::fixed << std::setprecision(2) << 100.0 * hits / operations << "%\n";
+}
+
+void testSharedShardBudget() {
+  std::cout << "\n ===== 测试场景8: 分片共享容量预算 ===== \n";
+  const int CAPACITY = 20000;
+  const int OPERATIONS = 2000000;
+  {
+    MyCache::LruCache<int, int> lru(CAPACITY);
+    runSkewedShards("LRU(不分片)", lru, CAPACITY, OPERATIONS);
+  }
+  {
+    MyCache::HashLruCaches<int, int> fixed(CAPACITY, 16);
+    runSkewedShards("HashLruCaches(16分片, 固定容量)", fixed, CAPACITY, OPERATIONS);
+  }
+  {
+    MyCache::HashLruCaches<int, int> shared(CAPACITY, 16, MyCache::ShardMode::Locked, MyCache::ShardCapacity::Shared);
+    runSkewedShards("HashLruCaches(16分片, 共享预算)", shared, CAPACITY, OPERATIONS);
+  }
+  {
+    MyCache::LfuCache<int, int> lfu(CAPACITY);
+    runSkewedShards("LFU(不分片)", lfu, CAPACITY, OPERATIONS);
+  }
+  {
+    MyCache::HashLfuCache<int, int> fixed(CAPACITY, 16);
+    runSkewedShards("HashLfuCache(16分片, 固定容量)", fixed, CAPACITY, OPERATIONS);
+  }
+  {
+    MyCache::HashLfuCache<int, int> shared(CAPACITY, 16, MyCache::ShardCapacity::Shared);
+    runSkewedShards("HashLfuCache(16分片, 共享预算)", shared, CAPACITY, OPERATIONS);
+  }
+}
+
+// 所有线程反复读同一个key：对比只靠分片锁与开启热点key复制
+template<typename Cache>
+void runSingleHotKey(const std::string& name, Cache& cache, int threads, int operationsPerThread) {
+  cache.put(42, 42);
+  std::vector<std::thread> workers;
+  Timer timer;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&cache, operationsPerThread]() {
+      int value = 0;
+      for (int op = 0; op < operationsPerThread; ++op) {
+        if (op % 1000 == 0) {
+          cache.put(42, op);  // 偶尔写入，副本随之更新
+        } else {
+          cache.get(42, value);
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  double seconds = timer.elapsed() / 1e6;
+  std::cout << name << " - 线程: " << threads << ", 吞吐: " << std::fixed << std::setprecision(2)
+            << threads * operationsPerThread / seconds / 1e6 << " Mops/s\n";
+}
+
+void testHotKeyReplication() {
+  std::cout << "\n ===== 测试场景9: 单个热点key ===== \n";
+  const int OPERATIONS = 2000000;
+  int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    MyCache::HashLruCaches<int, int> plain(10000, 16);
+    runSingleHotKey("HashLruCaches(仅分片锁)", plain, threads, OPERATIONS);
+    MyCache::HashLruCaches<int, int> replicated(10000, 16);
+    replicated.enableHotKeys();
+    runSingleHotKey("HashLruCaches(热点复制)", replicated, threads, OPERATIONS);
+  }
+}
+
+// 缩容期间另一个线程持续读取：记录单次get的最大延迟
+// maxEvictionsPerCall 为0表示缩容后一次trim清完超出部分(相当于持锁长循环)，否则由后台按批trim
+void runShrinkLatency(const std::string& name, size_t maxEvictionsPerCall, int fromCapacity, int toCapacity) {
+  MyCache::LruCache<int, int> cache(fromCapacity);
+  for (int i = 0; i < fromCapacity; ++i) {
+    cache.put(i, i);
+  }
+  std::atomic<bool> done{false};
+  double worstMicros = 0;
+  std::thread reader([&cache, &done, &worstMicros, toCapacity]() {
+    int value = 0;
+    for (int i = 0; !done.load(std::memory_order_relaxed); ++i) {
+      auto begin = std::chrono::steady_clock::now();
+      cache.get(i % toCapacity, value);
+      std::chrono::duration<double, std::micro> spent = std::chrono::steady_clock::now() - begin;
+      worstMicros = std::max(worstMicros, spent.count());
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  Timer timer;
+  cache.setCapacity(toCapacity);
+  if (maxEvictionsPerCall == 0) {
+    cache.trim(static_cast<size_t>(fromCapacity));
+  } else {
+    while (cache.trim(maxEvictionsPerCall) > 0) {
+      std::this_thread::yield();
+    }
+  }
+  double seconds = timer.elapsed() / 1e6;
+  done = true;
+  reader.join();
+  std::cout << name << " - 缩容耗时: " << std::fixed << std::setprecision(2) << seconds * 1e3
+            << " ms, 读取最大延迟: " << worstMicros << " us\n";
+}
+
+void testOnlineShrink() {
+  std::cout << "\n ===== 测试场景10: 在线缩容 ===== \n";
+  const int FROM = 1000000;
+  const int TO = 10000;
+  runShrinkLatency("LruCache(一次清完)", 0, FROM, TO);
+  runShrinkLatency("LruCache(每批64个)", 64, FROM, TO);
+}
+
+// 缩容与批量淘汰：缩容后第一次写入只淘汰按容量算出的一批(外加 trimInline 的几个)，
+// 超出的部分仍按 kTrimPerOp/trim 分批淘汰，不会在一次插入里持锁清完
+void checkLowWatermarkAfterShrink() {
+  const int FROM = 200000;
+  const int TO = 1000;
+  MyCache::LruCache<int, int> cache(FROM);
+  cache.setLowWatermark(0.9);
+  long long evicted = 0;
+  cache.setEvictionListener([&evicted](const int&, const int&) { ++evicted; });
+  for (int i = 0; i < FROM; ++i) {
+    cache.put(i, i);
+  }
+  CHECK(evicted == 0);
+  cache.setCapacity(TO);
+  cache.put(FROM, FROM);
+  CHECK(evicted > 0);
+  CHECK(evicted <= TO / 10 + 4);  // 一批(容量的10%)加上 trimInline 的上限
+  while (cache.trim(1024) > 0) {}
+  CHECK(evicted == FROM + 1 - TO);
+  // 回到容量以内后，写满时照常按批淘汰
+  long long before = evicted;
+  cache.put(FROM + 1, 0);
+  CHECK(evicted - before == TO / 10);
+}
+
+// 在线调整分片数：读线程持续按热点集读取，另一线程reshard后按批迁移，对比迁移期间的命中率与耗时
+void runReshard(const std::string& name, int fromSlices, int toSlices, int capacity, int operations) {
+  MyCache::HashLruCaches<int, int> cache(capacity, fromSlices);
+  for (int i = 0; i < capacity; ++i) {
+    cache.put(i, i);
+  }
+  std::atomic<bool> done{false};
+  int hits = 0;
+  double worstMicros = 0;
+  std::thread reader([&]() {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> dist(0, capacity - 1);
+    int value = 0;
+    for (int op = 0; op < operations; ++op) {
+      int key = dist(gen);
+      auto begin = std::chrono::steady_clock::now();
+      if (cache.get(key, value)) {
+        ++hits;
+      }
+      std::chrono::duration<double, std::micro> spent = std::chrono::steady_clock::now() - begin;
+      worstMicros = std::max(worstMicros, spent.count());
+    }
+    done = true;
+  });
+  Timer timer;
+  if (toSlices != fromSlices) {
+    cache.reshard(toSlices);
+    while (!done.load(std::memory_order_relaxed) && cache.migrate(64) > 0) {
+      std::this_thread::yield();
+    }
+  }
+  double migrateMs = timer.elapsed() / 1e3;
+  reader.join();
+  std::cout << name << " - 命中率: " << std::fixed << std::setprecision(2) << (hits * 100.0 / operations)
+            << "%, 迁移耗时: " << migrateMs << " ms, 读取最大延迟: " << worstMicros
+            << " us, 最终分片数: " << cache.sliceCount() << "\n";
+}
+
+void testLiveReshard() {
+  std::cout << "\n ===== 测试场景11: 在线调整分片数 ===== \n";
+  const int CAPACITY = 200000;
+  const int OPERATIONS = 1000000;
+  runReshard("HashLruCaches(4分片, 不调整)", 4, 4, CAPACITY, OPERATIONS);
+  runReshard("HashLruCaches(4->16分片)", 4, 16, CAPACITY, OPERATIONS);
+  runReshard("HashLruCaches(16->4分片)", 16, 4, CAPACITY, OPERATIONS);
+}
+
+// 内存压力：用 FakePressureSource 模拟压力升高再解除，观察各轮的容量比例与实际条目数
+void testMemoryPressure() {
+  std::cout << "\n ===== 测试场景12: 内存压力自动收缩 ===== \n";
+  const int CAPACITY = 100000;
+  MyCache::LruCache<int, int> cache(CAPACITY);
+  for (int i = 0; i < CAPACITY; ++i) {
+    cache.put(i, i);
+  }
+  MyCache::FakePressureSource source;
+  MyCache::PressureOptions options;
+  options.trimPerPoll = 20000;
+  MyCache::MemoryPressureMonitor monitor(source, options);
+  monitor.watch(cache);
+  const double pressure[] = {40, 40, 40, 40, 5, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  for (double some : pressure) {
+    source.setPressure(some);
+    double scale = monitor.poll();
+    std::cout << "some avg10=" << std::fixed << std::setprecision(1) << some << "% - 比例: " << std::setprecision(2)
+              << scale << ", 容量: " << cache.capacity() << ", 条目数: " << cache.size() << "\n";
+  }
+}
+
+// 后台维护：同一LFU负载下记录每次操作的延迟，对比淘汰与老化在调用线程上同步完成和交给后台线程
+// 容量较大、平均频次上限较低时，同步老化会让个别请求扫描整张表
+void runMaintenanceLatency(const std::string& name, bool background, int capacity, int operations) {
+  MyCache::LfuCache<int, int> cache(capacity, 4);
+  MyCache::MaintenanceExecutor maintenance(256, std::chrono::milliseconds(1));
+  MyCache::MaintenanceExecutor::Handle handle = 0;
+  if (background) {
+    handle = maintenance.watch(cache);
+    maintenance.start();
+  }
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<> hot(0, capacity / 10);
+  std::uniform_int_distribution<> cold(0, capacity * 4);
+  std::vector<double> latencies;
+  latencies.reserve(operations);
+  int hits = 0;
+  Timer timer;
+  for (int op = 0; op < operations; ++op) {
+    int key = (op % 10 < 7) ? hot(gen) : cold(gen);
+    int value = 0;
+    auto begin = std::chrono::steady_clock::now();
+    if (cache.get(key, value)) {
+      ++hits;
+    } else {
+      cache.put(key, key);
+    }
+    std::chrono::duration<double, std::micro> spent = std::chrono::steady_clock::now() - begin;
+    latencies.push_back(spent.count());
+  }
+  double seconds = timer.elapsed() / 1e6;
+  if (background) {
+    maintenance.unwatch(handle);
+  }
+  std::sort(latencies.begin(), latencies.end());
+  size_t n = latencies.size();
+  size_t slow = latencies.end() - std::upper_bound(latencies.begin(), latencies.end(), 100.0);
+  std::cout << name << " - 命中率: " << std::fixed << std::setprecision(2) << (hits * 100.0 / operations)
+            << "%, 耗时: " << seconds * 1e3 << " ms, p99: " << latencies[n * 99 / 100]
+            << " us, p99.99: " << latencies[n * 9999 / 10000] << " us, 最大: " << latencies.back()
+            << " us, 超过100us: " << slow << " 次\n";
+}
+
+void testBackgroundMaintenance() {
+  std::cout << "\n ===== 测试场景13: 后台维护 ===== \n";
+  const int CAPACITY = 200000;
+  const int OPERATIONS = 2000000;
+  runMaintenanceLatency("LfuCache(同步维护)", false, CAPACITY, OPERATIONS);
+  runMaintenanceLatency("LfuCache(后台维护)", true, CAPACITY, OPERATIONS);
+}
+
+// 批量淘汰：写满时按容量淘汰一批，对比逐个淘汰的吞吐与命中率。批量时被淘汰的value在锁外析构、回调在锁外按批进行，
+// 缩短的是持锁时间；单线程下没有回调时吞吐与逐个淘汰相当(本机多次运行波动约±20%)，带回调时批量略快
+template<typename Value>
+Value makeBatchValue(int key) {
+  return key;
+}
+
+template<>
+std::string makeBatchValue<std::string>(int key) {
+  return std::string(64, static_cast<char>('a' + key % 26));  // 超出短字符串优化，淘汰时要释放堆内存
+}
+
+template<typename Value>
+void runBatchedEviction(const std::string& name, double lowWatermark, bool listen, int capacity, int operations) {
+  MyCache::LruCache<int, Value> cache(capacity);
+  cache.setLowWatermark(lowWatermark);
+  long long evicted = 0;
+  if (listen) {
+    cache.setEvictionListener([&evicted](const int&, const Value&) { ++evicted; });
+  }
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<> hot(0, capacity / 2);
+  std::uniform_int_distribution<> cold(0, capacity * 4);
+  int hits = 0;
+  Timer timer;
+  for (int op = 0; op < operations; ++op) {
+    int key = (op % 10 < 7) ? hot(gen) : cold(gen);
+    Value value{};
+    if (cache.get(key, value)) {
+      ++hits;
+    } else {
+      cache.put(key, makeBatchValue<Value>(key));
+    }
+  }
+  double seconds = timer.elapsed() / 1e6;
+  std::cout << name << " - 命中率: " << std::fixed << std::setprecision(2) << (hits * 100.0 / operations)
+            << "%, 吞吐: " << operations / seconds / 1e6 << " Mops/s";
+  if (listen) {
+    std::cout << ", 回调: " << evicted << " 次";
+  }
+  std::cout << "\n";
+}
+
+void testBatchedEviction() {
+  std::cout << "\n ===== 测试场景14: 批量淘汰 ===== \n";
+  const int CAPACITY = 100000;
+  const int OPERATIONS = 2000000;
+  runBatchedEviction<int>("LruCache(逐个淘汰)", 1.0, false, CAPACITY, OPERATIONS);
+  runBatchedEviction<int>("LruCache(低水位0.95)", 0.95, false, CAPACITY, OPERATIONS);
+  runBatchedEviction<int>("LruCache(低水位0.9)", 0.9, false, CAPACITY, OPERATIONS);
+  runBatchedEviction<int>("LruCache(逐个淘汰+回调)", 1.0, true, CAPACITY, OPERATIONS);
+  runBatchedEviction<int>("LruCache(低水位0.9+回调)", 0.9, true, CAPACITY, OPERATIONS);
+  runBatchedEviction<std::string>("LruCache<string>(逐个淘汰)", 1.0, false, CAPACITY, OPERATIONS);
+  runBatchedEviction<std::string>("LruCache<string>(低水位0.9)", 0.9, false, CAPACITY, OPERATIONS);
+}
+
+// LfuSoaCache的参考模型：频次桶用链表，老化时立即把桶 f 合并进桶 max(f >> 1, 1)(旧频次从小到大、桶内次序不变)
+// 引擎只减半计数数组、桶留到下次结构操作时才合并，两者的命中与淘汰次序必须一致
+template<typename Key>
+class LfuSoaModel {
+  public:
+    LfuSoaModel(size_t capacity, int maxAvgNum) : capacity_(capacity), maxAvgNum_(maxAvgNum) {}
+
+    bool get(const Key& key, int& value) {
+      auto it = entries_.find(key);
+      if (it == entries_.end()) {
+        return false;
+      }
+      value = it->second.value;
+      touch(key, it->second);
+      return true;
+    }
+
+    void put(const Key& key, int value) {
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        it->second.value = value;
+        touch(key, it->second);
+        return;
+      }
+      if (entries_.size() >= capacity_) {
+        auto bucket = buckets_.begin();
+        Key victim = bucket->second.front();
+        bucket->second.pop_front();
+        if (bucket->second.empty()) {
+          buckets_.erase(bucket);
+        }
+        total_ -= entries_[victim].freq;
+        entries_.erase(victim);
+      }
+      std::list<Key>& bucket = buckets_[1];
+      entries_[key] = Entry{value, 1, bucket.insert(bucket.end(), key)};
+      addFreqNum();
+    }
+
+  private:
+    struct Entry {
+      int value;
+      int freq;
+      typename std::list<Key>::iterator pos;
+    };
+
+    size_t capacity_;
+    uint64_t maxAvgNum_;
+    uint64_t total_ = 0;
+    std::map<int, std::list<Key>> buckets_;  // 频次 -> 按进入该频次的先后排列的key
+    std::unordered_map<Key, Entry> entries_;
+
+    void touch(const Key& key, Entry& entry) {
+      std::list<Key>& from = buckets_[entry.freq];
+      from.erase(entry.pos);
+      if (from.empty()) {
+        buckets_.erase(entry.freq);
+      }
+      entry.freq = std::min(entry.freq + 1, 255);
+      std::list<Key>& to = buckets_[entry.freq];
+      entry.pos = to.insert(to.end(), key);
+      addFreqNum();
+    }
+
+    void addFreqNum() {
+      ++total_;
+      if (!entries_.empty() && total_ / entries_.size() > maxAvgNum_) {
+        std::map<int, std::list<Key>> aged;
+        total_ = 0;
+        for (auto& bucket : buckets_) {
+          int target = std::max(bucket.first >> 1, 1);
+          for (const Key& key : bucket.second) {
+            entries_[key].freq = target;
+            total_ += target;
+          }
+          std::list<Key>& to = aged[target];
+          to.splice(to.end(), bucket.second);  // 迭代器随结点转移，仍然有效
+        }
+        buckets_.swap(aged);
+      }
+    }
+};
+
+template<typename Key, typename MakeKey>
+void checkLfuSoaAgainstModel(size_t capacity, int maxAvgNum, int keys, int hotKeys, MakeKey makeKey) {
+  MyCache::LfuSoaCache<Key, int> cache(capacity, maxAvgNum);
+  LfuSoaModel<Key> model(capacity, maxAvgNum);
+  std::mt19937 gen(7);
+  int mismatches = 0;
+  for (int op = 0; op < 200000; ++op) {
+    Key key = makeKey(op % 10 < 6 ? gen() % hotKeys : gen() % keys);
+    if (gen() % 10 < 6) {
+      int got = -1;
+      int expected = -1;
+      bool hit = cache.get(key, got);
+      if (hit != model.get(key, expected) || (hit && got != expected)) {
+        ++mismatches;
+      }
+    } else {
+      cache.put(key, op);
+      model.put(key, op);
+    }
+  }
+  CHECK(mismatches == 0);
+}
+
+void checkLfuSoaCache() {
+  // 减半：CPU支持AVX2时整块向量处理，尾部与不支持时走标量；分发后的版本与标量版本都与逐个计算的结果及总和对照
+  std::mt19937 gen(3);
+  for (size_t n : {0, 1, 31, 32, 33, 64, 95, 1000}) {
+    std::vector<uint8_t> freqs(n);
+    for (auto& f : freqs) {
+      f = static_cast<uint8_t>(gen() % 4 == 0 ? gen() % 2 : gen() % 256);  // 混入空槽(0)与1
+    }
+    std::vector<uint8_t> expected(freqs);
+    uint64_t expectedTotal = 0;
+    for (auto& f : expected) {
+      f = static_cast<uint8_t>(f == 0 ? 0 : std::max(f >> 1, 1));
+      expectedTotal += f;
+    }
+    std::vector<uint8_t> scalar(freqs);
+    uint64_t total = MyCache::LfuSoaCache<int, int>::halveFreqs(freqs.data(), freqs.size());
+    CHECK(freqs == expected);
+    CHECK(total == expectedTotal);
+    uint64_t scalarTotal = MyCache::LfuSoaCache<int, int>::halveFreqsScalar(scalar.data(), scalar.size());
+    CHECK(scalar == expected);
+    CHECK(scalarTotal == expectedTotal);
+  }
+
+  // 频繁老化(延迟合并的桶次序)、计数饱和(平均值上限很高，热点计数顶到255)、字符串key(按KeyRef淘汰)
+  checkLfuSoaAgainstModel<int>(64, 3, 300, 16, [](int k) { return k; });
+  checkLfuSoaAgainstModel<int>(64, 1000, 300, 4, [](int k) { return k; });
+  checkLfuSoaAgainstModel<std::string>(64, 5, 300, 16, [](int k) { return "key" + std::to_string(k); });
+}
+
+// 结构数组LFU：同一负载下对比逐结点重挂的全表老化与计数数组的整块减半
+void runAgingLatency(const std::string& name, MyCache::CachePolicy<int, int>& cache, int capacity, int operations) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<> hot(0, capacity / 10);
+  std::uniform_int_distribution<> cold(0, capacity * 4);
+  double worst = 0;
+  int slow = 0;
+  Timer timer;
+  for (int op = 0; op < operations; ++op) {
+    int key = (op % 10 < 7) ? hot(gen) : cold(gen);
+    int value = 0;
+    auto begin = std::chrono::steady_clock::now();
+    if (!cache.get(key, value)) {
+      cache.put(key, key);
+    }
+    std::chrono::duration<double, std::micro> spent = std::chrono::steady_clock::now() - begin;
+    worst = std::max(worst, spent.count());
+    slow += spent.count() > 100.0;
+  }
+  std::cout << name << " - 耗时: " << std::fixed << std::setprecision(2) << timer.elapsed() / 1e3
+            << " ms, 最大: " << worst << " us, 超过100us: " << slow << " 次\n";
+}
+
+void testSoaAging() {
+  std::cout << "\n ===== 测试场景15: 结构数组LFU老化 ===== \n";
+  const int CAPACITY = 200000;
+  const int OPERATIONS = 2000000;
+  MyCache::LfuCache<int, int> lfu(CAPACITY, 4);
+  MyCache::LfuSoaCache<int, int> soa(CAPACITY, 4);
+  runAgingLatency("LfuCache", lfu, CAPACITY, OPERATIONS);
+  runAgingLatency("LfuSoaCache", soa, CAPACITY, OPERATIONS);
+
+  // 单次老化本身：满容量的计数数组整块减半
+  std::vector<uint8_t> freqs(CAPACITY, 9);
+  Timer timer;
+  const int ROUNDS = 100;
+  for (int round = 0; round < ROUNDS; ++round) {
+    std::fill(freqs.begin(), freqs.end(), static_cast<uint8_t>(9 + round % 2));
+    MyCache::LfuSoaCache<int, int>::halveFreqs(freqs.data(), freqs.size());
+  }
+  std::cout << "LfuSoaCache 单次老化(" << CAPACITY << "个计数，含重新填充，"
+            << (MyCache::LfuSoaCache<int, int>::vectorizedAging() ? "AVX2" : "标量") << ") - " << std::fixed
+            << std::setprecision(2) << timer.elapsed() / ROUNDS << " us\n";
+  timer = Timer();
+  for (int round = 0; round < ROUNDS; ++round) {
+    std::fill(freqs.begin(), freqs.end(), static_cast<uint8_t>(9 + round % 2));
+    MyCache::LfuSoaCache<int, int>::halveFreqsScalar(freqs.data(), freqs.size());
+  }
+  std::cout << "LfuSoaCache 单次老化(" << CAPACITY << "个计数，含重新填充，标量) - " << std::fixed << std::setprecision(2)
+            << timer.elapsed() / ROUNDS << " us\n";
+}
+
+// 直接寻址索引：与 std::unordered_map 逐操作对照，并检查稀疏key不会按页无限占用内存
+template<typename MakeKey>
+void checkDenseKeyIndexPattern(size_t sizeHint, int operations, MakeKey makeKey, bool expectDense) {
+  MyCache::DenseKeyIndex<long long, int> index;
+  std::unordered_map<long long, int> reference;
+  index.sizeHint(sizeHint);
+  std::mt19937 gen(11);
+  int mismatches = 0;
+  for (int op = 0; op < operations; ++op) {
+    long long key = makeKey(op, gen);
+    int* found = index.find(key);
+    auto it = reference.find(key);
+    if ((found != nullptr) != (it != reference.end()) || (found && *found != it->second)) {
+      ++mismatches;
+    }
+    if (gen() % 4 == 0) {
+      if (index.erase(key) != (reference.erase(key) > 0)) {
+        ++mismatches;
+      }
+    } else {
+      index.insert(key, op);
+      reference[key] = op;
+    }
+  }
+  size_t visited = 0;
+  index.forEach([&visited](int&) { ++visited; });
+  CHECK(mismatches == 0);
+  CHECK(index.size() == reference.size());
+  CHECK(visited == reference.size());
+  CHECK(index.dense() == expectDense);
+  // 直接寻址时页数受密度约束：平均每页不少于 kPageSize / kMaxSlotsPerEntry 个预期条目
+  using Index = MyCache::DenseKeyIndex<long long, int>;
+  size_t expected = std::max(sizeHint, reference.size());
+  CHECK(index.pageCount() <= std::max(Index::kMinPagesForDensityCheck,
+                                      (expected + 1) * Index::kMaxSlotsPerEntry / Index::kPageSize + 1));
+}
+
+void checkDenseKeyIndex() {
+  // 连续key、从首个key往下递减(基址下移)、负数key：保持直接寻址
+  checkDenseKeyIndexPattern(0, 50000, [](int op, std::mt19937&) { return 1000000LL + op; }, true);
+  checkDenseKeyIndexPattern(0, 50000, [](int op, std::mt19937&) { return 1000000LL - op; }, true);
+  checkDenseKeyIndexPattern(0, 50000, [](int op, std::mt19937&) { return -25000LL + op; }, true);
+  // 按容量提示：10万条目、key均匀分布在20万范围内，填充未满时也不误判稀疏
+  checkDenseKeyIndexPattern(100000, 200000, [](int, std::mt19937& gen) { return static_cast<long long>(gen() % 200000); }, true);
+  // 跨度内的稀疏key(每4页一个)与跨度外的大key：转入哈希表，不再每插入一个就分配一页
+  checkDenseKeyIndexPattern(0, 20000, [](int op, std::mt19937&) { return 4096LL * (op % 4000); }, false);
+  checkDenseKeyIndexPattern(1000, 20000, [](int, std::mt19937& gen) { return static_cast<long long>(gen() % (1 << 24)); }, false);
+  checkDenseKeyIndexPattern(0, 20000, [](int op, std::mt19937&) { return (op % 2) ? op * (1LL << 30) : op; }, true);
+
+  // 转入哈希表后引擎照常工作，clear 之后重新按直接寻址开始
+  MyCache::DenseKeyIndex<int, int> index;
+  for (int i = 0; i < 100; ++i) {
+    index.insert(i * 100000, i);
+  }
+  CHECK(!index.dense());
+  CHECK(index.find(4200000) && *index.find(4200000) == 42);
+  index.clear();
+  index.insert(7, 7);
+  CHECK(index.dense() && index.find(7) && index.pageCount() == 1);
+}
+
+// 字符串key驻留：分配区按大小分级复用，erase之后KeyRef指向的块被下一个同级key复用
+void checkInternedKeys() {
+  MyCache::KeyArena<> arena;
+  const MyCache::InternedKey* a = arena.intern("abc", 1);
+  const MyCache::InternedKey* b = arena.intern("0123456789abcdefghij", 2);  // 更大一级
+  CHECK(a != b && a->view() == "abc" && b->hash == 2);
+  arena.release(a);
+  const MyCache::InternedKey* c = arena.intern("xyz", 3);
+  CHECK(c == a && c->view() == "xyz");  // 同级空闲块复用
+  std::string longKey(1000, 'k');
+  const MyCache::InternedKey* d = arena.intern(longKey, 4);  // 超长key单独分配
+  CHECK(d->view() == longKey);
+  arena.release(d);
+  arena.release(b);
+  arena.release(c);
+
+  MyCache::InternedKeyIndex<int> index;
+  MyCache::InternedKeyIndex<int>::KeyRef k1 = index.insert("key-1", 1);
+  CHECK(index.find(k1) && *index.find(k1) == 1);
+  CHECK(index.insert("key-1", 11) == k1);  // 覆盖不重新驻留
+  std::string saved = MyCache::KeyRefTraits<std::string>::toKey(k1);  // 按约定在erase之前拷出
+  CHECK(index.erase(k1));
+  MyCache::InternedKeyIndex<int>::KeyRef k2 = index.insert("key-2", 2);
+  CHECK(k2 == k1 && k2->view() == "key-2");  // 旧KeyRef现在指向别的key，这正是erase后不得再用它的原因
+  CHECK(saved == "key-1" && !index.find(std::string("key-1")));
+  for (int i = 0; i < 1000; ++i) {
+    index.insert("k" + std::to_string(i), i);  // 多次扩容后按引用查找仍走缓存的哈希
+  }
+  CHECK(index.find(k2) && *index.find(k2) == 2);
+
+  // 摘下结点返回的key是拷贝，之后驻留块被复用也不受影响
+  MyCache::LruCache<std::string, int> lru(4);
+  lru.put("old-1", 1);
+  std::string key;
+  int value = 0;
+  CHECK(lru.takeLeastRecent(key, value) && key == "old-1" && value == 1);
+  lru.put("new-1", 2);
+  CHECK(key == "old-1");
+}
+
+// 同一操作序列分别以int key与字符串key运行：淘汰策略与key类型无关，两者的命中序列必须一致
+// (字符串key走驻留索引，结点只保存KeyRef；ARC的结点在主索引与幽灵索引之间转移)
+template<template<typename, typename> class Make>
+void checkSameAcrossKeyTypes(const char* name) {
+  auto intCache = Make<int, int>::make();
+  auto stringCache = Make<std::string, int>::make();
+  std::mt19937 gen(5);
+  int mismatches = 0;
+  for (int op = 0; op < 100000; ++op) {
+    int key = op % 10 < 7 ? gen() % 40 : gen() % 400;
+    std::string stringKey = "key-" + std::to_string(key) + (key % 3 ? "" : std::string(40, 'x'));
+    if (gen() % 2) {
+      intCache->put(key, op);
+      stringCache->put(stringKey, op);
+    } else {
+      int a = -1;
+      int b = -1;
+      if (intCache->get(key, a) != stringCache->get(stringKey, b) || a != b) {
+        ++mismatches;
+      }
+    }
+  }
+  if (mismatches) {
+    std::cerr << name << ": " << mismatches << " 次不一致\n";
+  }
+  CHECK(mismatches == 0);
+}
+
+template<typename Key, typename Value>
+struct MakeLru {
+  static std::unique_ptr<MyCache::LruCache<Key, Value>> make() { return std::make_unique<MyCache::LruCache<Key, Value>>(64); }
+};
+template<typename Key, typename Value>
+struct MakeLfu {
+  static std::unique_ptr<MyCache::LfuCache<Key, Value>> make() { return std::make_unique<MyCache::LfuCache<Key, Value>>(64, 4); }
+};
+template<typename Key, typename Value>
+struct MakeLfuSoa {
+  static std::unique_ptr<MyCache::LfuSoaCache<Key, Value>> make() { return std::make_unique<MyCache::LfuSoaCache<Key, Value>>(64, 4); }
+};
+template<typename Key, typename Value>
+struct MakeArc {
+  static std::unique_ptr<MyCache::ArcCache<Key, Value>> make() { return std::make_unique<MyCache::ArcCache<Key, Value>>(32, 2); }
+};
+
+// 计数的内存资源：记录经由它的分配次数、累计分配字节数与尚未归还的字节数
+class CountingResource : public std::pmr::memory_resource {
+  public:
+    size_t allocations() const { return allocations_.load(); }
+    size_t allocatedBytes() const { return allocatedBytes_.load(); }
+    long long outstanding() const { return outstanding_.load(); }
+
+  private:
+    std::atomic<size_t> allocations_{0};
+    std::atomic<size_t> allocatedBytes_{0};
+    std::atomic<long long> outstanding_{0};
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+      ++allocations_;
+      allocatedBytes_ += bytes;
+      outstanding_ += static_cast<long long>(bytes);
+      return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+      outstanding_ -= static_cast<long long>(bytes);
+      std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+// 分配器传递：缓存的全部内存都经由构造时给的资源，析构后全部归还；
+// 同时把默认资源换成计数资源，内部若有漏传分配器(默认构造的 polymorphic_allocator)会在这里被计到；
+// 直接走全局堆的内部结构计不到，可用 minBytes 要求已知的大块(如请求队列)确实经由给定资源
+template<typename Key, typename Make, typename Use>
+void checkAllocatorPropagation(const char* name, Make make, Use use, size_t minBytes = 0) {
+  CountingResource resource;
+  CountingResource fallback;
+  std::pmr::memory_resource* previous = std::pmr::set_default_resource(&fallback);
+  {
+    auto cache = make(MyCache::PmrAlloc(&resource));
+    for (int i = 0; i < 5000; ++i) {
+      Key key = Key(i % 700);
+      int value = 0;
+      cache->put(key, i);
+      cache->get(Key((i * 7) % 900), value);
+    }
+    use(*cache);
+  }
+  std::pmr::set_default_resource(previous);
+  if (fallback.allocations() != 0 || resource.outstanding() != 0) {
+    std::cerr << name << ": 默认资源分配 " << fallback.allocations() << " 次，未归还 " << resource.outstanding() << " 字节\n";
+  }
+  CHECK(resource.allocations() > 0);
+  CHECK(resource.allocatedBytes() >= minBytes);
+  CHECK(resource.outstanding() == 0);
+  CHECK(fallback.allocations() == 0);
+}
+
+// 字符串key走驻留索引的分配区，int key走直接寻址的页
+struct StringKey {
+  std::string text;
+  explicit StringKey(int i) : text("allocator-key-" + std::to_string(i)) {}
+  operator const std::string&() const { return text; }
+};
+
+void checkAllocators() {
+  auto none = [](auto&) {};
+  checkAllocatorPropagation<int>("LruCache", [](MyCache::PmrAlloc a) {
+    return std::make_unique<MyCache::pmr::LruCache<int, int>>(256, a); }, [](auto& c) { c.setCapacity(64); c.trim(1000); });
+  checkAllocatorPropagation<StringKey>("LruCache<string>", [](MyCache::PmrAlloc a) {
+    return std::make_unique<MyCache::pmr::LruCache<std::string, int>>(256, a); }, none);
+  checkAllocatorPropagation<int>("LfuCache", [](MyCache::PmrAlloc a) {
+    return std::make_unique<MyCache::pmr::LfuCache<int, int>>(256, 4, a); }, none);
+  checkAllocatorPropagation<StringKey>("LfuSoaCache<string>", [](MyCache::PmrAlloc a) {
+    return std::make_unique<MyCache::pmr::LfuSoaCache<std::string, int>>(256, 4, a); }, [](auto& c) { c.setCapacity(64); c.trim(1000); });
+  checkAllocatorPropagation<StringKey>("ArcCache<string>", [](MyCache::PmrAlloc a) {
+    return std::make_unique<MyCache::pmr::ArcCache<std::string, int>>(128, 2, a); }, none);
+  checkAllocatorPropagation<int>("HashLruCaches", [](MyCache::PmrAlloc a) {
+    return std::make_unique<MyCache::pmr::HashLruCaches<int, int>>(256, 4, a); }, [](auto& c) {
+      c.reshard(3);
+      while (c.migrate(64) > 0) {}
+    });
+  // Delegated：每个属主线程的请求队列(4096个按缓存行对齐的单元)同样来自给定资源
+  checkAllocatorPropagation<int>("HashLruCaches(Delegated)", [](MyCache::PmrAlloc a) {
+    return std::make_unique<MyCache::pmr::HashLruCaches<int, int>>(256, 4, MyCache::ShardMode::Delegated, a); }, [](auto& c) {
+      c.reshard(3);
+      while (c.migrate(64) > 0) {}
+    }, 4 * 4096 * 64);
+  checkAllocatorPropagation<StringKey>("HashLfuCache<string>", [](MyCache::PmrAlloc a) {
+    return std::make_unique<MyCache::pmr::HashLfuCache<std::string, int>>(256, 4, 4, a); }, [](auto& c) {
+      c.reshard(2);
+      while (c.migrate(64) > 0) {}
+    });
+  // 经epoch回收的引擎：结点都来自给定资源；LockFreeCache 要求 Alloc 线程安全，回收器的记录、待回收列表也来自给定资源，
+  // Rcu/Cuckoo 允许单线程资源，读者在写锁外登记记录，回收器走全局堆
+  checkAllocatorPropagation<int>("LockFreeCache", [](MyCache::PmrAlloc a) {
+    return std::make_unique<MyCache::pmr::LockFreeCache<int, int>>(256, a); }, none);
+  checkAllocatorPropagation<int>("RcuLruCache", [](MyCache::PmrAlloc a) {
+    return std::make_unique<MyCache::pmr::RcuLruCache<int, int>>(256, a); }, none);
+  checkAllocatorPropagation<int>("CuckooCache", [](MyCache::PmrAlloc a) {
+    return std::make_unique<MyCache::pmr::CuckooCache<int, int>>(256, a); }, none);
+
+  // 回收器本身：每个线程的记录与待回收列表经由给定资源，析构后全部归还
+  CountingResource resource;
+  {
+    MyCache::EpochReclaimer<MyCache::PmrAlloc> reclaimer{MyCache::PmrAlloc(&resource)};
+    auto retireSome = [&reclaimer]() {
+      auto guard = reclaimer.pin();
+      for (int i = 0; i < 100; ++i) {
+        reclaimer.retire(new int(i), [](void*, void* p) { delete static_cast<int*>(p); }, nullptr);
+      }
+    };
+    retireSome();
+    std::thread other(retireSome);
+    other.join();
+    CHECK(resource.allocations() >= 2);  // 至少两条记录
+  }
+  CHECK(resource.outstanding() == 0);
+}
+
+// SlotStore：槽位复用、增长不搬动负载、末尾空块归还
+void checkSlotStore() {
+  using Store = MyCache::SlotStore<std::string, MyCache::PmrAlloc>;
+  const size_t chunk = Store::kChunkSlots;
+  CountingResource resource;
+  {
+    Store store{MyCache::PmrAlloc(&resource)};
+    std::vector<MyCache::SlotIndex> slots;
+    for (size_t i = 0; i < chunk * 3; ++i) {
+      slots.push_back(store.allocate());
+      store.payload(slots.back()) = "payload-" + std::to_string(i);
+    }
+    bool sequential = true;
+    for (size_t i = 0; i < slots.size(); ++i) {
+      sequential = sequential && slots[i] == i;
+    }
+    CHECK(sequential);
+    CHECK(store.chunkCount() == 3);
+
+    // 增长不搬动已有负载
+    std::string* first = &store.payload(0);
+    for (size_t i = 0; i < chunk; ++i) {
+      slots.push_back(store.allocate());
+    }
+    CHECK(&store.payload(0) == first);
+    CHECK(store.payload(0) == "payload-0");
+
+    // 归还的槽位被复用，且负载已清空；下标上界不变
+    size_t slotCount = store.slotCount();
+    store.release(7);
+    store.release(chunk + 3);
+    MyCache::SlotIndex a = store.allocate();
+    MyCache::SlotIndex b = store.allocate();
+    CHECK(a == 7);  // 先取下标最小的块
+    CHECK(b == chunk + 3);
+    CHECK(store.payload(a).empty() && store.payload(b).empty());
+    CHECK(store.meta(a).count == 0 && store.meta(a).next == MyCache::kNilSlot);
+    CHECK(store.slotCount() == slotCount);
+    CHECK(store.size() == chunk * 4);
+
+    // 缩小：末尾的块整块空出后归还，保留一个空块
+    long long before = resource.outstanding();
+    for (size_t i = chunk; i < chunk * 4; ++i) {
+      store.release(static_cast<MyCache::SlotIndex>(i));
+    }
+    CHECK(store.size() == chunk);
+    CHECK(store.chunkCount() == 2);
+    CHECK(resource.outstanding() < before);
+    MyCache::SlotIndex reused = store.allocate();
+    CHECK(reused >= chunk && reused < chunk * 2);  // 保留的空块直接复用
+    CHECK(store.chunkCount() == 2);
+  }
+  CHECK(resource.outstanding() == 0);
+}
+
+// 大页区域：大请求单独映射不占当前区域；小请求换区域时丢弃的尾部计入 abandonedBytes
+void checkHugePageRegion() {
+  MyCache::HugePageOptions options;
+  options.regionBytes = size_t(4) << 20;
+  options.useHugetlb = false;
+  MyCache::HugePageRegionResource resource(options);
+  char* a = static_cast<char*>(resource.allocate(64, 16));
+  char* b = static_cast<char*>(resource.allocate(64, 16));
+  CHECK(b == a + 64);
+  CHECK(resource.mappedBytes() == options.regionBytes);
+
+  const size_t large = size_t(2) << 20;
+  char* big = static_cast<char*>(resource.allocate(large, 64));
+  std::memset(big, 1, large);
+  CHECK(big + large <= a || big >= a + options.regionBytes);
+  CHECK(resource.mappedBytes() == options.regionBytes + (size_t(4) << 20));
+  char* c = static_cast<char*>(resource.allocate(64, 16));
+  CHECK(c == b + 64);  // 当前区域不受大请求影响
+  CHECK(resource.abandonedBytes() == 0);
+
+  const size_t piece = 900 * 1024;
+  size_t used = 3 * 64;
+  while (used + piece <= options.regionBytes) {
+    CHECK(resource.allocate(piece, 16) != nullptr);
+    used += piece;
+  }
+  size_t mapped = resource.mappedBytes();
+  CHECK(resource.allocate(piece, 16) != nullptr);
+  CHECK(resource.mappedBytes() == mapped + options.regionBytes);
+  CHECK(resource.abandonedBytes() == options.regionBytes - used);
+}
+
+// 按时钟计时的提升限流：用 ManualClock 推进时间，结果完全确定
+void checkClockedPromotion() {
+  MyCache::ManualClock clock(1000);
+  MyCache::LruCache<int, int, MyCache::DefaultAlloc, MyCache::NullLock> cache(3);
+  MyCache::PromotionPolicy policy;
+  policy.minInterval = 50;  // 毫秒
+  policy.clock = &clock.cell();
+  cache.setPromotionPolicy(policy);
+  int value = 0;
+
+  cache.put(1, 1);
+  cache.put(2, 2);
+  cache.put(3, 3);
+  clock.advance(49);
+  CHECK(cache.get(1, value));  // 插入后不足50ms：命中但不提升
+  cache.put(4, 4);
+  CHECK(!cache.get(1, value));  // 1仍在最久未访问端，被淘汰
+
+  clock.advance(1);
+  CHECK(cache.get(2, value));  // 满50ms：提升
+  cache.put(5, 5);
+  CHECK(cache.get(2, value));
+  CHECK(!cache.get(3, value));
 
-    printResult("工作负载剧烈变化测试", CAPACITY, hits, get_operations);
+  // 相对时间戳跨越32位回绕时间隔仍按无符号差值计算
+  clock.set(1000 + (uint64_t(1) << 32) - 10);
+  cache.put(6, 6);
+  cache.put(7, 7);
+  cache.put(8, 8);
+  clock.advance(60);
+  CHECK(cache.get(6, value));  // 戳已回绕，间隔60ms：提升
+  cache.put(9, 9);
+  CHECK(cache.get(6, value));
+  CHECK(!cache.get(7, value));
+
+  // 去掉时钟后恢复按get次数计
+  policy.clock = nullptr;
+  policy.minInterval = 0;
+  cache.setPromotionPolicy(policy);
+  CHECK(cache.get(8, value));
+}
+
+// epoch回收：临界区内的读者离开之前，retire的对象不会被释放；synchronize()返回后即已释放
+void checkEpochReclamation() {
+  struct Tracked {
+    std::atomic<int>* freed;
+  };
+  std::atomic<int> freed{0};
+  auto deleter = [](void*, void* p) {
+    Tracked* tracked = static_cast<Tracked*>(p);
+    tracked->freed->fetch_add(1);
+    delete tracked;
+  };
+
+  MyCache::EpochReclaimer<> reclaimer;
+  // 没有读者：少量retire不会立即释放，synchronize之后全部释放
+  for (int i = 0; i < 3; ++i) {
+    reclaimer.retire(new Tracked{&freed}, deleter, nullptr);
   }
+  CHECK(freed.load() == 0);
+  CHECK(reclaimer.pendingRetired() == 3);
+  uint64_t epoch = reclaimer.epoch();
+  reclaimer.synchronize();
+  CHECK(reclaimer.epoch() >= epoch + 2);
+  CHECK(freed.load() == 3);
+  CHECK(reclaimer.pendingRetired() == 0);
 
+  // 另一线程持有临界区：synchronize等到它离开才返回，期间对象不被释放
+  std::atomic<bool> pinned{false};
+  std::atomic<bool> leaving{false};
+  std::atomic<int> freedWhilePinned{-1};
+  std::thread reader([&] {
+    auto guard = reclaimer.pin();
+    pinned.store(true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    freedWhilePinned.store(freed.load());
+    leaving.store(true);
+  });
+  while (!pinned.load()) {
+    std::this_thread::yield();
+  }
+  reclaimer.retire(new Tracked{&freed}, deleter, nullptr);
+  reclaimer.synchronize();
+  CHECK(leaving.load());  // 宽限期覆盖了读者的临界区
+  reader.join();
+  CHECK(freedWhilePinned.load() == 3);
+  CHECK(freed.load() == 4);
+
+  // 超过 kRetireThreshold 的retire在没有读者时自行推进epoch、分批释放
+  for (int i = 0; i < 200; ++i) {
+    reclaimer.retire(new Tracked{&freed}, deleter, nullptr);
+  }
+  CHECK(freed.load() > 4);
+  reclaimer.synchronize();
+  CHECK(freed.load() == 204);
 }
 
-int main() {
+// 扁平合并：合并锁被占住时其他线程的操作挂到发布槽，由持锁者代为执行；线程数超过发布槽时抢不到槽的线程
+// 等锁后自己执行；被合并的操作抛出的异常带回发起线程，合并器之后照常可用。目标不带锁，计数不丢即说明互斥
+void checkFlatCombiner() {
+  struct Target {
+    long long count = 0;
+  };
+  using Combiner = MyCache::FlatCombiner<Target>;
+  Target target;
+  Combiner combiner(target);
+
+  const int threads = static_cast<int>(Combiner::kSlots) + 8;
+  const int opsPerThread = 2000;
+  std::atomic<bool> holding{false};
+  std::atomic<bool> release{false};
+  std::thread blocker([&]() {
+    combiner.execute([&](Target& t) {
+      holding.store(true);
+      while (!release.load()) {
+        std::this_thread::yield();
+      }
+      ++t.count;
+    });
+  });
+  while (!holding.load()) {
+    std::this_thread::yield();
+  }
+
+  std::atomic<int> handedOff{0};  // 由其他线程代为执行的操作数
+  std::atomic<int> caught{0};
+  std::atomic<int> started{0};
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&, i]() {
+      std::thread::id self = std::this_thread::get_id();
+      ++started;
+      for (int op = 0; op < opsPerThread; ++op) {
+        bool shouldThrow = i == 0 && op == 0;  // 恰有一个操作抛出异常(多半在锁被占住时挂上、由他人执行)
+        try {
+          combiner.execute([&](Target& t) {
+            if (std::this_thread::get_id() != self) {
+              ++handedOff;
+            }
+            if (shouldThrow) {
+              throw std::runtime_error("combined op failed");
+            }
+            ++t.count;
+          });
+        } catch (const std::runtime_error&) {
+          ++caught;
+        }
+      }
+    });
+  }
+  while (started.load() < threads) {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));  // 让各线程挂上请求或在槽用尽后等锁
+  release.store(true);
+  blocker.join();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  CHECK(caught.load() == 1);
+  CHECK(handedOff.load() > 0);
+  CHECK(target.count == 1 + static_cast<long long>(threads) * opsPerThread - 1);
+
+  // 无竞争时在调用线程上直接执行，异常同样抛给调用方
+  bool thrown = false;
+  try {
+    combiner.execute([](Target&) { throw std::runtime_error("direct"); });
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  CHECK(thrown);
+  std::thread::id ranOn;
+  combiner.execute([&ranOn](Target& t) {
+    ranOn = std::this_thread::get_id();
+    ++t.count;
+  });
+  CHECK(ranOn == std::this_thread::get_id());
+  CHECK(target.count == static_cast<long long>(threads) * opsPerThread + 1);
+}
+
+// Delegated模式：调容量、提升限流、裁剪、重新分片与读写并发进行，分片只经属主线程访问
+void checkDelegatedAdmin() {
+  MyCache::HashLruCaches<int, int> cache(4000, 4, MyCache::ShardMode::Delegated);
+  std::atomic<bool> stop{false};
+  std::atomic<int> wrong{0};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 2; ++t) {
+    workers.emplace_back([&cache, &stop, &wrong, t]() {
+      std::mt19937 gen(t + 1);
+      int value = 0;
+      for (int op = 0; !stop.load(); ++op) {
+        int key = static_cast<int>(gen() % 8000);
+        if (op % 4 == 0) {
+          cache.put(key, key * 3);
+        } else if (cache.get(key, value) && value != key * 3) {
+          ++wrong;
+        }
+      }
+    });
+  }
+  for (int round = 0; round < 20; ++round) {
+    cache.setCapacity(round % 2 ? 2000 : 4000);
+    MyCache::PromotionPolicy policy;
+    policy.minInterval = round % 3;
+    cache.setPromotionPolicy(policy);
+    cache.trim(100);
+    cache.reshard(round % 2 ? 3 : 4);
+    cache.migrate(500);
+  }
+  stop.store(true);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  CHECK(wrong.load() == 0);
+  while (cache.resharding()) {
+    cache.migrate(1000);
+  }
+  CHECK(cache.sliceCount() == 3);
+  while (cache.trim(1000) > 0) {}
+  int value = 0;
+  int hits = 0;
+  for (int key = 0; key < 8000; ++key) {
+    if (cache.get(key, value)) {
+      ++hits;
+      CHECK(value == key * 3);
+    }
+  }
+  CHECK(hits > 0 && hits <= 2001);  // 3个分片各 ceil(2000/3)
+  cache.put(9001, 7);
+  CHECK(cache.get(9001, value) && value == 7);
+}
+
+// 可从外部占住的锁：同类型的实例共用一个标志，检查里用它模拟"别的线程正持有缓存锁"
+struct HeldLock {
+  static std::atomic<bool>& held() {
+    static std::atomic<bool> flag{false};
+    return flag;
+  }
+
+  bool try_lock() {
+    bool expected = false;
+    return held().compare_exchange_strong(expected, true, std::memory_order_acquire);
+  }
+
+  void lock() {
+    while (!try_lock()) {
+      std::this_thread::yield();
+    }
+  }
+
+  void unlock() { held().store(false, std::memory_order_release); }
+};
+
+// 有界等待：锁被占住时 tryGet 返回Contended且不动value，tryPut 返回false且不写入；
+// 超时预算内锁被释放则照常完成
+template<typename Cache>
+void checkTryOpsUnderHeldLock(const char* name) {
+  Cache cache(16);
+  cache.put(1, 10);
+  int value = -1;
+  HeldLock outside;
+
+  outside.lock();
+  CHECK(cache.tryGet(1, value) == MyCache::TryStatus::Contended);
+  CHECK(value == -1);
+  CHECK(!cache.tryPut(2, 20));
+  MyCache::TryBudget timed;
+  timed.timeout = std::chrono::milliseconds(2);
+  auto start = std::chrono::steady_clock::now();
+  CHECK(cache.tryGet(1, value, timed) == MyCache::TryStatus::Contended);
+  CHECK(std::chrono::steady_clock::now() - start >= timed.timeout);
+  CHECK(cache.contentionStats().attempts() == 3);
+  CHECK(cache.contentionStats().contended() == 3);
+
+  // 持有者在超时预算内释放锁
+  std::thread holder([&outside] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    outside.unlock();
+  });
+  timed.timeout = std::chrono::seconds(10);
+  CHECK(cache.tryGet(1, value, timed) == MyCache::TryStatus::Hit);
+  holder.join();
+  CHECK(value == 10);
+  CHECK(cache.contentionStats().contended() == 3);
+
+  // 锁空闲时：被丢弃的写入确实没有生效
+  CHECK(cache.tryGet(2, value) == MyCache::TryStatus::Miss);
+  CHECK(cache.tryPut(2, 20));
+  CHECK(cache.tryGet(2, value) == MyCache::TryStatus::Hit && value == 20);
+  if (cache.contentionStats().contended() != 3) {
+    std::cerr << name << ": 空闲时仍计入竞争\n";
+  }
+  CHECK(cache.contentionStats().contended() == 3);
+}
+
+// ByteLock：多线程争用两把散列到同一停车位的锁，持锁期间让出CPU迫使其他线程停车；
+// 每次解锁只唤醒一个，计数不丢、没有丢失的唤醒(丢失时这里会卡住)
+void checkByteLock() {
+  MyCache::ByteLock locks[2];  // 相邻两字节落在同一停车位上
+  long long counters[2] = {0, 0};
+  const int kThreads = 4;
+  const int kIterations = 20000;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < kThreads; ++t) {
+    workers.emplace_back([&locks, &counters, t]() {
+      for (int i = 0; i < kIterations; ++i) {
+        int index = (t + i) % 2;
+        std::lock_guard<MyCache::ByteLock> guard(locks[index]);
+        ++counters[index];
+        if (i % 64 == 0) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  CHECK(counters[0] + counters[1] == static_cast<long long>(kThreads) * kIterations);
+  CHECK(locks[0].try_lock());
+  CHECK(locks[1].try_lock());
+  locks[0].unlock();
+  locks[1].unlock();
+}
+
+// ARC：后台维护线程与外部 trim(如内存压力回调)淘汰的同时，前台的幽灵命中在两部分之间挪动容量；
+// 在 -fsanitize=thread 下运行应无数据竞争
+void checkArcConcurrentMaintenance() {
+  MyCache::ArcCache<int, int> cache(256, 2);
+  MyCache::MaintenanceExecutor maintenance(64, std::chrono::milliseconds(1));
+  MyCache::MaintenanceExecutor::Handle handle = maintenance.watch(cache);
+  maintenance.start();
+  std::atomic<bool> stop{false};
+  std::atomic<int> wrong{0};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 2; ++t) {
+    workers.emplace_back([&cache, &wrong, t]() {
+      std::mt19937 gen(t + 7);
+      int value = 0;
+      for (int op = 0; op < 40000; ++op) {
+        int key = static_cast<int>(gen() % 1024);
+        if (op % 3 == 0) {
+          cache.put(key, key + 1);
+        } else if (cache.get(key, value) && value != key + 1) {
+          ++wrong;
+        }
+      }
+    });
+  }
+  std::thread trimmer([&cache, &stop]() {
+    while (!stop.load()) {
+      cache.trim(8);
+      std::this_thread::yield();
+    }
+  });
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  stop.store(true);
+  trimmer.join();
+  maintenance.unwatch(handle);
+  maintenance.stop();
+  CHECK(wrong.load() == 0);
+  int value = 0;
+  cache.put(5000, 1);
+  CHECK(cache.get(5000, value) && value == 1);
+}
+
+// 布谷鸟缓存(单线程)：与"每个key最后写入的值"模型对照；95%占用率下靠BFS搬迁放下全部key；
+// 表满后退化为候选桶内淘汰；CLOCK保留被访问的条目
+void checkCuckooCache() {
+  {
+    // 容量内不淘汰：按目标占用率建表，放满容量必须经搬迁(只用首选桶放不下)
+    const size_t capacity = 4000;
+    MyCache::CuckooCache<int, int> cache(capacity);
+    for (int key = 0; key < static_cast<int>(capacity); ++key) {
+      cache.put(key, key * 7);
+    }
+    CHECK(cache.size() == capacity);
+    CHECK(cache.size() * 100 >= cache.slotCount() * 90);
+    int value = 0;
+    int found = 0;
+    for (int key = 0; key < static_cast<int>(capacity); ++key) {
+      found += cache.get(key, value) && value == key * 7;
+    }
+    CHECK(found == static_cast<int>(capacity));
+  }
+  {
+    // 随机put/get/remove对照模型：命中的值必须是该key最后写入的值，remove之后必须未命中
+    const size_t capacity = 512;
+    MyCache::CuckooCache<int, int> cache(capacity);
+    std::unordered_map<int, int> model;  // key -> 最后写入的值(不跟踪淘汰)
+    std::mt19937 gen(17);
+    int wrong = 0;
+    int value = 0;
+    for (int op = 0; op < 100000; ++op) {
+      int key = static_cast<int>(gen() % 2048);
+      int action = static_cast<int>(gen() % 10);
+      if (action < 4) {
+        cache.put(key, op);
+        model[key] = op;
+        wrong += !(cache.get(key, value) && value == op);  // 刚写入的key一定可读
+      } else if (action < 5) {
+        bool removed = cache.remove(key);
+        wrong += removed && !model.count(key);
+        model.erase(key);
+        wrong += cache.get(key, value);
+      } else if (cache.get(key, value)) {
+        auto it = model.find(key);
+        wrong += it == model.end() || it->second != value;
+      }
+      if (op % 1000 == 0) {
+        CHECK(cache.size() <= capacity);
+      }
+    }
+    CHECK(wrong == 0);
+  }
+  {
+    // 表满：容量调到总路数，此后搬迁常常找不到空位，走候选桶内淘汰；条目数不超过表，刚写入的key可读
+    MyCache::CuckooCache<int, int> cache(1000);
+    cache.setCapacity(SIZE_MAX);
+    CHECK(cache.capacity() == cache.slotCount());
+    int wrong = 0;
+    int value = 0;
+    for (int key = 0; key < static_cast<int>(cache.slotCount()) * 3; ++key) {
+      cache.put(key, -key);
+      wrong += !(cache.get(key, value) && value == -key);
+    }
+    CHECK(wrong == 0);
+    CHECK(cache.size() <= cache.slotCount());
+    CHECK(cache.size() * 100 >= cache.slotCount() * 90);
+  }
+  {
+    // CLOCK：每次插入之间都访问的key不会被淘汰，其余条目按容量淘汰
+    const size_t capacity = 64;
+    MyCache::CuckooCache<int, int> cache(capacity);
+    cache.put(-1, 1);
+    int value = 0;
+    int hotMissed = 0;
+    for (int key = 0; key < 2000; ++key) {
+      hotMissed += !cache.get(-1, value);
+      cache.put(key, key);
+    }
+    CHECK(hotMissed == 0);
+    CHECK(cache.size() == capacity);
+    int cold = 0;
+    for (int key = 0; key < 1000; ++key) {
+      cold += cache.get(key, value);
+    }
+    CHECK(cold == 0);  // 早期写入且未再访问的条目已被淘汰
+  }
+  {
+    // 版本计数器按桶数分条：小表的固定开销只有几个cache line，而不是整套 8192 条
+    CountingResource resource;
+    MyCache::pmr::CuckooCache<int, int> small(16, &resource);
+    CHECK(resource.allocatedBytes() < 4096);
+    int value = -1;
+    CHECK(!small.get(1, value) && value == -1);
+  }
+}
+
+// 布谷鸟缓存(并发)：多个写者在单线程pmr资源上分配结点(分配须在写锁内)，读者与搬迁、替换、淘汰并发，
+// 命中的值必须是为该key写过的值；在 -fsanitize=thread/address 下运行
+void checkCuckooConcurrent() {
+  std::pmr::unsynchronized_pool_resource resource;
+  {
+    MyCache::pmr::CuckooCache<int, int> cache(1024, &resource);
+    const int keys = 4096;
+    std::atomic<bool> stop{false};
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t) {
+      threads.emplace_back([&cache, t]() {
+        std::mt19937 gen(t + 31);
+        for (int op = 0; op < 30000; ++op) {
+          int key = static_cast<int>(gen() % keys);
+          if (op % 8 == 0) {
+            cache.remove(key);
+          } else {
+            cache.put(key, key * keys + op % keys);  // 值的高位编码key
+          }
+        }
+      });
+    }
+    for (int t = 0; t < 2; ++t) {
+      threads.emplace_back([&cache, &stop, &wrong, t]() {
+        std::mt19937 gen(t + 41);
+        while (!stop.load()) {
+          int key = static_cast<int>(gen() % keys);
+          int value = -1;
+          bool hit = cache.get(key, value);
+          if (hit ? value / keys != key : value != -1) {
+            ++wrong;  // 未命中(包括搬迁重试后未命中)时不得改写调用方的value
+          }
+        }
+      });
+    }
+    threads[0].join();
+    threads[1].join();
+    stop.store(true);
+    threads[2].join();
+    threads[3].join();
+    CHECK(wrong.load() == 0);
+    CHECK(cache.size() <= cache.capacity());
+  }
+}
+
+// 锁分段缓存：多个线程并发put/get/remove，同时另一线程反复缩容/扩容与trim，淘汰与删除争抢同一条目；
+// 每个线程独占一组key并维护模型：命中的值必须是自己最后写入的值，删除后必须未命中。
+// 结束后不应有重复或丢失的条目：能查到的key数等于size()，全部删除后容量内的新key全部放得下
+void checkStripedCache() {
+  const size_t capacity = 256;
+  const int threads = 3;
+  const int keysPerThread = 400;
+  MyCache::StripedCache<int, int> cache(capacity, 8);  // 分段少，分段锁竞争多
+  std::atomic<bool> stop{false};
+  std::atomic<int> wrong{0};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&cache, &wrong, t]() {
+      std::mt19937 gen(t + 51);
+      std::vector<int> model(keysPerThread, -1);  // -1：已删除或从未写入
+      int value = 0;
+      for (int op = 0; op < 30000; ++op) {
+        int index = static_cast<int>(gen() % keysPerThread);
+        int key = index * threads + t;
+        int action = static_cast<int>(gen() % 10);
+        if (action < 4) {
+          cache.put(key, op);
+          model[index] = op;
+        } else if (action < 5) {
+          cache.remove(key);
+          model[index] = -1;
+        } else if (cache.get(key, value) && value != model[index]) {
+          ++wrong;  // 淘汰只会造成未命中，不会让旧值或删掉的值重新出现
+        }
+      }
+    });
+  }
+  std::thread resizer([&cache, &stop]() {
+    for (int round = 0; !stop.load(); ++round) {
+      cache.setCapacity(round % 2 ? capacity / 2 : capacity);
+      cache.trim(16);
+      std::this_thread::yield();
+    }
+  });
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  stop.store(true);
+  resizer.join();
+  CHECK(wrong.load() == 0);
+
+  cache.setCapacity(capacity);
+  while (cache.trim(64) > 0) {}
+  CHECK(cache.size() <= capacity);
+  const int universe = keysPerThread * threads;
+  int found = 0;
+  int value = 0;
+  for (int key = 0; key < universe; ++key) {
+    found += cache.get(key, value);
+  }
+  CHECK(found == static_cast<int>(cache.size()));
+  for (int key = 0; key < universe; ++key) {
+    cache.remove(key);
+  }
+  CHECK(cache.size() == 0);
+  for (int key = 0; key < static_cast<int>(capacity); ++key) {
+    cache.put(universe + key, key);
+  }
+  found = 0;
+  for (int key = 0; key < static_cast<int>(capacity); ++key) {
+    found += cache.get(universe + key, value) && value == key;
+  }
+  CHECK(found == static_cast<int>(capacity));  // 没有条目泄漏：不需要淘汰就全部放下
+  CHECK(cache.size() == capacity);
+}
+
+// 内存压力监视器：用 FakePressureSource 逐轮驱动，检查收缩比例、下限、平静滞后、恢复步长、
+// 读不到数据时不调整，以及取消登记恢复基准容量
+void checkMemoryPressureMonitor() {
+  MyCache::FakePressureSource source;
+  MyCache::PressureOptions options;
+  options.shrinkFactor = 0.5;
+  options.minScale = 0.2;
+  options.growStep = 0.1;
+  options.calmPolls = 3;
+  MyCache::MemoryPressureMonitor monitor(source, options);
+  size_t budget = 1000;
+  int trims = 0;
+  monitor.watch(1000, [&budget](size_t b) { budget = b; }, [&trims](size_t) { ++trims; return size_t(0); });
+  MyCache::LruCache<int, int> cache(1000);
+  for (int i = 0; i < 1000; ++i) {
+    cache.put(i, i);
+  }
+  MyCache::MemoryPressureMonitor::Handle cacheHandle = monitor.watch(cache);
+
+  // 平静时不调整
+  source.setPressure(0);
+  monitor.poll();
+  CHECK(budget == 1000 && cache.capacity() == 1000 && trims == 0);
+
+  // 压力尖峰：每轮乘以 shrinkFactor，压到 minScale 为止
+  source.setPressure(40);
+  monitor.poll();
+  CHECK(budget == 500 && cache.capacity() == 500);
+  CHECK(trims == 1);
+  CHECK(cache.size() == 500);  // 同一轮里按 trimPerPoll 淘汰超额
+  monitor.poll();
+  CHECK(budget == 250);
+  monitor.poll();
+  CHECK(budget == 200);  // 0.125 低于下限，取 0.2
+  monitor.poll();
+  CHECK(budget == 200);
+  CHECK(monitor.shrinkCount() == 3);
+
+  // 读不到数据：比例与预算都不变
+  source.setUnavailable();
+  for (int i = 0; i < 5; ++i) {
+    monitor.poll();
+  }
+  CHECK(budget == 200 && monitor.scale() == 0.2);
+
+  // 连续 calmPolls 轮平静才恢复，中间区间会清零计数；每轮最多恢复 growStep
+  source.setPressure(0);
+  monitor.poll();
+  monitor.poll();
+  CHECK(budget == 200);
+  source.setPressure(5);  // 既不收缩也不算平静
+  monitor.poll();
+  source.setPressure(0);
+  monitor.poll();
+  monitor.poll();
+  CHECK(budget == 200);
+  monitor.poll();
+  CHECK(budget == 300);
+  CHECK(monitor.growCount() == 1);
+  monitor.poll();
+  CHECK(budget == 400);
+
+  // 用量比例超线同样收缩
+  source.setUsage(95, 100);
+  monitor.poll();
+  CHECK(budget == 200);
+  source.setUsage(10, 100);
+
+  // 取消登记恢复基准容量，之后不再受监视器影响
+  CHECK(cache.capacity() == 200);
+  CHECK(cache.size() <= 1000);
+  monitor.unwatch(cacheHandle);
+  CHECK(cache.capacity() == 1000);
+  source.setPressure(40);
+  monitor.poll();
+  CHECK(cache.capacity() == 1000);
+  CHECK(budget == 200);  // 已在下限
+}
+
+// 无锁缓存(单线程)：容量8只有一个桶。CLOCK：空位优先，否则淘汰未被引用的那一路；替换保留引用位；
+// 随机读写对照"每个key最后写入的值"模型
+void checkLockFreeCache() {
+  {
+    MyCache::LockFreeCache<int, int> cache(8);
+    CHECK(cache.capacity() == 8);
+    for (int key = 0; key < 8; ++key) {
+      cache.put(key, key * 10);
+    }
+    CHECK(cache.size() == 8);
+    int value = 0;
+    for (int key = 0; key < 7; ++key) {
+      CHECK(cache.get(key, value) && value == key * 10);
+    }
+    cache.put(8, 80);  // 只有7未被引用
+    CHECK(!cache.get(7, value));
+    for (int key = 0; key < 7; ++key) {
+      cache.get(key, value);
+    }
+    cache.put(3, 33);  // 替换：值更新，引用位随之保留
+    cache.put(9, 90);  // 只有8未被引用
+    CHECK(!cache.get(8, value));
+    CHECK(cache.get(3, value) && value == 33);
+    CHECK(cache.get(9, value) && value == 90);
+    CHECK(cache.remove(5) && !cache.get(5, value));
+    CHECK(!cache.remove(5));
+    cache.put(10, 100);  // 有空位时不淘汰
+    int present = 0;
+    for (int key : {0, 1, 2, 3, 4, 6, 9, 10}) {
+      present += cache.get(key, value);
+    }
+    CHECK(present == 8);
+  }
+  {
+    MyCache::LockFreeCache<int, int> cache(256);
+    std::unordered_map<int, int> model;
+    std::mt19937 gen(23);
+    int wrong = 0;
+    int value = 0;
+    for (int op = 0; op < 100000; ++op) {
+      int key = static_cast<int>(gen() % 1024);
+      int action = static_cast<int>(gen() % 10);
+      if (action < 4) {
+        cache.put(key, op);
+        model[key] = op;
+        wrong += !(cache.get(key, value) && value == op);
+      } else if (action < 5) {
+        cache.remove(key);
+        model.erase(key);
+        wrong += cache.get(key, value);
+      } else if (cache.get(key, value)) {
+        auto it = model.find(key);
+        wrong += it == model.end() || it->second != value;
+      }
+    }
+    CHECK(wrong == 0);
+    CHECK(cache.size() <= cache.capacity());
+  }
+}
+
+// 无锁缓存(并发)：读者零拷贝持有value时，写者并发替换、淘汰、删除同一批key；
+// 在 -fsanitize=address 下运行，持有期间结点被释放即报 use-after-free
+void checkLockFreeConcurrent() {
+  MyCache::LockFreeCache<int, std::string> cache(16);
+  const int keys = 64;
+  std::atomic<bool> stop{false};
+  std::atomic<int> wrong{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 2; ++t) {
+    threads.emplace_back([&cache, t]() {
+      std::mt19937 gen(t + 61);
+      for (int op = 0; op < 20000; ++op) {
+        int key = static_cast<int>(gen() % keys);
+        if (op % 10 == 0) {
+          cache.remove(key);
+        } else {
+          cache.put(key, "k" + std::to_string(key) + ":" + std::to_string(op) + std::string(32, '.'));
+        }
+      }
+    });
+  }
+  for (int t = 0; t < 2; ++t) {
+    threads.emplace_back([&cache, &stop, &wrong, t]() {
+      std::mt19937 gen(t + 71);
+      while (!stop.load()) {
+        int key = static_cast<int>(gen() % keys);
+        std::string prefix = "k" + std::to_string(key) + ":";
+        MyCache::PinnedPtr<const std::string> pinned = cache.find(key);
+        if (pinned) {
+          std::this_thread::yield();  // 持有期间让写者替换/淘汰
+          if (pinned->compare(0, prefix.size(), prefix) != 0) {
+            ++wrong;
+          }
+        }
+      }
+    });
+  }
+  threads[0].join();
+  threads[1].join();
+  stop.store(true);
+  threads[2].join();
+  threads[3].join();
+  CHECK(wrong.load() == 0);
+  CHECK(cache.size() <= cache.capacity());
+}
+
+// RcuLruCache 的参照模型：LRU链表 + 读者置位的访问位，淘汰时给置位的结点第二次机会(最多转一圈)
+class RcuLruModel {
+  public:
+    explicit RcuLruModel(size_t capacity) : capacity_(capacity) {}
+
+    void put(int key, int value) {
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        order_.erase(it->second.position);
+        order_.push_back(key);
+        it->second = Entry{value, false, std::prev(order_.end())};  // 替换是新结点，访问位清零
+        return;
+      }
+      if (!entries_.empty() && entries_.size() >= capacity_) {
+        evict();
+      }
+      order_.push_back(key);
+      entries_[key] = Entry{value, false, std::prev(order_.end())};
+    }
+
+    bool get(int key, int& value) {
+      auto it = entries_.find(key);
+      if (it == entries_.end()) {
+        return false;
+      }
+      it->second.referenced = true;
+      value = it->second.value;
+      return true;
+    }
+
+    void remove(int key) {
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        order_.erase(it->second.position);
+        entries_.erase(it);
+      }
+    }
+
+    void setCapacity(size_t capacity) {
+      capacity_ = capacity;
+      while (entries_.size() > capacity_) {
+        evict();
+      }
+    }
+
+  private:
+    struct Entry {
+      int value;
+      bool referenced;
+      std::list<int>::iterator position;
+    };
+
+    void evict() {
+      for (size_t scanned = 0; scanned < entries_.size() && entries_[order_.front()].referenced; ++scanned) {
+        int key = order_.front();
+        order_.pop_front();
+        order_.push_back(key);
+        entries_[key].referenced = false;
+        entries_[key].position = std::prev(order_.end());
+      }
+      entries_.erase(order_.front());
+      order_.pop_front();
+    }
+
+    size_t capacity_;
+    std::list<int> order_;  // 头部最久未访问
+    std::unordered_map<int, Entry> entries_;
+};
+
+// RcuLruCache(单线程)：随机put/get/remove与模型逐步对照，每次读的命中/未命中与值都须一致
+void checkRcuLruCache() {
+  MyCache::RcuLruCache<int, int> cache(32);
+  RcuLruModel model(32);
+  std::mt19937 gen(29);
+  int mismatches = 0;
+  for (int op = 0; op < 100000; ++op) {
+    int key = static_cast<int>(gen() % 96);
+    int action = static_cast<int>(gen() % 10);
+    if (action < 3) {
+      cache.put(key, op);
+      model.put(key, op);
+    } else if (action < 4) {
+      cache.remove(key);
+      model.remove(key);
+    } else {
+      int actual = -1;
+      int expected = -1;
+      bool hit = cache.get(key, actual);
+      mismatches += hit != model.get(key, expected) || (hit && actual != expected);
+    }
+    if (op == 50000) {
+      cache.setCapacity(8);  // 缩容：trim 按同样的第二次机会顺序淘汰
+      while (cache.trim(3) > 0) {}
+      model.setCapacity(8);
+    }
+  }
+  CHECK(mismatches == 0);
+}
+
+// RcuLruCache(并发)：读者零拷贝持有value时，写者并发替换、淘汰、删除并调整容量；
+// 在 -fsanitize=address 下运行，宽限期未过就释放结点即报 use-after-free
+void checkRcuLruConcurrent() {
+  MyCache::RcuLruCache<int, std::string> cache(16);
+  const int keys = 64;
+  std::atomic<bool> stop{false};
+  std::atomic<int> wrong{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 2; ++t) {
+    threads.emplace_back([&cache, t]() {
+      std::mt19937 gen(t + 81);
+      for (int op = 0; op < 20000; ++op) {
+        int key = static_cast<int>(gen() % keys);
+        if (op % 10 == 0) {
+          cache.remove(key);
+        } else if (op % 1000 == 1) {
+          cache.setCapacity(op % 2000 == 1 ? 4 : 16);
+          cache.trim(8);
+        } else {
+          cache.put(key, "k" + std::to_string(key) + ":" + std::to_string(op) + std::string(32, '.'));
+        }
+      }
+    });
+  }
+  for (int t = 0; t < 2; ++t) {
+    threads.emplace_back([&cache, &stop, &wrong, t]() {
+      std::mt19937 gen(t + 91);
+      while (!stop.load()) {
+        int key = static_cast<int>(gen() % keys);
+        std::string prefix = "k" + std::to_string(key) + ":";
+        MyCache::PinnedPtr<const std::string> pinned = cache.find(key);
+        if (pinned) {
+          std::this_thread::yield();  // 持有期间让写者替换/淘汰
+          if (pinned->compare(0, prefix.size(), prefix) != 0) {
+            ++wrong;
+          }
+        }
+      }
+    });
+  }
+  threads[0].join();
+  threads[1].join();
+  stop.store(true);
+  threads[2].join();
+  threads[3].join();
+  CHECK(wrong.load() == 0);
+}
+
+// SeqlockCache(单线程)：容量4只有一个桶，按桶内CLOCK(空槽优先，hand处清访问位)逐步对照模型
+void checkSeqlockCache() {
+  MyCache::SeqlockCache<int, int> cache(4);
+  CHECK(cache.capacity() == 4);
+  struct ModelSlot {
+    int key = 0;
+    int value = 0;
+    bool occupied = false;
+    bool referenced = false;
+  };
+  ModelSlot slots[4];
+  size_t hand = 0;
+  std::mt19937 gen(37);
+  int mismatches = 0;
+  for (int op = 0; op < 100000; ++op) {
+    int key = static_cast<int>(gen() % 12);
+    int action = static_cast<int>(gen() % 10);
+    size_t way = 0;
+    while (way < 4 && !(slots[way].occupied && slots[way].key == key)) {
+      ++way;
+    }
+    if (action < 3) {
+      cache.put(key, op);
+      if (way == 4) {
+        way = 0;
+        while (way < 4 && slots[way].occupied) {
+          ++way;
+        }
+        while (way == 4) {
+          size_t candidate = hand;
+          hand = (hand + 1) % 4;
+          if (!slots[candidate].referenced) {
+            way = candidate;
+          } else {
+            slots[candidate].referenced = false;
+          }
+        }
+        slots[way].referenced = false;
+      }
+      slots[way].key = key;
+      slots[way].value = op;
+      slots[way].occupied = true;
+    } else if (action < 4) {
+      mismatches += cache.remove(key) != (way < 4);
+      if (way < 4) {
+        slots[way].occupied = false;
+      }
+    } else {
+      int value = -1;
+      bool hit = cache.get(key, value);
+      mismatches += hit != (way < 4) || (hit && value != slots[way].value);
+      if (way < 4) {
+        slots[way].referenced = true;
+      }
+    }
+  }
+  CHECK(mismatches == 0);
+}
+
+// SeqlockCache(并发)：value的各字段都由同一个数推出，读者读到的key与value各字段必须彼此一致；
+// 写者并发覆盖、淘汰、删除同一批槽位
+struct SeqlockPayload {
+  static constexpr uint64_t kWords = 256;  // 拷贝窗口足够长，单核上读写也会在中途被抢占而交错
+  uint64_t words[kWords];
+
+  static SeqlockPayload make(int key, uint64_t n) {
+    SeqlockPayload payload;
+    uint64_t base = (static_cast<uint64_t>(key) << 32) | (n & 0xffffffffu);
+    for (uint64_t i = 0; i < kWords; ++i) {
+      payload.words[i] = base * (2 * i + 1) ^ (i << 60);
+    }
+    return payload;
+  }
+
+  bool consistentWith(int key) const {
+    if ((words[0] >> 32) != static_cast<uint64_t>(key)) {
+      return false;
+    }
+    SeqlockPayload expected = make(key, words[0] & 0xffffffffu);
+    return std::memcmp(words, expected.words, sizeof(words)) == 0;
+  }
+};
+
+void checkSeqlockConcurrent() {
+  MyCache::SeqlockCache<int, SeqlockPayload> cache(8);
+  const int keys = 32;
+  std::atomic<bool> stop{false};
+  std::atomic<int> torn{0};
+  std::atomic<long> hits{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 2; ++t) {
+    threads.emplace_back([&cache, t]() {
+      std::mt19937 gen(t + 101);
+      for (int op = 0; op < 50000; ++op) {
+        int key = static_cast<int>(gen() % keys);
+        if (op % 10 == 0) {
+          cache.remove(key);
+        } else {
+          cache.put(key, SeqlockPayload::make(key, static_cast<uint64_t>(op) * 2 + t));
+        }
+      }
+    });
+  }
+  for (int t = 0; t < 2; ++t) {
+    threads.emplace_back([&cache, &stop, &torn, &hits, t]() {
+      std::mt19937 gen(t + 111);
+      SeqlockPayload payload;
+      while (!stop.load()) {
+        int key = static_cast<int>(gen() % keys);
+        if (cache.get(key, payload)) {
+          hits.fetch_add(1, std::memory_order_relaxed);
+          if (!payload.consistentWith(key)) {
+            ++torn;
+          }
+        }
+      }
+    });
+  }
+  threads[0].join();
+  threads[1].join();
+  stop.store(true);
+  threads[2].join();
+  threads[3].join();
+  CHECK(torn.load() == 0);
+  CHECK(hits.load() > 0);
+}
+
+// 组相联缓存的在线容量：桶数在构造时确定，setCapacity 按每桶路数生效并返回截断后的容量，
+// 调大不能超过 slotCount()；缩容后超出的条目由 put(所在桶) 与 trim 淘汰，条目数回到容量以内；
+// 并发读写期间反复缩容/恢复，读到的值始终是该key写过的值
+template<typename Cache>
+void checkWaysLimitOf(const char* name) {
+  {
+    Cache cache(1024);
+    const size_t slots = cache.slotCount();
+    CHECK(cache.capacity() == slots);
+    CHECK(cache.setCapacity(SIZE_MAX) == slots);  // 截断到构造时的表大小
+    CHECK(cache.capacity() == slots);
+    const int keys = static_cast<int>(slots) * 4;
+    for (int key = 0; key < keys; ++key) {
+      cache.put(key, key);
+    }
+    CHECK(cache.size() <= slots);
+
+    size_t applied = cache.setCapacity(300);
+    CHECK(applied >= 300 && applied < slots);  // 按桶数向上取整
+    CHECK(cache.capacity() == applied);
+    for (int key = keys; key < keys + 64; ++key) {
+      cache.put(key, key);  // 缩容后写入：只落在限制路数内，并清理所在桶
+    }
+    size_t evicted = 0;
+    for (size_t batch; (batch = cache.trim(16)) > 0;) {
+      CHECK(batch <= 16);
+      evicted += batch;
+    }
+    CHECK(evicted > 0);
+    if (cache.size() > applied) {
+      std::cerr << name << " 缩容后条目数超出容量: " << cache.size() << " > " << applied << "\n";
+      CHECK(cache.size() <= applied);
+    }
+    int wrong = 0;
+    int value = 0;
+    for (int key = 0; key < keys + 64; ++key) {
+      cache.put(key, -key);
+      wrong += !(cache.get(key, value) && value == -key);  // 刚写入的key可读
+    }
+    CHECK(wrong == 0);
+    CHECK(cache.size() <= applied);
+
+    CHECK(cache.setCapacity(0) == 0);
+    while (cache.trim(64) > 0) {}
+    CHECK(cache.size() == 0);
+    cache.put(1, 1);
+    CHECK(!cache.get(1, value));
+
+    CHECK(cache.setCapacity(slots) == slots);  // 调回构造时的大小：空位可以全部放满
+    for (int key = 0; key < keys; ++key) {
+      cache.put(key, key);
+    }
+    CHECK(cache.size() > applied);
+    CHECK(cache.trim(64) == 0);
+  }
+  {
+    Cache cache(64);
+    const int keys = 256;
+    std::atomic<bool> stop{false};
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t) {
+      threads.emplace_back([&cache, &wrong, t]() {
+        std::mt19937 gen(t + 131);
+        int value = 0;
+        for (int op = 0; op < 40000; ++op) {
+          int key = static_cast<int>(gen() % keys);
+          if (op % 3 == 0) {
+            cache.put(key, key * 7);
+          } else if (cache.get(key, value) && value != key * 7) {
+            ++wrong;
+          }
+        }
+      });
+    }
+    threads.emplace_back([&cache, &stop]() {
+      for (int round = 0; !stop.load(); ++round) {
+        cache.setCapacity(round % 2 ? cache.slotCount() / 4 : cache.slotCount());
+        cache.trim(8);
+        std::this_thread::yield();
+      }
+    });
+    threads[0].join();
+    threads[1].join();
+    stop.store(true);
+    threads[2].join();
+    CHECK(wrong.load() == 0);
+    size_t applied = cache.setCapacity(cache.slotCount() / 4);
+    while (cache.trim(64) > 0) {}
+    CHECK(cache.size() <= applied);
+  }
+}
+
+void checkWaysLimit() {
+  checkWaysLimitOf<MyCache::LockFreeCache<int, int>>("LockFreeCache");
+  checkWaysLimitOf<MyCache::SeqlockCache<int, int>>("SeqlockCache");
+}
+
+// 共享容量预算：各分片条目总数不超过全局预算。结点全部集中在一个分片时，其余(空)分片的写入
+// 在本分片找不到可淘汰的结点，须从其他分片回收预算；并发put/tryPut之后总数同样不超预算
+template<typename Cache>
+void checkSharedBudgetOf(const char* name, std::function<std::unique_ptr<Cache>(size_t)> make) {
+  const size_t budget = 96;
+  const int slices = 16;  // 与构造时的分片数一致；整数key按 key % 16 落在分片上
+  {
+    std::unique_ptr<Cache> cache = make(budget);
+    for (int i = 0; i < static_cast<int>(budget); ++i) {
+      cache->put(i * slices, i);  // 全部落在分片0
+    }
+    CHECK(cache->size() == budget);
+    int missing = 0;
+    int value = 0;
+    for (int key = 1; key < slices; ++key) {
+      cache->put(key, -key);  // 空分片：从分片0回收一个单位
+      missing += !(cache->get(key, value) && value == -key);
+      if (cache->size() > budget) {
+        std::cerr << name << " 共享预算超出: " << cache->size() << "\n";
+        CHECK(cache->size() <= budget);
+      }
+    }
+    CHECK(missing == 0);
+    CHECK(cache->size() == budget);
+  }
+  {
+    std::unique_ptr<Cache> cache = make(budget);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 3; ++t) {
+      workers.emplace_back([&cache, t]() {
+        std::mt19937 gen(t + 121);
+        for (int op = 0; op < 20000; ++op) {
+          // 一半的写入集中在分片0，其余分散
+          int key = op % 2 ? static_cast<int>(gen() % 4000) * slices : static_cast<int>(gen() % 4000);
+          if (op % 5 == 0) {
+            cache->tryPut(key, op);
+          } else {
+            cache->put(key, op);
+          }
+        }
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    CHECK(cache->size() <= budget);
+  }
+}
+
+void checkSharedShardBudget() {
+  checkSharedBudgetOf<MyCache::HashLruCaches<int, int>>("HashLruCaches", [](size_t budget) {
+    return std::make_unique<MyCache::HashLruCaches<int, int>>(budget, 16, MyCache::ShardMode::Locked,
+                                                             MyCache::ShardCapacity::Shared); });
+  checkSharedBudgetOf<MyCache::HashLfuCache<int, int>>("HashLfuCache", [](size_t budget) {
+    return std::make_unique<MyCache::HashLfuCache<int, int>>(budget, 16, MyCache::ShardCapacity::Shared); });
+}
+
+// 热点复制：副本只是分片的缓存。写入后从副本读到的是新值；key被淘汰或缩容删除后副本一并失效，读取不命中；
+// 并发写入、读取(提升)与淘汰交错之后，缩容到0时所有读取都不命中，热点集合随之清空
+void checkHotKeysOf(const char* name, MyCache::ShardMode mode) {
+  MyCache::HotKeyOptions options;
+  options.sampleRate = 2;  // 每个线程隔一次读取采样，另一半读取优先查副本
+  options.threshold = 2;
+  {
+    MyCache::HashLruCaches<int, int> cache(16, 1, mode);
+    cache.enableHotKeys(options);
+    int value = 0;
+    int stale = 0;
+    cache.put(7, 0);
+    for (int i = 0; i < 8; ++i) {
+      cache.get(7, value);  // 被采样的读取累计到阈值后提升为副本
+    }
+    CHECK(cache.hotKeyCount() == 1);
+    for (int round = 1; round <= 50; ++round) {
+      cache.put(7, round);
+      for (int i = 0; i < 4; ++i) {
+        stale += !(cache.get(7, value) && value == round);
+      }
+    }
+    CHECK(stale == 0);
+    for (int key = 100; key < 116; ++key) {
+      cache.put(key, key);  // 把7挤出分片
+    }
+    int evictedHits = 0;
+    for (int i = 0; i < 4; ++i) {
+      evictedHits += cache.get(7, value);
+    }
+    if (evictedHits > 0) {
+      std::cerr << name << " 已淘汰的key仍从副本命中\n";
+    }
+    CHECK(evictedHits == 0);
+    CHECK(cache.hotKeyCount() == 0);
+
+    cache.put(7, 1);
+    for (int i = 0; i < 8; ++i) {
+      cache.get(7, value);
+    }
+    CHECK(cache.hotKeyCount() == 1);
+    cache.put(8, 8);  // 比7更近
+    cache.setCapacity(1);
+    cache.trim(64);
+    evictedHits = 0;
+    for (int i = 0; i < 4; ++i) {
+      evictedHits += cache.get(7, value);
+    }
+    CHECK(evictedHits == 0);
+    CHECK(cache.hotKeyCount() <= 1);
+  }
+  {
+    const int keys = 64;
+    MyCache::HashLruCaches<int, int> cache(32, 4, mode);
+    cache.enableHotKeys(options);
+    std::vector<std::atomic<int>> last(keys);
+    for (auto& entry : last) {
+      entry.store(-1);
+    }
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 2; ++t) {
+      // 写者各管一半的key，写入的值单调递增
+      workers.emplace_back([&cache, &last, t]() {
+        std::mt19937 gen(t + 131);
+        for (int op = 0; op < 20000; ++op) {
+          int key = static_cast<int>(gen() % (keys / 2)) * 2 + t;
+          cache.put(key, op);
+          last[key].store(op, std::memory_order_relaxed);
+        }
+      });
+      // 读者集中读少数几个key，使它们反复被提升
+      workers.emplace_back([&cache, t]() {
+        std::mt19937 gen(t + 137);
+        int value = 0;
+        for (int op = 0; op < 40000; ++op) {
+          cache.get(static_cast<int>(gen() % 8), value);
+        }
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    int mismatches = 0;
+    int value = 0;
+    for (int key = 0; key < keys; ++key) {
+      for (int i = 0; i < 2; ++i) {
+        if (cache.get(key, value) && value != last[key].load()) {
+          ++mismatches;
+        }
+      }
+    }
+    CHECK(mismatches == 0);
+    CHECK(cache.hotKeyCount() <= 32);
+    cache.setCapacity(0);
+    cache.trim(SIZE_MAX);
+    int hits = 0;
+    for (int key = 0; key < keys; ++key) {
+      for (int i = 0; i < 2; ++i) {
+        hits += cache.get(key, value);
+      }
+    }
+    if (hits > 0) {
+      std::cerr << name << " 缩容到0后仍有 " << hits << " 次命中\n";
+    }
+    CHECK(hits == 0);
+    CHECK(cache.hotKeyCount() == 0);
+  }
+}
+
+void checkHotKeyReplication() {
+  checkHotKeysOf("Locked", MyCache::ShardMode::Locked);
+  checkHotKeysOf("FlatCombining", MyCache::ShardMode::FlatCombining);
+}
+
+// 重新分片与读写删并发：每个写线程独占一组key并维护模型，搬移(顺带搬移、getFromDraining、后台migrate)期间
+// 写入的key不丢、读不到旧值，删除后不会被搬移复活(另有删除紧追搬移的场景)；搬完后条目数与模型一致
+// (没有新旧布局各一份的重复)。小容量下并发写入时搬完后总数不超过容量
+template<typename Cache>
+void checkReshardConcurrentOf(const char* name, std::function<std::unique_ptr<Cache>(size_t)> make) {
+  const int writers = 3;
+  const int keysPerWriter = 200;
+  const int sliceCounts[] = {2, 8, 4};  // 都能整除小容量，Fixed模式下各分片容量之和恰为总容量
+  {
+    std::unique_ptr<Cache> cache = make(4096);
+    std::atomic<bool> done{false};
+    std::atomic<int> lost{0};
+    std::atomic<int> stale{0};
+    std::vector<std::vector<int>> models(writers, std::vector<int>(keysPerWriter, -1));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < writers; ++t) {
+      workers.emplace_back([&cache, &models, &lost, &stale, t]() {
+        std::vector<int>& model = models[t];
+        std::mt19937 gen(t + 151);
+        int value = 0;
+        for (int op = 0; op < 6000; ++op) {
+          int index = static_cast<int>(gen() % keysPerWriter);
+          int key = index * writers + t;
+          unsigned dice = gen() % 10;
+          if (dice < 4) {
+            cache->put(key, op);
+            model[index] = op;
+          } else if (dice < 5) {
+            cache->remove(key);
+            model[index] = -1;
+          }
+          bool found = cache->get(key, value);
+          if (model[index] < 0) {
+            stale += found;
+          } else if (!found) {
+            ++lost;
+          } else if (value != model[index]) {
+            ++stale;
+          }
+        }
+      });
+    }
+    std::thread resharder([&cache, &done, &sliceCounts]() {
+      for (int round = 0; !done.load(); ++round) {
+        cache->reshard(sliceCounts[round % 3]);
+        for (int i = 0; i < 20 && !done.load(); ++i) {
+          cache->migrate(8);
+          std::this_thread::yield();
+        }
+      }
+    });
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    done.store(true);
+    resharder.join();
+    while (cache->resharding()) {
+      cache->migrate(SIZE_MAX);
+    }
+    if (lost.load() || stale.load()) {
+      std::cerr << name << " 重新分片期间丢失 " << lost.load() << "，读到旧值或删除后仍命中 " << stale.load() << "\n";
+    }
+    CHECK(lost.load() == 0);
+    CHECK(stale.load() == 0);
+    size_t present = 0;
+    int mismatches = 0;
+    int value = 0;
+    for (int t = 0; t < writers; ++t) {
+      for (int index = 0; index < keysPerWriter; ++index) {
+        int expected = models[t][index];
+        present += expected >= 0;
+        bool found = cache->get(index * writers + t, value);
+        mismatches += expected >= 0 ? !(found && value == expected) : found;
+      }
+    }
+    CHECK(mismatches == 0);
+    CHECK(cache->size() == present);
+  }
+  {
+    // 删除紧追搬移：搬移按写入先后(最久未访问/同频次最早挂入)摘结点，删除也按写入先后进行，
+    // 删除常落在某个结点已摘下、尚未放入新布局的间隙里
+    const int keys = 20000;
+    std::unique_ptr<Cache> cache = make(32768);
+    int resurrected = 0;
+    for (int round = 0; round < 3; ++round) {
+      for (int key = 0; key < keys; ++key) {
+        cache->put(key, key);
+      }
+      cache->reshard(sliceCounts[round % 3]);
+      std::thread migrator([&cache]() {
+        while (cache->resharding()) {
+          cache->migrate(1);
+        }
+      });
+      for (int key = 0; key < keys; ++key) {
+        cache->remove(key);
+      }
+      migrator.join();
+      int value = 0;
+      for (int key = 0; key < keys; ++key) {
+        resurrected += cache->get(key, value);
+      }
+    }
+    if (resurrected > 0) {
+      std::cerr << name << " 删除后被搬移复活 " << resurrected << "\n";
+    }
+    CHECK(resurrected == 0);
+    CHECK(cache->size() == 0);
+  }
+  {
+    const size_t capacity = 64;
+    std::unique_ptr<Cache> cache = make(capacity);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < writers; ++t) {
+      workers.emplace_back([&cache, t]() {
+        std::mt19937 gen(t + 157);
+        int value = 0;
+        for (int op = 0; op < 6000; ++op) {
+          int key = static_cast<int>(gen() % 1000);
+          if (op % 3 == 0) {
+            cache->get(key, value);
+          } else {
+            cache->put(key, op);
+          }
+        }
+      });
+    }
+    std::thread resharder([&cache, &done, &sliceCounts]() {
+      for (int round = 0; !done.load(); ++round) {
+        cache->reshard(sliceCounts[round % 3]);
+        std::this_thread::yield();
+      }
+    });
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    done.store(true);
+    resharder.join();
+    while (cache->resharding()) {
+      cache->migrate(SIZE_MAX);
+    }
+    CHECK(cache->size() <= capacity);
+  }
+}
+
+void checkReshardConcurrent() {
+  using Lru = MyCache::HashLruCaches<int, int>;
+  using Lfu = MyCache::HashLfuCache<int, int>;
+  checkReshardConcurrentOf<Lru>("HashLruCaches(Locked)", [](size_t capacity) {
+    return std::make_unique<Lru>(capacity, 4, MyCache::ShardMode::Locked); });
+  checkReshardConcurrentOf<Lru>("HashLruCaches(FlatCombining)", [](size_t capacity) {
+    return std::make_unique<Lru>(capacity, 4, MyCache::ShardMode::FlatCombining); });
+  checkReshardConcurrentOf<Lru>("HashLruCaches(Delegated)", [](size_t capacity) {
+    return std::make_unique<Lru>(capacity, 4, MyCache::ShardMode::Delegated); });
+  checkReshardConcurrentOf<Lru>("HashLruCaches(Shared)", [](size_t capacity) {
+    return std::make_unique<Lru>(capacity, 4, MyCache::ShardMode::Locked, MyCache::ShardCapacity::Shared); });
+  checkReshardConcurrentOf<Lfu>("HashLfuCache", [](size_t capacity) {
+    return std::make_unique<Lfu>(capacity, 4); });
+  checkReshardConcurrentOf<Lfu>("HashLfuCache(Shared)", [](size_t capacity) {
+    return std::make_unique<Lfu>(capacity, 4, MyCache::ShardCapacity::Shared); });
+}
+
+// 淘汰回调：在锁外执行，收到的是被淘汰结点当时的key/value，按最久未访问优先的顺序
+void checkEvictionListener() {
+  MyCache::LruCache<int, std::string, MyCache::DefaultAlloc, HeldLock> cache(4);
+  cache.setLowWatermark(0.5);  // 写满时一次淘汰2个
+  std::vector<std::pair<int, std::string>> seen;
+  int calledUnderLock = 0;
+  cache.setEvictionListener([&seen, &calledUnderLock](const int& key, const std::string& value) {
+    if (HeldLock::held().load()) {
+      ++calledUnderLock;
+    }
+    seen.emplace_back(key, value);
+  });
+  for (int i = 1; i <= 4; ++i) {
+    cache.put(i, "value-" + std::to_string(i));
+  }
+  std::string value;
+  CHECK(cache.get(1, value));  // 顺序变为 2,3,4,1
+  CHECK(seen.empty());
+  cache.put(5, "value-5");     // 淘汰2,3
+  cache.put(6, "value-6");
+  cache.put(5, "five");        // 覆盖不回调
+  cache.put(7, "value-7");     // 淘汰4,1
+  cache.setCapacity(1);
+  while (cache.trim(10) > 0) {}  // 缩容淘汰同样回调：6,5
+  std::vector<std::pair<int, std::string>> expected = {
+    {2, "value-2"}, {3, "value-3"}, {4, "value-4"}, {1, "value-1"}, {6, "value-6"}, {5, "five"}};
+  CHECK(seen == expected);
+  CHECK(calledUnderLock == 0);
+  CHECK(cache.get(7, value) && value == "value-7");
+}
+
+// 记录持锁期间析构的次数；移走后的空壳析构不计
+struct LockProbe {
+  static int& freedUnderLock() {
+    static int count = 0;
+    return count;
+  }
+
+  bool live = false;
+
+  LockProbe() = default;
+  explicit LockProbe(bool isLive) : live(isLive) {}
+  LockProbe(const LockProbe& other) = default;
+  LockProbe(LockProbe&& other) noexcept : live(other.live) { other.live = false; }
+  LockProbe& operator=(const LockProbe& other) = default;
+  LockProbe& operator=(LockProbe&& other) noexcept {
+    std::swap(live, other.live);
+    return *this;
+  }
+  ~LockProbe() {
+    if (live && HeldLock::held().load()) {
+      ++freedUnderLock();
+    }
+  }
+};
+
+// 没有回调的批量淘汰：被淘汰的value同样在锁外析构
+void checkBatchedEvictionFreesOutsideLock() {
+  LockProbe::freedUnderLock() = 0;
+  {
+    MyCache::LruCache<int, LockProbe, MyCache::DefaultAlloc, HeldLock> cache(8);
+    cache.setLowWatermark(0.5);
+    for (int i = 0; i < 64; ++i) {
+      cache.put(i, LockProbe(true));
+    }
+    CHECK(cache.size() <= 8);
+  }
+  CHECK(LockProbe::freedUnderLock() == 0);
+}
+
+// 正确性检查，在性能测试之前运行
+void runChecks() {
+  checkLfuSoaCache();
+  checkDenseKeyIndex();
+  checkInternedKeys();
+  checkSameAcrossKeyTypes<MakeLru>("LruCache");
+  checkSameAcrossKeyTypes<MakeLfu>("LfuCache");
+  checkSameAcrossKeyTypes<MakeLfuSoa>("LfuSoaCache");
+  checkSameAcrossKeyTypes<MakeArc>("ArcCache");
+  checkAllocators();
+  checkSlotStore();
+  checkHugePageRegion();
+  checkClockedPromotion();
+  checkEpochReclamation();
+  checkFlatCombiner();
+  checkDelegatedAdmin();
+  checkTryOpsUnderHeldLock<MyCache::LruCache<int, int, MyCache::DefaultAlloc, HeldLock>>("LruCache");
+  checkTryOpsUnderHeldLock<MyCache::LfuCache<int, int, MyCache::DefaultAlloc, HeldLock>>("LfuCache");
+  checkTryOpsUnderHeldLock<MyCache::LfuSoaCache<int, int, MyCache::DefaultAlloc, HeldLock>>("LfuSoaCache");
+  checkByteLock();
+  checkArcConcurrentMaintenance();
+  checkLowWatermarkAfterShrink();
+  checkEvictionListener();
+  checkBatchedEvictionFreesOutsideLock();
+  checkCuckooCache();
+  checkCuckooConcurrent();
+  checkStripedCache();
+  checkMemoryPressureMonitor();
+  checkLockFreeCache();
+  checkLockFreeConcurrent();
+  checkRcuLruCache();
+  checkRcuLruConcurrent();
+  checkSeqlockCache();
+  checkSeqlockConcurrent();
+  checkWaysLimit();
+  checkSharedShardBudget();
+  checkHotKeyReplication();
+  checkReshardConcurrent();
+}
+
+int main(int argc, char* argv[]) {
+  // 只跑正确性检查(例如在 -fsanitize=thread/address 下)：testCachePolicies --check
+  runChecks();
+  if (checkFailures > 0) {
+    std::cerr << checkFailures << " 项检查失败\n";
+    return 1;
+  }
+  if (argc > 1 && std::string(argv[1]) == "--check") {
+    std::cout << "检查全部通过\n";
+    return 0;
+  }
+
   // 测试代码
   testHotDataAccess();
   testLoopPattern();
   testWorkkLoadShift();
+  testHugePageTlb();
+  testConcurrentThroughput();
+  testLockPolicyCost();
+  testPromotionThrottling();
+  testSharedShardBudget();
+  testHotKeyReplication();
+  testOnlineShrink();
+  testLiveReshard();
+  testMemoryPressure();
+  testBackgroundMaintenance();
+  testBatchedEviction();
+  testSoaAging();
   
   return 0;
 }
\ No newline at end of file